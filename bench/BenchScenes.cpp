@@ -0,0 +1,292 @@
+//
+//  BenchScenes.cpp
+//
+#include "BenchScenes.h"
+
+const benchScene_t g_benchScenes[] = {
+	{ "spheres",	"number of spheres",	400,	BuildSphereRain },
+	{ "pyramid",	"pyramid height",		10,		BuildBoxPyramid },
+	{ "column",		"column height",		8,		BuildBoxColumn },
+	{ "ragdolls",	"number of ragdolls",	32,		BuildRagdollCrowd },
+	{ "chains",		"number of chains",		10,		BuildHingeChains },
+	{ "diamonds",	"number of diamonds",	100,	BuildDiamondPile },
+	{ "tables",		"number of tables",		36,		BuildTablePile },
+	{ "terrain",	"number of bodies",		100,	BuildTerrainDrop },
+};
+const int g_numBenchScenes = sizeof( g_benchScenes ) / sizeof( benchScene_t );
+
+/*
+====================================================
+MakeBody
+====================================================
+*/
+static Body MakeBody( const Vec3 & pos, Shape * shape, const float invMass, const float elasticity, const float friction ) {
+	Body body;
+	body.m_position = pos;
+	body.m_orientation = Quat( 0, 0, 0, 1 );
+	body.m_linearVelocity.Zero();
+	body.m_angularVelocity.Zero();
+	body.m_invMass = invMass;
+	body.m_elasticity = elasticity;
+	body.m_friction = friction;
+	body.m_shape = shape;
+	return body;
+}
+
+/*
+====================================================
+BuildSphereRain
+Layers of spheres falling into the sand box
+====================================================
+*/
+void BuildSphereRain( Scene & scene, const int numSpheres ) {
+	const int numX = 40;
+	const int numY = 20;
+
+	scene.m_bodies.reserve( numSpheres + 5 );
+	for ( int i = 0; i < numSpheres; i++ ) {
+		const int layer = i / ( numX * numY );
+		const float offset = ( layer & 1 ) ? 1.0f : 0.0f;	// stagger the layers so the spheres don't stack perfectly
+
+		Vec3 pos;
+		pos.x = -40.0f + (float)( i % numX ) * 2.0f + offset;
+		pos.y = -19.0f + (float)( ( i / numX ) % numY ) * 1.9f + offset;
+		pos.z = 10.0f + (float)layer * 2.0f;
+
+		scene.m_bodies.push_back( MakeBody( pos, new ShapeSphere( 0.5f ), 1.0f, 0.5f, 0.5f ) );
+	}
+
+	AddStandardSandBox( scene.m_bodies );
+}
+
+/*
+====================================================
+BuildBoxPyramid
+====================================================
+*/
+void BuildBoxPyramid( Scene & scene, const int height ) {
+	scene.m_bodies.reserve( height * ( height + 1 ) / 2 + 5 );
+
+	const float delta = 0.04f;
+	const float scale = 2.0f + delta;	// g_boxUnit is 2 units wide
+	for ( int z = 0; z < height; z++ ) {
+		const int num = height - z;
+		for ( int x = 0; x < num; x++ ) {
+			Vec3 pos;
+			pos.x = ( (float)x - (float)( num - 1 ) * 0.5f ) * scale;
+			pos.y = 0.0f;
+			pos.z = 1.0f + delta + (float)z * scale;
+
+			scene.m_bodies.push_back( MakeBody( pos, new ShapeBox( g_boxUnit, sizeof( g_boxUnit ) / sizeof( Vec3 ) ), 1.0f, 0.5f, 0.5f ) );
+		}
+	}
+
+	AddStandardSandBox( scene.m_bodies );
+}
+
+/*
+====================================================
+BuildBoxColumn
+Boxes stacked face to face, every contact is a four point manifold
+====================================================
+*/
+void BuildBoxColumn( Scene & scene, const int height ) {
+	scene.m_bodies.reserve( height + 5 );
+
+	const float delta = 0.04f;
+	const float scale = 2.0f + delta;	// g_boxUnit is 2 units wide
+	for ( int z = 0; z < height; z++ ) {
+		const Vec3 pos = Vec3( 0.0f, 0.0f, 1.0f + delta + (float)z * scale );
+		scene.m_bodies.push_back( MakeBody( pos, new ShapeBox( g_boxUnit, sizeof( g_boxUnit ) / sizeof( Vec3 ) ), 1.0f, 0.5f, 0.5f ) );
+	}
+
+	AddStandardSandBox( scene.m_bodies );
+}
+
+/*
+====================================================
+BuildRagdollCrowd
+Rows of the ragdoll from Scene::Initialize, stacked in layers once the floor is full
+====================================================
+*/
+void BuildRagdollCrowd( Scene & scene, const int numRagdolls ) {
+	const int numX = 20;
+	const int numY = 6;
+
+	scene.m_bodies.reserve( numRagdolls * 6 + 5 );
+	for ( int i = 0; i < numRagdolls; i++ ) {
+		const int layer = i / ( numX * numY );
+
+		Vec3 offset;
+		offset.x = -38.0f + (float)( i % numX ) * 4.0f;
+		offset.y = -15.0f + (float)( ( i / numX ) % numY ) * 6.0f;
+		offset.z = (float)layer * 7.0f;
+
+		AddRagdoll( scene.m_bodies, scene.m_constraints, offset );
+	}
+
+	AddStandardSandBox( scene.m_bodies );
+}
+
+/*
+====================================================
+BuildHingeChains
+Horizontal chains of hinged links hanging from static anchors
+====================================================
+*/
+void BuildHingeChains( Scene & scene, const int numChains ) {
+	const int numLinks = 10;
+
+	scene.m_bodies.reserve( numChains * ( numLinks + 1 ) + 5 );
+	for ( int c = 0; c < numChains; c++ ) {
+		const Vec3 anchorPos = Vec3( -20.0f, -20.0f + (float)c * 2.0f, 15.0f );
+		scene.m_bodies.push_back( MakeBody( anchorPos, new ShapeBox( g_boxSmall, sizeof( g_boxSmall ) / sizeof( Vec3 ) ), 0.0f, 0.5f, 0.5f ) );
+
+		for ( int i = 0; i < numLinks; i++ ) {
+			Body * bodyA = &scene.m_bodies[ scene.m_bodies.size() - 1 ];
+
+			const Vec3 pos = bodyA->m_position + Vec3( 0.75f, 0, 0 );
+			scene.m_bodies.push_back( MakeBody( pos, new ShapeBox( g_boxSmall, sizeof( g_boxSmall ) / sizeof( Vec3 ) ), 1.0f, 0.5f, 0.5f ) );
+
+			ConstraintHingeQuat * joint = scene.m_constraints.Create< ConstraintHingeQuat >();
+			joint->m_bodyA = bodyA;
+			joint->m_bodyB = &scene.m_bodies[ scene.m_bodies.size() - 1 ];
+
+			const Vec3 jointWorldSpaceAnchor = ( joint->m_bodyA->m_position + joint->m_bodyB->m_position ) * 0.5f;
+			joint->m_anchorA = joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+			joint->m_anchorB = joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+
+			joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, 1, 0 ) );
+
+			// Set the initial relative orientation
+			joint->q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+
+			// Neighboring links swing through each other's corners, contacts there would only fight the joint
+			joint->m_disableCollision = true;
+		}
+	}
+
+	AddStandardSandBox( scene.m_bodies );
+}
+
+/*
+====================================================
+BuildDiamondPile
+Diamonds dropped in a narrow column so they pile up
+====================================================
+*/
+void BuildDiamondPile( Scene & scene, const int numDiamonds ) {
+	const int numX = 5;
+	const int numY = 5;
+
+	scene.m_bodies.reserve( numDiamonds + 5 );
+	for ( int i = 0; i < numDiamonds; i++ ) {
+		const int layer = i / ( numX * numY );
+		const float offset = ( layer & 1 ) ? 0.5f : 0.0f;
+
+		Vec3 pos;
+		pos.x = -5.0f + (float)( i % numX ) * 2.5f + offset;
+		pos.y = -5.0f + (float)( ( i / numX ) % numY ) * 2.5f + offset;
+		pos.z = 3.0f + (float)layer * 2.5f;
+
+		scene.m_bodies.push_back( MakeBody( pos, new ShapeConvex( g_diamond, sizeof( g_diamond ) / sizeof( Vec3 ) ), 1.0f, 0.5f, 0.5f ) );
+	}
+
+	AddStandardSandBox( scene.m_bodies );
+}
+
+/*
+====================================================
+MakeTable
+A top and four legs as one compound shape
+====================================================
+*/
+static Shape * MakeTable() {
+	const Vec3 topCorners[ 2 ] = { Vec3( -1.0f, -1.0f, -0.1f ), Vec3( 1.0f, 1.0f, 0.1f ) };
+
+	compoundChild_t children[ 5 ];
+	children[ 0 ].shape = new ShapeBox( topCorners, 2 );
+	children[ 0 ].position = Vec3( 0.0f, 0.0f, 0.6f );
+	children[ 0 ].orientation = Quat( 0, 0, 0, 1 );
+	children[ 0 ].mass = 4.0f;
+	for ( int i = 0; i < 4; i++ ) {
+		children[ 1 + i ].shape = new ShapeCylinder( 0.1f, 0.5f );
+		children[ 1 + i ].position = Vec3( ( i & 1 ) ? 0.8f : -0.8f, ( i & 2 ) ? 0.8f : -0.8f, 0.0f );
+		children[ 1 + i ].orientation = Quat( 0, 0, 0, 1 );
+		children[ 1 + i ].mass = 1.0f;
+	}
+	return new ShapeCompound( children, 5 );
+}
+
+/*
+====================================================
+BuildTablePile
+Tables dropped in layers so they land on each other, each one is a single compound body
+====================================================
+*/
+void BuildTablePile( Scene & scene, const int numTables ) {
+	const int numX = 3;
+	const int numY = 3;
+
+	scene.m_bodies.reserve( numTables + 5 );
+	for ( int i = 0; i < numTables; i++ ) {
+		const int layer = i / ( numX * numY );
+		const float offset = ( layer & 1 ) ? 0.7f : 0.0f;
+
+		Vec3 pos;
+		pos.x = -3.0f + (float)( i % numX ) * 3.0f + offset;
+		pos.y = -3.0f + (float)( ( i / numX ) % numY ) * 3.0f + offset;
+		pos.z = 1.0f + (float)layer * 2.0f;
+
+		scene.m_bodies.push_back( MakeBody( pos, MakeTable(), 1.0f, 0.5f, 0.5f ) );
+	}
+
+	AddStandardSandBox( scene.m_bodies );
+}
+
+/*
+====================================================
+BuildTerrainDrop
+Spheres, boxes and capsules dropped onto a bumpy bowl shaped heightfield, the bowl keeps them
+from rolling off the edge
+====================================================
+*/
+void BuildTerrainDrop( Scene & scene, const int numBodies ) {
+	const int numSamples = 65;
+	const float spacing = 0.5f;
+	const float halfWidth = 0.5f * (float)( numSamples - 1 ) * spacing;
+
+	std::vector< float > heights( numSamples * numSamples );
+	for ( int y = 0; y < numSamples; y++ ) {
+		for ( int x = 0; x < numSamples; x++ ) {
+			const float px = (float)x * spacing - halfWidth;
+			const float py = (float)y * spacing - halfWidth;
+			heights[ y * numSamples + x ] = 0.02f * ( px * px + py * py ) + 0.3f * sinf( px * 0.8f ) * cosf( py * 0.6f );
+		}
+	}
+
+	scene.m_bodies.reserve( numBodies + 1 );
+	Shape * terrain = new ShapeHeightfield( heights.data(), numSamples, numSamples, spacing );
+	scene.m_bodies.push_back( MakeBody( Vec3( -halfWidth, -halfWidth, 0.0f ), terrain, 0.0f, 0.5f, 0.5f ) );
+
+	const Vec3 boxCorners[ 2 ] = { Vec3( -0.4f, -0.4f, -0.4f ), Vec3( 0.4f, 0.4f, 0.4f ) };
+	const int numX = 10;
+	const int numY = 10;
+	for ( int i = 0; i < numBodies; i++ ) {
+		const int layer = i / ( numX * numY );
+		const float offset = ( layer & 1 ) ? 0.6f : 0.0f;
+
+		Vec3 pos;
+		pos.x = -6.75f + (float)( i % numX ) * 1.5f + offset;
+		pos.y = -6.75f + (float)( ( i / numX ) % numY ) * 1.5f + offset;
+		pos.z = 4.0f + (float)layer * 1.5f;
+
+		Shape * shape = NULL;
+		switch ( i % 3 ) {
+			case 0: shape = new ShapeSphere( 0.4f ); break;
+			case 1: shape = new ShapeBox( boxCorners, 2 ); break;
+			default: shape = new ShapeCapsule( 0.25f, 0.4f ); break;
+		}
+		scene.m_bodies.push_back( MakeBody( pos, shape, 1.0f, 0.5f, 0.5f ) );
+	}
+}
@@ -0,0 +1,27 @@
+//
+//  BenchScenes.h
+//	Standard scenes for the headless benchmarks
+//
+#pragma once
+#include "Scene.h"
+
+typedef void ( *buildSceneFunc_t )( Scene & scene, const int size );
+
+struct benchScene_t {
+	const char *		name;
+	const char *		sizeDescription;	// what the size parameter controls
+	int					defaultSize;
+	buildSceneFunc_t	build;
+};
+
+void BuildSphereRain( Scene & scene, const int numSpheres );
+void BuildBoxPyramid( Scene & scene, const int height );
+void BuildBoxColumn( Scene & scene, const int height );
+void BuildRagdollCrowd( Scene & scene, const int numRagdolls );
+void BuildHingeChains( Scene & scene, const int numChains );
+void BuildDiamondPile( Scene & scene, const int numDiamonds );
+void BuildTablePile( Scene & scene, const int numTables );
+void BuildTerrainDrop( Scene & scene, const int numBodies );
+
+extern const benchScene_t g_benchScenes[];
+extern const int g_numBenchScenes;
@@ -0,0 +1,137 @@
+//
+//  DeterminismBench.cpp
+//	Checks that the demo scene replays bit-for-bit and measures the cost of deterministic mode
+//
+#include "Scene.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+/*
+====================================================
+GetTimeMicroseconds
+====================================================
+*/
+static double GetTimeMicroseconds() {
+	using namespace std::chrono;
+	return (double)duration_cast< nanoseconds >( high_resolution_clock::now().time_since_epoch() ).count() * 0.001;
+}
+
+/*
+====================================================
+RunScene
+Steps a freshly initialized scene and returns the mean time per step in microseconds
+====================================================
+*/
+static double RunScene( const bool isDeterministic, const int numSteps, std::vector< unsigned long long > * hashes ) {
+	const float dt_sec = 1.0f / 60.0f;
+
+	Scene scene;
+	scene.m_isDeterministic = isDeterministic;
+	scene.Initialize();
+
+	double totalTime = 0.0;
+	for ( int i = 0; i < numSteps; i++ ) {
+		const double t0 = GetTimeMicroseconds();
+		scene.Update( dt_sec );
+		totalTime += GetTimeMicroseconds() - t0;
+
+		if ( NULL != hashes ) {
+			hashes->push_back( scene.m_stateHash );
+		}
+	}
+	return totalTime / (double)numSteps;
+}
+
+/*
+====================================================
+CompareHashes
+Returns the first step where the two runs diverge, or -1 if they match
+====================================================
+*/
+static int CompareHashes( const std::vector< unsigned long long > & a, const std::vector< unsigned long long > & b ) {
+	for ( int i = 0; i < a.size() && i < b.size(); i++ ) {
+		if ( a[ i ] != b[ i ] ) {
+			return i;
+		}
+	}
+	return ( a.size() == b.size() ) ? -1 : (int)std::min( a.size(), b.size() );
+}
+
+/*
+====================================================
+main
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	int numSteps = 600;
+	if ( argc > 1 ) {
+		numSteps = atoi( argv[ 1 ] );
+	}
+	if ( numSteps <= 1 ) {
+		printf( "usage: DeterminismBench [numSteps]\n" );
+		return 1;
+	}
+
+	FillDiamond();
+
+	//
+	//	Two independent runs must produce the same state every step
+	//
+	std::vector< unsigned long long > hashesA;
+	std::vector< unsigned long long > hashesB;
+	RunScene( true, numSteps, &hashesA );
+	RunScene( true, numSteps, &hashesB );
+
+	int divergedStep = CompareHashes( hashesA, hashesB );
+	if ( divergedStep >= 0 ) {
+		printf( "ERROR: runs diverged at step %i\n", divergedStep );
+		return 1;
+	}
+	printf( "replay: %i steps match, final hash %016llx\n", numSteps, hashesA.back() );
+
+	//
+	//	Restoring a snapshot taken half way must replay the second half exactly
+	//
+	{
+		const float dt_sec = 1.0f / 60.0f;
+		const int halfSteps = numSteps / 2;
+
+		Scene scene;
+		scene.m_isDeterministic = true;
+		scene.Initialize();
+		for ( int i = 0; i < halfSteps; i++ ) {
+			scene.Update( dt_sec );
+		}
+
+		std::vector< unsigned char > buffer( scene.GetSnapshotSize( 1024 ) );
+		const int size = scene.SaveSnapshot( buffer.data(), (int)buffer.size() );
+		for ( int i = halfSteps; i < numSteps; i++ ) {
+			scene.Update( dt_sec );
+		}
+
+		if ( 0 == size || !scene.RestoreSnapshot( buffer.data(), size ) ) {
+			printf( "ERROR: snapshot failed\n" );
+			return 1;
+		}
+
+		for ( int i = halfSteps; i < numSteps; i++ ) {
+			scene.Update( dt_sec );
+			if ( scene.m_stateHash != hashesA[ i ] ) {
+				printf( "ERROR: rollback diverged at step %i\n", i );
+				return 1;
+			}
+		}
+		printf( "rollback: steps %i - %i match after restoring a snapshot\n", halfSteps, numSteps - 1 );
+	}
+
+	//
+	//	Cost of deterministic mode
+	//
+	const double timeDefault = RunScene( false, numSteps, NULL );
+	const double timeDeterministic = RunScene( true, numSteps, NULL );
+	printf( "default       us/step: %8.2f\n", timeDefault );
+	printf( "deterministic us/step: %8.2f  (%+.1f%%)\n", timeDeterministic, ( timeDeterministic / timeDefault - 1.0 ) * 100.0 );
+	return 0;
+}
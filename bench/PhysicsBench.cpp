@@ -0,0 +1,240 @@
+//
+//  PhysicsBench.cpp
+//	Runs the standard scenes headless and reports the time spent in each phase of Scene::Update
+//
+#include "BenchScenes.h"
+#include "Profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+static const int NUM_PHASES = 5;
+static const char * g_phaseNames[ NUM_PHASES ] = { "broadphase", "narrowphase", "solve", "integrate", "total" };
+
+struct phaseStats_t {
+	float min;
+	float mean;
+	float p99;
+};
+
+struct sceneResult_t {
+	const benchScene_t * scene;
+	int size;
+	int numBodies;
+	int numConstraints;
+	phaseStats_t phases[ NUM_PHASES ];
+};
+
+/*
+====================================================
+CalculateStats
+====================================================
+*/
+static phaseStats_t CalculateStats( std::vector< float > & samples ) {
+	phaseStats_t stats;
+	std::sort( samples.begin(), samples.end() );
+
+	double sum = 0.0;
+	for ( int i = 0; i < samples.size(); i++ ) {
+		sum += samples[ i ];
+	}
+
+	const int idx99 = std::max( 0, (int)ceilf( 0.99f * (float)samples.size() ) - 1 );
+	stats.min = samples[ 0 ];
+	stats.mean = (float)( sum / (double)samples.size() );
+	stats.p99 = samples[ idx99 ];
+	return stats;
+}
+
+/*
+====================================================
+RunScene
+====================================================
+*/
+static sceneResult_t RunScene( const benchScene_t & benchScene, const int size, const int numSteps, const float dt_sec, const int numStatsSteps ) {
+	Scene scene;
+	benchScene.build( scene, size );
+
+	std::vector< float > samples[ NUM_PHASES ];
+	for ( int i = 0; i < NUM_PHASES; i++ ) {
+		samples[ i ].reserve( numSteps );
+	}
+
+	for ( int step = 0; step < numSteps; step++ ) {
+		scene.Update( dt_sec );
+
+		const sceneTimings_t & timings = scene.m_timings;
+		samples[ 0 ].push_back( timings.broadphase );
+		samples[ 1 ].push_back( timings.narrowphase );
+		samples[ 2 ].push_back( timings.solve );
+		samples[ 3 ].push_back( timings.integrate );
+		samples[ 4 ].push_back( timings.total );
+	}
+
+	if ( numStatsSteps > 0 ) {
+		printf( "\n%s stats:\n", benchScene.name );
+		scene.DumpStats( stdout, numStatsSteps );
+	}
+
+	sceneResult_t result;
+	result.scene = &benchScene;
+	result.size = size;
+	result.numBodies = (int)scene.m_bodies.size();
+	result.numConstraints = (int)scene.m_constraints.size();
+	for ( int i = 0; i < NUM_PHASES; i++ ) {
+		result.phases[ i ] = CalculateStats( samples[ i ] );
+	}
+	return result;
+}
+
+/*
+====================================================
+PrintResult
+====================================================
+*/
+static void PrintResult( const sceneResult_t & result ) {
+	printf( "\n%s (%s %i): %i bodies, %i constraints\n", result.scene->name, result.scene->sizeDescription, result.size, result.numBodies, result.numConstraints );
+	printf( "  %-12s %10s %10s %10s\n", "phase (us)", "min", "mean", "p99" );
+	for ( int i = 0; i < NUM_PHASES; i++ ) {
+		const phaseStats_t & stats = result.phases[ i ];
+		printf( "  %-12s %10.1f %10.1f %10.1f\n", g_phaseNames[ i ], stats.min, stats.mean, stats.p99 );
+	}
+}
+
+/*
+====================================================
+WriteJson
+====================================================
+*/
+static bool WriteJson( const char * fileName, const std::vector< sceneResult_t > & results, const int numSteps, const float dt_sec ) {
+	FILE * file = ( 0 == strcmp( fileName, "-" ) ) ? stdout : fopen( fileName, "wb" );
+	if ( NULL == file ) {
+		printf( "ERROR: unable to open %s for writing\n", fileName );
+		return false;
+	}
+
+	fprintf( file, "{\n" );
+	fprintf( file, "  \"steps\": %i,\n", numSteps );
+	fprintf( file, "  \"dt_sec\": %g,\n", dt_sec );
+	fprintf( file, "  \"units\": \"us\",\n" );
+	fprintf( file, "  \"scenes\": [\n" );
+	for ( int s = 0; s < results.size(); s++ ) {
+		const sceneResult_t & result = results[ s ];
+		fprintf( file, "    {\n" );
+		fprintf( file, "      \"name\": \"%s\",\n", result.scene->name );
+		fprintf( file, "      \"size\": %i,\n", result.size );
+		fprintf( file, "      \"bodies\": %i,\n", result.numBodies );
+		fprintf( file, "      \"constraints\": %i,\n", result.numConstraints );
+		fprintf( file, "      \"phases\": {\n" );
+		for ( int i = 0; i < NUM_PHASES; i++ ) {
+			const phaseStats_t & stats = result.phases[ i ];
+			fprintf( file, "        \"%s\": { \"min\": %.2f, \"mean\": %.2f, \"p99\": %.2f }%s\n", g_phaseNames[ i ], stats.min, stats.mean, stats.p99, ( i < NUM_PHASES - 1 ) ? "," : "" );
+		}
+		fprintf( file, "      }\n" );
+		fprintf( file, "    }%s\n", ( s < (int)results.size() - 1 ) ? "," : "" );
+	}
+	fprintf( file, "  ]\n" );
+	fprintf( file, "}\n" );
+
+	if ( file != stdout ) {
+		fclose( file );
+	}
+	return true;
+}
+
+/*
+====================================================
+PrintUsage
+====================================================
+*/
+static void PrintUsage() {
+	printf( "usage: PhysicsBench [--scene name] [--size n] [--steps n] [--json file|-] [--trace file] [--stats n]\n" );
+	printf( "  --trace needs a build with ENABLE_PROFILER\n" );
+	printf( "  --stats prints the counters of the last n steps of each scene\n" );
+	printf( "scenes:\n" );
+	for ( int i = 0; i < g_numBenchScenes; i++ ) {
+		printf( "  %-10s size = %s (default %i)\n", g_benchScenes[ i ].name, g_benchScenes[ i ].sizeDescription, g_benchScenes[ i ].defaultSize );
+	}
+}
+
+/*
+====================================================
+main
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	const char * sceneName = NULL;
+	const char * jsonFile = NULL;
+	const char * traceFile = NULL;
+	int size = 0;
+	int numSteps = 300;
+	int numStatsSteps = 0;
+	const float dt_sec = 1.0f / 60.0f;
+
+	for ( int i = 1; i < argc; i++ ) {
+		const bool hasValue = ( i + 1 < argc );
+		if ( 0 == strcmp( argv[ i ], "--scene" ) && hasValue ) {
+			sceneName = argv[ ++i ];
+		} else if ( 0 == strcmp( argv[ i ], "--size" ) && hasValue ) {
+			size = atoi( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--steps" ) && hasValue ) {
+			numSteps = atoi( argv[ ++i ] );
+		} else if ( 0 == strcmp( argv[ i ], "--json" ) && hasValue ) {
+			jsonFile = argv[ ++i ];
+		} else if ( 0 == strcmp( argv[ i ], "--trace" ) && hasValue ) {
+			traceFile = argv[ ++i ];
+		} else if ( 0 == strcmp( argv[ i ], "--stats" ) && hasValue ) {
+			numStatsSteps = atoi( argv[ ++i ] );
+		} else {
+			PrintUsage();
+			return 1;
+		}
+	}
+	if ( numSteps <= 0 || size < 0 ) {
+		PrintUsage();
+		return 1;
+	}
+
+	FillDiamond();
+
+	PROFILE_THREAD_NAME( "Main" );
+
+	// Keep stdout clean when the json is written to it
+	const bool isQuiet = ( NULL != jsonFile && 0 == strcmp( jsonFile, "-" ) );
+
+	std::vector< sceneResult_t > results;
+	for ( int i = 0; i < g_numBenchScenes; i++ ) {
+		const benchScene_t & benchScene = g_benchScenes[ i ];
+		if ( NULL != sceneName && 0 != strcmp( sceneName, benchScene.name ) ) {
+			continue;
+		}
+
+		const int sceneSize = ( size > 0 ) ? size : benchScene.defaultSize;
+		{
+			PROFILE_SCOPE( benchScene.name );
+			results.push_back( RunScene( benchScene, sceneSize, numSteps, dt_sec, isQuiet ? 0 : numStatsSteps ) );
+		}
+		if ( !isQuiet ) {
+			PrintResult( results.back() );
+		}
+	}
+
+	if ( results.empty() ) {
+		printf( "ERROR: unknown scene %s\n", sceneName );
+		PrintUsage();
+		return 1;
+	}
+
+	if ( NULL != jsonFile && !WriteJson( jsonFile, results, numSteps, dt_sec ) ) {
+		return 1;
+	}
+
+	if ( NULL != traceFile && !PROFILE_WRITE_TRACE( traceFile ) ) {
+		printf( "ERROR: failed to write trace %s\n", traceFile );
+		return 1;
+	}
+	return 0;
+}
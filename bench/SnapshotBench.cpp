@@ -0,0 +1,216 @@
+//
+//  SnapshotBench.cpp
+//	Measures the cost of Scene::SaveSnapshot/Scene::RestoreSnapshot, and of a round trip through
+//	a scene file with Scene::Save/Scene::Load
+//
+#include "Scene.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+/*
+====================================================
+GetTimeMicroseconds
+====================================================
+*/
+static double GetTimeMicroseconds() {
+	using namespace std::chrono;
+	return (double)duration_cast< nanoseconds >( high_resolution_clock::now().time_since_epoch() ).count() * 0.001;
+}
+
+/*
+====================================================
+BuildScene
+Columns of resting box stacks and hanging chains, so the snapshot has
+bodies, contact manifolds and constraint accumulators to store
+====================================================
+*/
+static void BuildScene( Scene & scene, const int numBodies ) {
+	const int columnHeight = 10;
+	const int numColumns = ( numBodies + columnHeight - 1 ) / columnHeight;
+
+	// Constraints point into the body array, so it can't be allowed to grow
+	scene.m_bodies.reserve( numColumns * columnHeight );
+
+	for ( int c = 0; c < numColumns; c++ ) {
+		// Space the columns along the broadphase axis so they don't overlap each other
+		const Vec3 base = Vec3( (float)c * 15.0f, (float)c * 15.0f, 0.0f );
+
+		Body body;
+		body.m_orientation = Quat( 0, 0, 0, 1 );
+		body.m_linearVelocity.Zero();
+		body.m_angularVelocity.Zero();
+		body.m_elasticity = 0.5f;
+		body.m_friction = 0.5f;
+
+		if ( ( c & 1 ) == 0 ) {
+			//
+			//	Stack of boxes on a static box
+			//
+			for ( int i = 0; i < columnHeight; i++ ) {
+				body.m_position = base + Vec3( 0, 0, (float)i * 1.99f );
+				body.m_invMass = ( 0 == i ) ? 0.0f : 1.0f;
+				body.m_shape = new ShapeBox( g_boxUnit, sizeof( g_boxUnit ) / sizeof( Vec3 ) );
+				scene.m_bodies.push_back( body );
+			}
+			continue;
+		}
+
+		//
+		//	Chain hanging from a static box
+		//
+		body.m_position = base + Vec3( 0, 0, 10.0f );
+		body.m_invMass = 0.0f;
+		body.m_shape = new ShapeBox( g_boxSmall, sizeof( g_boxSmall ) / sizeof( Vec3 ) );
+		scene.m_bodies.push_back( body );
+
+		for ( int i = 1; i < columnHeight; i++ ) {
+			Body * bodyA = &scene.m_bodies[ scene.m_bodies.size() - 1 ];
+
+			body.m_position = bodyA->m_position + Vec3( 1, 0, 0 );
+			body.m_invMass = 1.0f;
+			body.m_shape = new ShapeBox( g_boxSmall, sizeof( g_boxSmall ) / sizeof( Vec3 ) );
+			scene.m_bodies.push_back( body );
+
+			ConstraintDistance * joint = scene.m_constraints.Create< ConstraintDistance >();
+			joint->m_bodyA = bodyA;
+			joint->m_bodyB = &scene.m_bodies[ scene.m_bodies.size() - 1 ];
+			joint->m_anchorA = joint->m_bodyA->WorldSpaceToBodySpace( bodyA->m_position );
+			joint->m_anchorB = joint->m_bodyB->WorldSpaceToBodySpace( bodyA->m_position );
+		}
+	}
+}
+
+/*
+====================================================
+main
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	int numBodies = 10000;
+	int numIterations = 100;
+	if ( argc > 1 ) {
+		numBodies = atoi( argv[ 1 ] );
+	}
+	if ( argc > 2 ) {
+		numIterations = atoi( argv[ 2 ] );
+	}
+	if ( numBodies <= 0 || numIterations <= 0 ) {
+		printf( "usage: SnapshotBench [numBodies] [numIterations]\n" );
+		return 1;
+	}
+
+	FillDiamond();
+
+	Scene scene;
+	BuildScene( scene, numBodies );
+
+	// Let the stacks settle a little so there are manifolds with warm started contacts
+	const float dt_sec = 1.0f / 60.0f;
+	for ( int i = 0; i < 10; i++ ) {
+		scene.Update( dt_sec );
+	}
+
+	const int numManifolds = (int)scene.m_manifolds.m_manifolds.size();
+	const int bufferSize = scene.GetSnapshotSize( numManifolds * 2 );
+	std::vector< unsigned char > buffer( bufferSize );
+
+	double minSave = 1e30;
+	double minRestore = 1e30;
+	double totalSave = 0.0;
+	double totalRestore = 0.0;
+	int snapshotSize = 0;
+	for ( int i = 0; i < numIterations; i++ ) {
+		const double t0 = GetTimeMicroseconds();
+		snapshotSize = scene.SaveSnapshot( buffer.data(), bufferSize );
+		const double t1 = GetTimeMicroseconds();
+		const bool restored = scene.RestoreSnapshot( buffer.data(), snapshotSize );
+		const double t2 = GetTimeMicroseconds();
+
+		if ( 0 == snapshotSize || !restored ) {
+			printf( "ERROR: snapshot failed\n" );
+			return 1;
+		}
+
+		minSave = std::min( minSave, t1 - t0 );
+		minRestore = std::min( minRestore, t2 - t1 );
+		totalSave += t1 - t0;
+		totalRestore += t2 - t1;
+	}
+
+	const int numActualBodies = (int)scene.m_bodies.size();
+	const double scale = 10000.0 / (double)numActualBodies;
+	const double meanSave = totalSave / (double)numIterations;
+	const double meanRestore = totalRestore / (double)numIterations;
+
+	printf( "bodies: %i  constraints: %i  manifolds: %i\n", numActualBodies, (int)scene.m_constraints.size(), numManifolds );
+	printf( "snapshot size: %i bytes\n", snapshotSize );
+	printf( "save    us: min %8.2f  mean %8.2f  per 10k bodies %8.2f\n", minSave, meanSave, meanSave * scale );
+	printf( "restore us: min %8.2f  mean %8.2f  per 10k bodies %8.2f\n", minRestore, meanRestore, meanRestore * scale );
+
+	//
+	//	Scene file round trip, the file has no manifolds but the bodies should come back exactly
+	//
+	const char * fileName = "SnapshotBench.scene";
+	const int numFileIterations = std::min( numIterations, 10 );
+	const unsigned long long stateHash = scene.GetStateHash();
+	Scene loaded;
+
+	double minFileSave = 1e30;
+	double minFileLoad = 1e30;
+	for ( int i = 0; i < numFileIterations; i++ ) {
+		const double t0 = GetTimeMicroseconds();
+		const bool saved = scene.Save( fileName );
+		const double t1 = GetTimeMicroseconds();
+		const bool wasLoaded = saved && loaded.Load( fileName );
+		const double t2 = GetTimeMicroseconds();
+
+		if ( !wasLoaded ) {
+			printf( "ERROR: scene file round trip failed\n" );
+			return 1;
+		}
+
+		minFileSave = std::min( minFileSave, t1 - t0 );
+		minFileLoad = std::min( minFileLoad, t2 - t1 );
+	}
+
+	long fileSize = 0;
+	FILE * file = fopen( fileName, "rb" );
+	if ( NULL != file ) {
+		fseek( file, 0, SEEK_END );
+		fileSize = ftell( file );
+		fclose( file );
+	}
+	remove( fileName );
+
+	const bool isMatch = ( loaded.m_bodies.size() == scene.m_bodies.size() && loaded.m_constraints.size() == scene.m_constraints.size() && loaded.GetStateHash() == stateHash );
+	const double megabytes = (double)fileSize / ( 1024.0 * 1024.0 );
+
+	printf( "scene file size: %li bytes\n", fileSize );
+	printf( "file save us: min %10.2f  %8.1f MB/s\n", minFileSave, megabytes / ( minFileSave * 1e-6 ) );
+	printf( "file load us: min %10.2f  %8.1f MB/s\n", minFileLoad, megabytes / ( minFileLoad * 1e-6 ) );
+	printf( "state hash after reload: %016llx %s\n", loaded.GetStateHash(), isMatch ? "matches" : "DIFFERS" );
+
+	//
+	//	The built-in scene has a mover, a constraint with only one body, which the bench scene
+	//	doesn't.  Both copies are stepped a while after the round trip, so the constraints have to
+	//	come back working as well as the bodies.
+	//
+	Scene initial;
+	initial.Initialize();
+	Scene initialLoaded;
+	const bool wasInitialLoaded = initial.Save( fileName ) && initialLoaded.Load( fileName );
+	remove( fileName );
+	if ( !wasInitialLoaded ) {
+		printf( "ERROR: Initialize() scene file round trip failed\n" );
+		return 1;
+	}
+	for ( int i = 0; i < 120; i++ ) {
+		initial.Update( dt_sec );
+		initialLoaded.Update( dt_sec );
+	}
+	const bool isInitialMatch = ( initialLoaded.m_constraints.size() == initial.m_constraints.size() && initialLoaded.GetStateHash() == initial.GetStateHash() );
+	printf( "Initialize() scene hash after reload and 120 steps: %016llx %s\n", initialLoaded.GetStateHash(), isInitialMatch ? "matches" : "DIFFERS" );
+	return ( isMatch && isInitialMatch ) ? 0 : 1;
+}
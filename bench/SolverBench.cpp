@@ -0,0 +1,306 @@
+//
+//  SolverBench.cpp
+//	Compares the accuracy and cost of more solver iterations against more substeps, split
+//	impulse position correction, block solving manifolds, manifold friction, solving joint trees
+//	directly and stopping each island once it has converged.  Also checks that a manifold the
+//	block solver can't factor falls back without changing the friction it gets.
+//
+#include "BenchScenes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct solverConfig_t {
+	const char *	name;
+	int				numSubsteps;
+	int				numIterations;
+	bool			useSplitImpulse;
+	bool			useBlockSolver;
+	bool			useManifoldFriction;
+	bool			useDirectJointSolver;
+	float			solverTolerance;	// zero runs numIterations, otherwise up to numIterations until converged
+};
+
+// Pairs with the same number of solver passes per update, so the cost difference is
+// mostly the extra PreSolve and integration that each substep does
+static const solverConfig_t g_solverConfigs[] = {
+	{ "iterations 5",		1, 5, false, false, false, false, 0.0f },
+	{ "substeps 5",			5, 1, false, false, false, false, 0.0f },
+	{ "split 5",			1, 5, true, false, false, false, 0.0f },
+	{ "block 5",			1, 5, false, true, false, false, 0.0f },
+	{ "iterations 10",		1, 10, false, false, false, false, 0.0f },
+	{ "substeps 10",		10, 1, false, false, false, false, 0.0f },
+	{ "split 10",			1, 10, true, false, false, false, 0.0f },
+	{ "block 10",			1, 10, false, true, false, false, 0.0f },
+	{ "friction 10",		1, 10, false, false, true, false, 0.0f },
+	{ "block friction 10",	1, 10, false, true, true, false, 0.0f },
+	{ "direct 5",			1, 5, false, false, false, true, 0.0f },
+	{ "direct 10",			1, 10, false, false, false, true, 0.0f },
+	{ "iterations 20",		1, 20, false, false, false, false, 0.0f },
+	{ "substeps 20",		20, 1, false, false, false, false, 0.0f },
+	{ "split 20",			1, 20, true, false, false, false, 0.0f },
+	{ "adaptive 20",		1, 20, false, false, false, false, 1e-3f },
+	{ "adaptive 40",		1, 40, false, false, false, false, 1e-3f },
+};
+static const int g_numSolverConfigs = sizeof( g_solverConfigs ) / sizeof( solverConfig_t );
+
+struct solverResult_t {
+	float updateTime;		// mean microseconds per update
+	float meanPenetration;	// mean of the deepest penetration each step
+	float maxPenetration;
+	float maxJointError;	// distance between the two anchors of a joint
+	float meanSpeed;		// mean speed of the dynamic bodies at the end
+	float meanIterations;	// mean solver iterations per island
+};
+
+/*
+====================================================
+DeepestPenetration
+====================================================
+*/
+static float DeepestPenetration( const Scene & scene ) {
+	float deepest = 0.0f;
+	for ( int m = 0; m < scene.m_manifolds.m_manifolds.size(); m++ ) {
+		const Manifold & manifold = scene.m_manifolds.m_manifolds[ m ];
+		for ( int c = 0; c < manifold.GetNumContacts(); c++ ) {
+			const float depth = -manifold.GetSeparation( c );
+			deepest = ( depth > deepest ) ? depth : deepest;
+		}
+	}
+	return deepest;
+}
+
+/*
+====================================================
+LargestJointError
+====================================================
+*/
+static float LargestJointError( const Scene & scene ) {
+	float largest = 0.0f;
+	for ( int i = 0; i < scene.m_constraints.size(); i++ ) {
+		const Constraint * constraint = scene.m_constraints[ i ];
+		if ( NULL == constraint->m_bodyA || NULL == constraint->m_bodyB ) {
+			continue;
+		}
+		const Vec3 a = constraint->m_bodyA->BodySpaceToWorldSpace( constraint->m_anchorA );
+		const Vec3 b = constraint->m_bodyB->BodySpaceToWorldSpace( constraint->m_anchorB );
+		const float error = ( b - a ).GetMagnitude();
+		largest = ( error > largest ) ? error : largest;
+	}
+	return largest;
+}
+
+/*
+====================================================
+RunConfig
+====================================================
+*/
+static solverResult_t RunConfig( const benchScene_t & benchScene, const solverConfig_t & config, const int numSteps ) {
+	const float dt_sec = 1.0f / 60.0f;
+
+	Scene scene;
+	benchScene.build( scene, benchScene.defaultSize );
+	scene.m_numSubsteps = config.numSubsteps;
+	scene.m_numIterations = config.numIterations;
+	scene.m_useSplitImpulse = config.useSplitImpulse;
+	scene.m_useBlockSolver = config.useBlockSolver;
+	scene.m_useManifoldFriction = config.useManifoldFriction;
+	scene.m_useDirectJointSolver = config.useDirectJointSolver;
+	scene.m_solverTolerance = config.solverTolerance;
+	scene.m_maxIterations = config.numIterations;
+
+	solverResult_t result;
+	memset( &result, 0, sizeof( result ) );
+
+	// Measure accuracy over the second half, once everything has landed
+	const int firstMeasured = numSteps / 2;
+	double totalTime = 0.0;
+	double totalPenetration = 0.0;
+	int totalIterations = 0;
+	int totalIslands = 0;
+	for ( int step = 0; step < numSteps; step++ ) {
+		scene.Update( dt_sec );
+		totalTime += scene.m_timings.total;
+		totalIterations += scene.m_stats.numIslandIterations;
+		totalIslands += scene.m_stats.numIslands;
+
+		if ( step < firstMeasured ) {
+			continue;
+		}
+		const float penetration = DeepestPenetration( scene );
+		const float jointError = LargestJointError( scene );
+		totalPenetration += penetration;
+		result.maxPenetration = ( penetration > result.maxPenetration ) ? penetration : result.maxPenetration;
+		result.maxJointError = ( jointError > result.maxJointError ) ? jointError : result.maxJointError;
+	}
+
+	int numDynamic = 0;
+	double totalSpeed = 0.0;
+	for ( int i = 0; i < scene.m_bodies.size(); i++ ) {
+		if ( 0.0f == scene.m_bodies[ i ].m_invMass ) {
+			continue;
+		}
+		totalSpeed += scene.m_bodies[ i ].m_linearVelocity.GetMagnitude();
+		numDynamic++;
+	}
+
+	result.updateTime = (float)( totalTime / (double)numSteps );
+	result.meanPenetration = (float)( totalPenetration / (double)( numSteps - firstMeasured ) );
+	result.meanSpeed = ( numDynamic > 0 ) ? (float)( totalSpeed / (double)numDynamic ) : 0.0f;
+	result.meanIterations = ( totalIslands > 0 ) ? (float)totalIterations / (float)totalIslands : 0.0f;
+	return result;
+}
+
+/*
+====================================================
+AddDegenerateContact
+Adds the copy of a box corner contact used by RunDegenerate.  Both points are moved the same
+distance along the normal, so the copy has the same separation and the same normal row as the
+original, and the block solver can't solve the pair together.
+====================================================
+*/
+static void AddDegenerateContact( ManifoldCollector & manifolds, Body * box, Body * ground, const Vec3 & corner, const bool isCopy ) {
+	const Vec3 normal( 0, 0, 1 );
+	const Vec3 offset = isCopy ? normal * 0.05f : Vec3( 0, 0, 0 );
+
+	contact_t contact;
+	contact.bodyA = box;
+	contact.bodyB = ground;
+	contact.normal = normal;
+	contact.ptOnA_WorldSpace = box->BodySpaceToWorldSpace( corner ) + offset;
+	contact.ptOnB_WorldSpace = Vec3( contact.ptOnA_WorldSpace.x, contact.ptOnA_WorldSpace.y, 0.0f ) + offset;
+	contact.ptOnA_LocalSpace = box->WorldSpaceToBodySpace( contact.ptOnA_WorldSpace );
+	contact.ptOnB_LocalSpace = ground->WorldSpaceToBodySpace( contact.ptOnB_WorldSpace );
+	contact.separationDistance = ( contact.ptOnB_WorldSpace - contact.ptOnA_WorldSpace ).Dot( normal );
+	contact.timeOfImpact = 0.0f;
+	manifolds.AddContact( contact );
+}
+
+/*
+====================================================
+RunDegenerate
+A box sliding on the ground, resting on two corners, with and without a copy of each corner
+contact.  The box's position is left alone and only its velocity is solved, so the contacts stay
+the same every step.  The copies double the normal rows, which the block solver has to handle
+without falling back.  Manifold friction is one set of rows for the whole manifold, so with it the
+speed at the end should match.  Each contact's own friction gets more rows from the copies, at a
+different height from the corners, which the iterations don't fully converge, so without manifold
+friction the speeds can differ a little.
+====================================================
+*/
+static void RunDegenerate( const solverConfig_t & config, const bool withCopies, const int numSteps, float & speed, int & numFallbacks ) {
+	const float dt_sec = 1.0f / 60.0f;
+
+	Body ground;
+	ground.m_position = Vec3( 0, 0, -1 );
+	ground.m_orientation = Quat( 0, 0, 0, 1 );
+	ground.m_invMass = 0.0f;
+	ground.m_elasticity = 0.0f;
+	ground.m_friction = 0.5f;
+	ground.m_shape = new ShapeBox( g_boxUnit, sizeof( g_boxUnit ) / sizeof( Vec3 ) );
+
+	Body box;
+	box.m_position = Vec3( 0, 0, 1 );
+	box.m_orientation = Quat( 0, 0, 0, 1 );
+	box.m_linearVelocity = Vec3( 4, 0, 0 );
+	box.m_angularVelocity.Zero();
+	box.m_invMass = 1.0f;
+	box.m_elasticity = 0.0f;
+	box.m_friction = 0.5f;
+	box.m_shape = new ShapeBox( g_boxUnit, sizeof( g_boxUnit ) / sizeof( Vec3 ) );
+
+	// The corners at the front and back of the box, so the friction can't tip it
+	const Vec3 corners[ 2 ] = { Vec3( 1, 0, -1 ), Vec3( -1, 0, -1 ) };
+	ManifoldCollector manifolds;
+	for ( int i = 0; i < 2; i++ ) {
+		AddDegenerateContact( manifolds, &box, &ground, corners[ i ], false );
+		if ( withCopies ) {
+			AddDegenerateContact( manifolds, &box, &ground, corners[ i ], true );
+		}
+	}
+
+	physicsStats_t stats;
+	memset( &stats, 0, sizeof( stats ) );
+
+	solverContext_t context;
+	context.baumgarteScale = 1.0f;
+	context.useSplitImpulse = config.useSplitImpulse;
+	context.useBlockSolver = config.useBlockSolver;
+	context.useManifoldFriction = config.useManifoldFriction;
+	context.maxImpulseSqr = 0.0f;
+	context.stats = &stats;
+
+	for ( int step = 0; step < numSteps; step++ ) {
+		box.m_linearVelocity += Vec3( 0, 0, -10 ) * dt_sec;
+		manifolds.PreSolve( dt_sec, context );
+		for ( int i = 0; i < config.numIterations; i++ ) {
+			manifolds.Solve( context );
+		}
+		manifolds.PostSolve();
+	}
+
+	speed = box.m_linearVelocity.GetMagnitude();
+	numFallbacks = stats.numBlockFallbacks;
+
+	delete ground.m_shape;
+	delete box.m_shape;
+}
+
+/*
+====================================================
+main
+====================================================
+*/
+int main( int argc, char * argv[] ) {
+	const int numSteps = ( argc > 1 ) ? atoi( argv[ 1 ] ) : 240;
+	if ( numSteps < 2 ) {
+		printf( "usage: SolverBench [numSteps]\n" );
+		return 1;
+	}
+
+	FillDiamond();
+
+	// Tall stacks and long chains are where the solver struggles to converge
+	const char * sceneNames[] = { "pyramid", "column", "chains" };
+	for ( int s = 0; s < 3; s++ ) {
+		const benchScene_t * benchScene = NULL;
+		for ( int i = 0; i < g_numBenchScenes; i++ ) {
+			if ( 0 == strcmp( g_benchScenes[ i ].name, sceneNames[ s ] ) ) {
+				benchScene = &g_benchScenes[ i ];
+			}
+		}
+		if ( NULL == benchScene ) {
+			continue;
+		}
+
+		printf( "\n%s (%s %i), %i steps\n", benchScene->name, benchScene->sizeDescription, benchScene->defaultSize, numSteps );
+		printf( "  %-18s %10s %8s %12s %12s %12s %10s\n", "solver", "us/step", "iters", "mean pen", "max pen", "joint err", "speed" );
+		for ( int c = 0; c < g_numSolverConfigs; c++ ) {
+			const solverResult_t result = RunConfig( *benchScene, g_solverConfigs[ c ], numSteps );
+			printf( "  %-18s %10.1f %8.1f %12.5f %12.5f %12.5f %10.4f\n", g_solverConfigs[ c ].name,
+				result.updateTime, result.meanIterations, result.meanPenetration, result.maxPenetration, result.maxJointError, result.meanSpeed );
+			fflush( stdout );
+		}
+	}
+
+	// The box starts at 4 m/s and manifold friction takes 2.5 m/s off each second, so it's still
+	// sliding at the end.  Each contact's own friction is limited far more loosely and stops it at once.
+	const int numDegenerateSteps = 40;
+	printf( "\ndegenerate manifold, %i steps\n", numDegenerateSteps );
+	printf( "  %-18s %10s %10s %14s %17s\n", "solver", "speed", "fallbacks", "speed copies", "fallbacks copies" );
+	for ( int c = 0; c < g_numSolverConfigs; c++ ) {
+		const solverConfig_t & config = g_solverConfigs[ c ];
+		if ( !config.useBlockSolver || 1 != config.numSubsteps ) {
+			continue;
+		}
+		float speed;
+		float speedCopies;
+		int numFallbacks;
+		int numFallbacksCopies;
+		RunDegenerate( config, false, numDegenerateSteps, speed, numFallbacks );
+		RunDegenerate( config, true, numDegenerateSteps, speedCopies, numFallbacksCopies );
+		printf( "  %-18s %10.4f %10i %14.4f %17i\n", config.name, speed, numFallbacks, speedCopies, numFallbacksCopies );
+	}
+	return 0;
+}
@@ -7,8 +7,13 @@
 #include <assert.h>
 #include <string.h>
 
+#if defined( _WIN32 )
 #include <direct.h>
 #define GetCurrentDir _getcwd
+#else
+#include <unistd.h>
+#define GetCurrentDir getcwd
+#endif
 
 static char g_ApplicationDirectory[ FILENAME_MAX ];
 static bool g_WasInitialized = false;
@@ -139,4 +144,127 @@ bool SaveFileData( const char * fileNameLocal, const void * data, unsigned int s
 	fclose( file );
 	printf( "Write file was success %s\n", fileName );
 	return true;
+}
+
+/*
+====================================================
+RemoveFile
+Deletes the file, for cleaning up after a write that failed part way
+====================================================
+*/
+bool RemoveFile( const char * fileNameLocal ) {
+	InitializeFileSystem();
+
+	char fileName[ 2048 ];
+	sprintf( fileName, "%s/%s", g_ApplicationDirectory, fileNameLocal );
+
+	if ( 0 != remove( fileName ) ) {
+		printf( "ERROR: remove file failed: %s\n", fileName );
+		return false;
+	}
+	return true;
+}
+
+/*
+====================================================
+OpenFileStream
+Opens the file for chunked reading or writing
+====================================================
+*/
+bool OpenFileStream( const char * fileNameLocal, fileStream_t & stream, const bool write ) {
+	InitializeFileSystem();
+
+	char fileName[ 2048 ];
+	sprintf( fileName, "%s/%s", g_ApplicationDirectory, fileNameLocal );
+
+	stream.file = NULL;
+	stream.isWriting = write;
+	stream.size = 0;
+
+	FILE * file = fopen( fileName, write ? "wb" : "rb" );
+	if ( file == NULL ) {
+		printf( "ERROR: open file stream failed: %s\n", fileName );
+		return false;
+	}
+
+	if ( !write ) {
+		fseek( file, 0, SEEK_END );
+		stream.size = (unsigned int)ftell( file );
+		fseek( file, 0, SEEK_SET );
+	}
+
+	stream.file = file;
+	return true;
+}
+
+/*
+====================================================
+ReadFileChunk
+Reads exactly size bytes from the stream into data
+====================================================
+*/
+bool ReadFileChunk( fileStream_t & stream, void * data, unsigned int size ) {
+	assert( NULL != stream.file && !stream.isWriting );
+	if ( NULL == stream.file || stream.isWriting ) {
+		return false;
+	}
+
+	unsigned int bytesRead = (unsigned int)fread( data, 1, size, (FILE *)stream.file );
+	if ( bytesRead != size ) {
+		printf( "ERROR: reading file stream went wrong (%u of %u bytes)\n", bytesRead, size );
+		return false;
+	}
+	return true;
+}
+
+/*
+====================================================
+WriteFileChunk
+Appends size bytes from data to the stream
+====================================================
+*/
+bool WriteFileChunk( fileStream_t & stream, const void * data, unsigned int size ) {
+	assert( NULL != stream.file && stream.isWriting );
+	if ( NULL == stream.file || !stream.isWriting ) {
+		return false;
+	}
+
+	unsigned int bytesWritten = (unsigned int)fwrite( data, 1, size, (FILE *)stream.file );
+	if ( bytesWritten != size ) {
+		printf( "ERROR: writing file stream went wrong (%u of %u bytes)\n", bytesWritten, size );
+		return false;
+	}
+	return true;
+}
+
+/*
+====================================================
+GetFileStreamRemaining
+Lets readers check a count from the file against what's left of it before allocating for it
+====================================================
+*/
+unsigned int GetFileStreamRemaining( const fileStream_t & stream ) {
+	if ( NULL == stream.file || stream.isWriting ) {
+		return 0;
+	}
+
+	const long offset = ftell( (FILE *)stream.file );
+	if ( offset < 0 || (unsigned int)offset > stream.size ) {
+		return 0;
+	}
+	return stream.size - (unsigned int)offset;
+}
+
+/*
+====================================================
+CloseFileStream
+====================================================
+*/
+void CloseFileStream( fileStream_t & stream ) {
+	if ( NULL == stream.file ) {
+		return;
+	}
+
+	fclose( (FILE *)stream.file );
+	stream.file = NULL;
 }
\ No newline at end of file
@@ -4,4 +4,24 @@
 #pragma once
 
 bool GetFileData( const char * fileName, unsigned char ** data, unsigned int & size );
-bool SaveFileData( const char * fileName, const void * data, unsigned int size );
\ No newline at end of file
+bool SaveFileData( const char * fileName, const void * data, unsigned int size );
+bool RemoveFile( const char * fileName );
+
+/*
+====================================================
+fileStream_t
+Handle for reading/writing a file in chunks, so large
+files don't have to be held in memory all at once
+====================================================
+*/
+struct fileStream_t {
+	void *			file;		// FILE *
+	bool			isWriting;
+	unsigned int	size;		// length of the file when it was opened for reading
+};
+
+bool OpenFileStream( const char * fileName, fileStream_t & stream, const bool write );
+bool ReadFileChunk( fileStream_t & stream, void * data, unsigned int size );
+bool WriteFileChunk( fileStream_t & stream, const void * data, unsigned int size );
+unsigned int GetFileStreamRemaining( const fileStream_t & stream );	// bytes left to read
+void CloseFileStream( fileStream_t & stream );
\ No newline at end of file
@@ -2,7 +2,6 @@
 //	Bounds.cpp
 //
 #include "Bounds.h"
-#include "../Physics/Body.h"
 
 /*
 ====================================================
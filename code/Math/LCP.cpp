@@ -9,16 +9,218 @@ LCP_GaussSeidel
 ====================================================
 */
 VecN LCP_GaussSeidel( const MatN & A, const VecN & b ) {
+	return LCP_GaussSeidel( A, b, b.N, 0.0f );
+}
+
+/*
+====================================================
+LCP_GaussSeidel
+====================================================
+*/
+VecN LCP_GaussSeidel( const MatN & A, const VecN & b, const int maxIterations, const float tolerance ) {
 	const int N = b.N;
 	VecN x( N );
 	x.Zero();
 
-	for ( int iter = 0; iter < N; iter++ ) {
+	for ( int iter = 0; iter < maxIterations; iter++ ) {
+		float maxDelta = 0.0f;
 		for ( int i = 0; i < N; i++ ) {
 			float dx = ( b[ i ] - A.rows[ i ].Dot( x ) ) / A.rows[ i ][ i ];
 			if ( dx * 0.0f == dx * 0.0f ) {
 				x[ i ] = x[ i ] + dx;
+				maxDelta = ( fabsf( dx ) > maxDelta ) ? fabsf( dx ) : maxDelta;
+			}
+		}
+
+		// Another sweep would change nothing, or not enough to matter
+		if ( maxDelta <= tolerance ) {
+			break;
+		}
+	}
+	return x;
+}
+
+/*
+====================================================
+LCP_ProjectedGaussSeidel
+====================================================
+*/
+VecN LCP_ProjectedGaussSeidel( const MatN & A, const VecN & b, const VecN & lo, const VecN & hi, const VecN & x0, const int maxIterations, const float tolerance ) {
+	const int N = b.N;
+	VecN x = x0;
+	for ( int i = 0; i < N; i++ ) {
+		x[ i ] = ( x[ i ] < lo[ i ] ) ? lo[ i ] : x[ i ];
+		x[ i ] = ( x[ i ] > hi[ i ] ) ? hi[ i ] : x[ i ];
+	}
+
+	for ( int iter = 0; iter < maxIterations; iter++ ) {
+		float maxDelta = 0.0f;
+		for ( int i = 0; i < N; i++ ) {
+			const float dx = ( b[ i ] - A.rows[ i ].Dot( x ) ) / A.rows[ i ][ i ];
+			if ( dx * 0.0f != dx * 0.0f ) {
+				continue;
+			}
+
+			float xi = x[ i ] + dx;
+			xi = ( xi < lo[ i ] ) ? lo[ i ] : xi;
+			xi = ( xi > hi[ i ] ) ? hi[ i ] : xi;
+			maxDelta = ( fabsf( xi - x[ i ] ) > maxDelta ) ? fabsf( xi - x[ i ] ) : maxDelta;
+			x[ i ] = xi;
+		}
+
+		if ( maxDelta <= tolerance ) {
+			break;
+		}
+	}
+	return x;
+}
+
+/*
+====================================================
+LCP_SolveCholesky
+====================================================
+*/
+bool LCP_SolveCholesky( const float A[ LCP_MAX_ROWS ][ LCP_MAX_ROWS ], const float * b, const int N, float * x, const float tolerance ) {
+	float L[ LCP_MAX_ROWS ][ LCP_MAX_ROWS ] = { { 0.0f } };
+	for ( int i = 0; i < N; i++ ) {
+		for ( int j = 0; j <= i; j++ ) {
+			float sum = A[ i ][ j ];
+			for ( int k = 0; k < j; k++ ) {
+				sum -= L[ i ][ k ] * L[ j ][ k ];
+			}
+			if ( i == j ) {
+				if ( sum <= tolerance * A[ i ][ i ] ) {
+					return false;
+				}
+				L[ i ][ i ] = sqrtf( sum );
+			} else {
+				L[ i ][ j ] = sum / L[ j ][ j ];
+			}
+		}
+	}
+
+	float y[ LCP_MAX_ROWS ];
+	for ( int i = 0; i < N; i++ ) {
+		float sum = b[ i ];
+		for ( int k = 0; k < i; k++ ) {
+			sum -= L[ i ][ k ] * y[ k ];
+		}
+		y[ i ] = sum / L[ i ][ i ];
+	}
+	for ( int i = N - 1; i >= 0; i-- ) {
+		float sum = y[ i ];
+		for ( int k = i + 1; k < N; k++ ) {
+			sum -= L[ k ][ i ] * x[ k ];
+		}
+		x[ i ] = sum / L[ i ][ i ];
+	}
+	return true;
+}
+
+/*
+====================================================
+LCP_FactorLDLT
+====================================================
+*/
+void LCP_FactorLDLT( const float A[ LCP_MAX_ROWS ][ LCP_MAX_ROWS ], const int N, const float tolerance, ldlt_t & ldlt ) {
+	float D[ LCP_MAX_ROWS ];
+
+	float maxDiagonal = 0.0f;
+	for ( int i = 0; i < N; i++ ) {
+		maxDiagonal = ( fabsf( A[ i ][ i ] ) > maxDiagonal ) ? fabsf( A[ i ][ i ] ) : maxDiagonal;
+	}
+	const float epsilon = tolerance * maxDiagonal;
+
+	ldlt.N = N;
+	ldlt.numDropped = 0;
+	for ( int j = 0; j < N; j++ ) {
+		float pivot = A[ j ][ j ];
+		for ( int k = 0; k < j; k++ ) {
+			pivot -= ldlt.L[ j ][ k ] * ldlt.L[ j ][ k ] * D[ k ];
+		}
+
+		ldlt.L[ j ][ j ] = 1.0f;
+		if ( fabsf( pivot ) <= epsilon || pivot * 0.0f != pivot * 0.0f ) {
+			D[ j ] = 0.0f;
+			ldlt.invD[ j ] = 0.0f;
+			for ( int i = j + 1; i < N; i++ ) {
+				ldlt.L[ i ][ j ] = 0.0f;
+			}
+			ldlt.numDropped++;
+			continue;
+		}
+
+		D[ j ] = pivot;
+		ldlt.invD[ j ] = 1.0f / pivot;
+		for ( int i = j + 1; i < N; i++ ) {
+			float sum = A[ i ][ j ];
+			for ( int k = 0; k < j; k++ ) {
+				sum -= ldlt.L[ i ][ k ] * ldlt.L[ j ][ k ] * D[ k ];
 			}
+			ldlt.L[ i ][ j ] = sum * ldlt.invD[ j ];
+		}
+	}
+}
+
+/*
+====================================================
+LCP_SolveLDLT
+====================================================
+*/
+void LCP_SolveLDLT( const ldlt_t & ldlt, const float * b, float * x ) {
+	const int N = ldlt.N;
+	for ( int i = 0; i < N; i++ ) {
+		x[ i ] = b[ i ];
+		for ( int k = 0; k < i; k++ ) {
+			x[ i ] -= ldlt.L[ i ][ k ] * x[ k ];
+		}
+	}
+	for ( int i = 0; i < N; i++ ) {
+		x[ i ] *= ldlt.invD[ i ];
+	}
+	for ( int i = N - 1; i >= 0; i-- ) {
+		for ( int k = i + 1; k < N; k++ ) {
+			x[ i ] -= ldlt.L[ k ][ i ] * x[ k ];
+		}
+	}
+}
+
+/*
+====================================================
+LCP_SolveDirect
+====================================================
+*/
+VecN LCP_SolveDirect( const MatN & A, const VecN & b ) {
+	const int N = b.N;
+	if ( N > LCP_MAX_ROWS ) {
+		return LCP_GaussSeidel( A, b );
+	}
+
+	float a[ LCP_MAX_ROWS ][ LCP_MAX_ROWS ];
+	for ( int i = 0; i < N; i++ ) {
+		for ( int j = 0; j < N; j++ ) {
+			a[ i ][ j ] = A.rows[ i ][ j ];
+		}
+	}
+
+	ldlt_t ldlt;
+	LCP_FactorLDLT( a, N, 1e-6f, ldlt );
+
+	VecN x( N );
+	LCP_SolveLDLT( ldlt, b.data, x.data );
+	return x;
+}
+
+/*
+====================================================
+LCP_SolveBoxed
+====================================================
+*/
+VecN LCP_SolveBoxed( const MatN & A, const VecN & b, const VecN & lo, const VecN & hi, const int maxIterations ) {
+	const VecN x = LCP_SolveDirect( A, b );
+	for ( int i = 0; i < x.N; i++ ) {
+		if ( x[ i ] < lo[ i ] || x[ i ] > hi[ i ] ) {
+			return LCP_ProjectedGaussSeidel( A, b, lo, hi, x, maxIterations, 0.0f );
 		}
 	}
 	return x;
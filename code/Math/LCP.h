@@ -4,11 +4,72 @@
 #pragma once
 #include "Vector.h"
 #include "Matrix.h"
+#include <float.h>
 
+// Largest system the fixed-size solvers take, enough for the rows of any single constraint
+static const int LCP_MAX_ROWS = 6;
 
 /*
 ====================================================
 LCP_GaussSeidel
+Runs up to maxIterations sweeps, stopping early once no element changes by more than tolerance.
+The two argument version runs N sweeps, one per row.
 ====================================================
 */
-VecN LCP_GaussSeidel( const MatN & A, const VecN & b );
\ No newline at end of file
+VecN LCP_GaussSeidel( const MatN & A, const VecN & b );
+VecN LCP_GaussSeidel( const MatN & A, const VecN & b, const int maxIterations, const float tolerance );
+
+/*
+====================================================
+LCP_ProjectedGaussSeidel
+Boxed LCP, each x[ i ] is kept within lo[ i ] and hi[ i ] (+-FLT_MAX for a row without a bound)
+and solves its row exactly when it isn't at a bound.  Sweeps start from x0, so an accumulated or a direct solution can warm start it, and
+stop early like LCP_GaussSeidel.
+====================================================
+*/
+VecN LCP_ProjectedGaussSeidel( const MatN & A, const VecN & b, const VecN & lo, const VecN & hi, const VecN & x0, const int maxIterations, const float tolerance );
+
+/*
+====================================================
+LCP_SolveCholesky
+Fixed-size solve of a symmetric positive definite system.  Fails when a pivot is no more than
+tolerance times its diagonal entry, meaning the rows are (close to) dependent.
+====================================================
+*/
+bool LCP_SolveCholesky( const float A[ LCP_MAX_ROWS ][ LCP_MAX_ROWS ], const float * b, const int N, float * x, const float tolerance );
+
+/*
+====================================================
+ldlt_t
+LDLt factorization of a symmetric system, which doesn't need it to be definite.  Pivots no
+larger than tolerance times the largest diagonal entry are dropped and their rows solve to zero,
+so a degenerate row gets nothing rather than an enormous value.
+====================================================
+*/
+struct ldlt_t {
+	int N;
+	int numDropped;
+	float L[ LCP_MAX_ROWS ][ LCP_MAX_ROWS ];
+	float invD[ LCP_MAX_ROWS ];
+};
+
+void LCP_FactorLDLT( const float A[ LCP_MAX_ROWS ][ LCP_MAX_ROWS ], const int N, const float tolerance, ldlt_t & ldlt );
+void LCP_SolveLDLT( const ldlt_t & ldlt, const float * b, float * x );
+
+/*
+====================================================
+LCP_SolveDirect
+Exact solve of a constraint's system through its LDLt factorization, for the equality rows that
+LCP_GaussSeidel would otherwise sweep over
+====================================================
+*/
+VecN LCP_SolveDirect( const MatN & A, const VecN & b );
+
+/*
+====================================================
+LCP_SolveBoxed
+The direct solution when it's within the bounds, which makes it the exact one, otherwise the
+direct solution warm starts projected Gauss-Seidel
+====================================================
+*/
+VecN LCP_SolveBoxed( const MatN & A, const VecN & b, const VecN & lo, const VecN & hi, const int maxIterations );
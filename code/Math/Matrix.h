@@ -545,9 +545,9 @@ MatMN
 */
 class MatMN {
 public:
-	MatMN() : M( 0 ), N( 0 ) {}
+	MatMN() : M( 0 ), N( 0 ), rows( NULL ) {}
 	MatMN( int M, int N );
-	MatMN( const MatMN & rhs ) {
+	MatMN( const MatMN & rhs ) : M( 0 ), N( 0 ), rows( NULL ) {
 		*this = rhs;
 	}
 	~MatMN() { delete[] rows; }
@@ -577,9 +577,15 @@ inline MatMN::MatMN( int _M, int _N ) {
 }
 
 inline const MatMN & MatMN::operator = ( const MatMN & rhs ) {
-	M = rhs.M;
+	if ( this == &rhs ) {
+		return *this;
+	}
+	if ( M != rhs.M ) {
+		delete[] rows;
+		M = rhs.M;
+		rows = new VecN[ M ];
+	}
 	N = rhs.N;
-	rows = new VecN[ M ];
 	for ( int m = 0; m < M; m++ ) {
 		rows[ m ] = rhs.rows[ m ];
 	}
@@ -656,12 +662,12 @@ MatN
 */
 class MatN {
 public:
-	MatN() : numDimensions( 0 ) {}
+	MatN() : numDimensions( 0 ), rows( NULL ) {}
 	MatN( int N );
-	MatN( const MatN & rhs ) {
+	MatN( const MatN & rhs ) : rows( NULL ) {
 		*this = rhs;
 	}
-	MatN( const MatMN & rhs ) {
+	MatN( const MatMN & rhs ) : numDimensions( 0 ), rows( NULL ) {
 		*this = rhs;
 	}
 	~MatN() { delete[] rows; }
@@ -691,6 +697,11 @@ inline MatN::MatN( int N ) {
 }
 
 inline const MatN & MatN::operator = ( const MatN & rhs ) {
+	if ( this == &rhs ) {
+		return *this;
+	}
+	delete[] rows;
+
 	numDimensions = rhs.numDimensions;
 	rows = new VecN[ numDimensions ];
 	for ( int i = 0; i < numDimensions; i++ ) {
@@ -703,6 +714,7 @@ inline const MatN & MatN::operator = ( const MatMN & rhs ) {
 	if ( rhs.M != rhs.N ) {
 		return *this;
 	}
+	delete[] rows;
 
 	numDimensions = rhs.N;
 	rows = new VecN[ numDimensions ];
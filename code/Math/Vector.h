@@ -708,10 +708,16 @@ inline VecN::VecN( const VecN & rhs ) {
 }
 
 inline VecN & VecN::operator = ( const VecN & rhs ) {
-	delete[] data;
+	if ( this == &rhs ) {
+		return *this;
+	}
 
-	N = rhs.N;
-	data = new float[ N ];
+	// Keep the storage when the size is the same
+	if ( N != rhs.N ) {
+		delete[] data;
+		N = rhs.N;
+		data = new float[ N ];
+	}
 	for ( int i = 0; i < N; i++ ) {
 		data[ i ] = rhs.data[ i ];
 	}
@@ -0,0 +1,153 @@
+//
+//	Profiler.cpp
+//
+#include "Profiler.h"
+
+#if defined( ENABLE_PROFILER )
+#include "Fileio.h"
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct profileEvent_t {
+	const char *	name;
+	double			start;	// microseconds
+	double			end;
+};
+
+/*
+====================================================
+profileThreadBuffer_t
+Ring buffer of the most recent events from a single thread.  Only the owning
+thread writes to it, the count is atomic so a dump sees whole events.
+====================================================
+*/
+struct profileThreadBuffer_t {
+	static const unsigned int MAX_EVENTS = 1 << 16;	// must be a power of two
+
+	int							threadId;
+	std::string					threadName;
+	std::atomic< unsigned int >	count;	// total events ever recorded, the ring holds the last MAX_EVENTS
+	profileEvent_t				events[ MAX_EVENTS ];
+};
+
+static std::mutex g_profileMutex;	// protects g_profileBuffers and the thread names
+static std::vector< profileThreadBuffer_t * > g_profileBuffers;
+static thread_local profileThreadBuffer_t * t_profileBuffer = NULL;
+
+/*
+====================================================
+GetThreadBuffer
+====================================================
+*/
+static profileThreadBuffer_t * GetThreadBuffer() {
+	if ( NULL == t_profileBuffer ) {
+		profileThreadBuffer_t * buffer = new profileThreadBuffer_t;
+		buffer->count = 0;
+
+		std::lock_guard< std::mutex > lock( g_profileMutex );
+		buffer->threadId = (int)g_profileBuffers.size();
+		g_profileBuffers.push_back( buffer );
+		t_profileBuffer = buffer;
+	}
+	return t_profileBuffer;
+}
+
+/*
+====================================================
+ProfilerGetTimeMicroseconds
+====================================================
+*/
+double ProfilerGetTimeMicroseconds() {
+	using namespace std::chrono;
+	static const steady_clock::time_point start = steady_clock::now();
+	return (double)duration_cast< nanoseconds >( steady_clock::now() - start ).count() * 0.001;
+}
+
+/*
+====================================================
+ProfilerRecordEvent
+====================================================
+*/
+void ProfilerRecordEvent( const char * name, const double startMicroseconds, const double endMicroseconds ) {
+	profileThreadBuffer_t * buffer = GetThreadBuffer();
+
+	const unsigned int count = buffer->count.load( std::memory_order_relaxed );
+	profileEvent_t & event = buffer->events[ count & ( profileThreadBuffer_t::MAX_EVENTS - 1 ) ];
+	event.name = name;
+	event.start = startMicroseconds;
+	event.end = endMicroseconds;
+	buffer->count.store( count + 1, std::memory_order_release );
+}
+
+/*
+====================================================
+ProfilerSetThreadName
+====================================================
+*/
+void ProfilerSetThreadName( const char * name ) {
+	profileThreadBuffer_t * buffer = GetThreadBuffer();
+
+	std::lock_guard< std::mutex > lock( g_profileMutex );
+	buffer->threadName = name;
+}
+
+/*
+====================================================
+ProfilerClear
+Only the calling thread's events are guaranteed to be gone, other threads
+may still be in the middle of recording
+====================================================
+*/
+void ProfilerClear() {
+	std::lock_guard< std::mutex > lock( g_profileMutex );
+	for ( int i = 0; i < g_profileBuffers.size(); i++ ) {
+		g_profileBuffers[ i ]->count.store( 0, std::memory_order_release );
+	}
+}
+
+/*
+====================================================
+ProfilerWriteChromeTrace
+Writes every thread's events in the Chrome trace event format.  Events being
+overwritten while this runs may come out garbled, so dump between frames.
+====================================================
+*/
+bool ProfilerWriteChromeTrace( const char * fileName ) {
+	std::string json;
+	json.reserve( 1024 * 1024 );
+	json += "{\"traceEvents\":[\n";
+
+	char line[ 512 ];
+	bool isFirst = true;
+
+	std::lock_guard< std::mutex > lock( g_profileMutex );
+	for ( int i = 0; i < g_profileBuffers.size(); i++ ) {
+		const profileThreadBuffer_t * buffer = g_profileBuffers[ i ];
+
+		if ( !buffer->threadName.empty() ) {
+			snprintf( line, sizeof( line ), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+				isFirst ? "" : ",\n", buffer->threadId, buffer->threadName.c_str() );
+			json += line;
+			isFirst = false;
+		}
+
+		const unsigned int count = buffer->count.load( std::memory_order_acquire );
+		const unsigned int first = ( count > profileThreadBuffer_t::MAX_EVENTS ) ? ( count - profileThreadBuffer_t::MAX_EVENTS ) : 0;
+		for ( unsigned int e = first; e < count; e++ ) {
+			const profileEvent_t & event = buffer->events[ e & ( profileThreadBuffer_t::MAX_EVENTS - 1 ) ];
+			snprintf( line, sizeof( line ), "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+				isFirst ? "" : ",\n", event.name, buffer->threadId, event.start, event.end - event.start );
+			json += line;
+			isFirst = false;
+		}
+	}
+
+	json += "\n]}\n";
+	return SaveFileData( fileName, json.data(), (unsigned int)json.size() );
+}
+
+#endif
@@ -0,0 +1,54 @@
+//
+//	Profiler.h
+//
+#pragma once
+
+/*
+====================================================
+Profiler
+
+Scoped timing events, recorded into a ring buffer per thread so that recording
+never takes a lock.  The buffers can be written out as a Chrome trace json
+(chrome://tracing, or ui.perfetto.dev).
+
+Everything compiles away unless ENABLE_PROFILER is defined.
+
+	PROFILE_SCOPE( "BroadPhase" );		// times until the end of the enclosing scope
+	PROFILE_THREAD_NAME( "Physics" );	// names the calling thread in the trace
+	PROFILE_WRITE_TRACE( "trace.json" );
+====================================================
+*/
+#if defined( ENABLE_PROFILER )
+
+double ProfilerGetTimeMicroseconds();
+void ProfilerRecordEvent( const char * name, const double startMicroseconds, const double endMicroseconds );
+void ProfilerSetThreadName( const char * name );
+void ProfilerClear();
+bool ProfilerWriteChromeTrace( const char * fileName );
+
+class ProfileScope {
+public:
+	explicit ProfileScope( const char * name ) : m_name( name ), m_start( ProfilerGetTimeMicroseconds() ) {}
+	~ProfileScope() { ProfilerRecordEvent( m_name, m_start, ProfilerGetTimeMicroseconds() ); }
+
+private:
+	const char *	m_name;	// must be a string literal, only the pointer is stored
+	double			m_start;
+};
+
+#define PROFILE_CONCAT_INNER( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_INNER( a, b )
+
+#define PROFILE_SCOPE( name )				ProfileScope PROFILE_CONCAT( profileScope, __LINE__ )( name )
+#define PROFILE_THREAD_NAME( name )			ProfilerSetThreadName( name )
+#define PROFILE_CLEAR()						ProfilerClear()
+#define PROFILE_WRITE_TRACE( fileName )		ProfilerWriteChromeTrace( fileName )
+
+#else
+
+#define PROFILE_SCOPE( name )
+#define PROFILE_THREAD_NAME( name )
+#define PROFILE_CLEAR()
+#define PROFILE_WRITE_TRACE( fileName )		false
+
+#endif
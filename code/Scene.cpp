@@ -5,6 +5,7 @@
 #include "Physics/Contact.h"
 #include "Physics/Intersections.h"
 #include "Physics/Broadphase.h"
+#include "Profiler.h"
 
 /*
 ========================================================================================================
@@ -117,79 +118,95 @@ Scene::Update
 */
 void Scene::Update(const float dt_sec)
 {
+	PROFILE_SCOPE("Scene::Update");
+
 	// acceleration due to gravity
-	for (int i = 0; i < m_bodies.size(); ++i)
 	{
-		Body* body = &m_bodies[i];
-		float mass = 1.0f / body->m_invMass;
+		PROFILE_SCOPE("Gravity");
+		for (int i = 0; i < m_bodies.size(); ++i)
+		{
+			Body* body = &m_bodies[i];
+			float mass = 1.0f / body->m_invMass;
 
-		Vec3 impulseGravity = Vec3(0, 0, -10) * mass * dt_sec;
-		body->ApplyImpulseLinear(impulseGravity);
+			Vec3 impulseGravity = Vec3(0, 0, -10) * mass * dt_sec;
+			body->ApplyImpulseLinear(impulseGravity);
+		}
 	}
 
 	// broadphase
 	std::vector<collisionPair_t> collisionPairs;
-	BroadPhase(m_bodies.data(), (int)m_bodies.size(), collisionPairs, dt_sec);
+	{
+		PROFILE_SCOPE("BroadPhase");
+		BroadPhase(m_bodies.data(), (int)m_bodies.size(), collisionPairs, dt_sec);
+	}
 
 	// narrowphase
 	int numContacts = 0;
 	const int maxContacts = m_bodies.size() * m_bodies.size();
 	contact_t* contacts = (contact_t*)alloca(sizeof(contact_t) * maxContacts);
 
-	for (int i = 0; i < collisionPairs.size(); ++i)
 	{
-		const collisionPair_t& pair = collisionPairs[i];
-		Body* bodyA = &m_bodies[pair.a];
-		Body* bodyB = &m_bodies[pair.b];
-
-		if (bodyA->m_invMass == 0.0f && bodyB->m_invMass == 0.0f)
+		PROFILE_SCOPE("NarrowPhase");
+		for (int i = 0; i < collisionPairs.size(); ++i)
 		{
-			continue;
-		}
-
-		contact_t contact;
-		if (Intersect(bodyA, bodyB, dt_sec, contact))
-		{
-			contacts[numContacts] = contact;
-			numContacts++;
+			const collisionPair_t& pair = collisionPairs[i];
+			Body* bodyA = &m_bodies[pair.a];
+			Body* bodyB = &m_bodies[pair.b];
+
+			if (bodyA->m_invMass == 0.0f && bodyB->m_invMass == 0.0f)
+			{
+				continue;
+			}
+
+			contact_t contact;
+			if (Intersect(bodyA, bodyB, dt_sec, contact))
+			{
+				contacts[numContacts] = contact;
+				numContacts++;
+			}
 		}
 	}
 
 	// sort times of impact from earliest to latest
 	if (numContacts > 1)
 	{
+		PROFILE_SCOPE("SortContacts");
 		qsort(contacts, numContacts, sizeof(contact_t), CompareContacts);
 	}
 
 	float accomulatedTime = 0.0f;
 
-	for (int i = 0; i < numContacts; ++i)
 	{
-		contact_t& contact = contacts[i];
-		const float dt = contact.timeOfImpact - accomulatedTime;
-
-		//Body* bodyA = contact.bodyA;
-		//Body* bodyB = contact.bodyB;
-
-		//// skip infinite mass
-		//if (bodyA->m_invMass == 0.0f && bodyB->m_invMass == 0.0f)
-		//{
-		//	continue;
-		//}
-
-		// position update
-		for (int j = 0; j < m_bodies.size(); ++j)
+		PROFILE_SCOPE("BallisticContacts");
+		for (int i = 0; i < numContacts; ++i)
 		{
-			m_bodies[j].Update(dt);
+			contact_t& contact = contacts[i];
+			const float dt = contact.timeOfImpact - accomulatedTime;
+
+			//Body* bodyA = contact.bodyA;
+			//Body* bodyB = contact.bodyB;
+
+			//// skip infinite mass
+			//if (bodyA->m_invMass == 0.0f && bodyB->m_invMass == 0.0f)
+			//{
+			//	continue;
+			//}
+
+			// position update
+			for (int j = 0; j < m_bodies.size(); ++j)
+			{
+				m_bodies[j].Update(dt);
+			}
+
+			ResolveContact(contact);
+			accomulatedTime += dt;
 		}
-
-		ResolveContact(contact);
-		accomulatedTime += dt;
 	}
 
 	const float timeRemaning = dt_sec - accomulatedTime;
 	if (timeRemaning > 0.0f)
 	{
+		PROFILE_SCOPE("Integrate");
 		for (int i = 0; i < m_bodies.size(); ++i)
 		{
 			m_bodies[i].Update(timeRemaning);
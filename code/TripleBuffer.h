@@ -0,0 +1,48 @@
+//
+//	TripleBuffer.h
+//
+#pragma once
+#include <atomic>
+
+/*
+====================================================
+TripleBuffer
+Hands data from one producer thread to one consumer thread without locks.
+The producer always has a buffer to fill, the consumer always has the most
+recently published buffer to read, and the third buffer sits in between.
+Neither side ever waits on the other, the consumer just skips any buffers
+that were published while it was busy.
+====================================================
+*/
+template< typename T >
+class TripleBuffer {
+public:
+	TripleBuffer() : m_writeIndex( 0 ), m_readIndex( 1 ), m_shared( 2 ) {}
+
+	// Producer side
+	T & GetWriteBuffer() { return m_buffers[ m_writeIndex ]; }
+	void Publish() {
+		const int old = m_shared.exchange( m_writeIndex | NEW_DATA, std::memory_order_acq_rel );
+		m_writeIndex = old & INDEX_MASK;
+	}
+
+	// Consumer side, returns false if nothing new has been published since the last call
+	bool Consume() {
+		if ( 0 == ( m_shared.load( std::memory_order_relaxed ) & NEW_DATA ) ) {
+			return false;
+		}
+		const int old = m_shared.exchange( m_readIndex, std::memory_order_acq_rel );
+		m_readIndex = old & INDEX_MASK;
+		return true;
+	}
+	const T & GetReadBuffer() const { return m_buffers[ m_readIndex ]; }
+
+private:
+	static const int INDEX_MASK = 3;
+	static const int NEW_DATA = 4;
+
+	T m_buffers[ 3 ];
+	int m_writeIndex;				// only touched by the producer
+	int m_readIndex;				// only touched by the consumer
+	std::atomic< int > m_shared;	// index of the buffer in between, plus NEW_DATA if it hasn't been consumed
+};
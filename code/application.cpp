@@ -11,6 +11,7 @@
 
 #include "application.h"
 #include "Fileio.h"
+#include "Profiler.h"
 #include <assert.h>
 
 #include "Renderer/OffscreenRenderer.h"
@@ -93,6 +94,8 @@ void Application::Initialize() {
 
 	m_isPaused = true;
 	m_stepFrame = false;
+
+	StartPhysicsThread();
 }
 
 /*
@@ -278,6 +281,8 @@ Application::Cleanup
 ====================================================
 */
 void Application::Cleanup() {
+	StopPhysicsThread();
+
 	CleanupOffscreen( &m_deviceContext );
 
 	m_copyShader.Cleanup( &m_deviceContext );
@@ -428,8 +433,9 @@ Application::Keyboard
 ====================================================
 */
 void Application::Keyboard( int key, int scancode, int action, int modifiers ) {
+	// The physics thread owns the scene, so these only leave requests for it
 	if ( GLFW_KEY_R == key && GLFW_RELEASE == action ) {
-		m_scene->Reset();
+		m_resetPhysics = true;
 	}
 	if ( GLFW_KEY_T == key && GLFW_RELEASE == action ) {
 		m_isPaused = !m_isPaused;
@@ -437,19 +443,183 @@ void Application::Keyboard( int key, int scancode, int action, int modifiers ) {
 	if ( GLFW_KEY_Y == key && ( GLFW_PRESS == action || GLFW_REPEAT == action ) ) {
 		m_stepFrame = m_isPaused && !m_stepFrame;
 	}
+	if ( GLFW_KEY_P == key && GLFW_RELEASE == action ) {
+		if ( PROFILE_WRITE_TRACE( "trace.json" ) ) {
+			printf( "\nWrote trace.json\n" );
+		}
+	}
 }
 
 /*
 ====================================================
-Application::MainLoop
+Application::SetPhysicsRate
 ====================================================
 */
-void Application::MainLoop() {
-	static int timeLastFrame = 0;
+void Application::SetPhysicsRate( const float rate, const int maxSubsteps ) {
+	m_physicsRate = ( rate > 0.0f ) ? rate : 120.0f;
+	m_maxSubsteps = ( maxSubsteps > 0 ) ? maxSubsteps : 1;
+}
+
+/*
+====================================================
+Application::StartPhysicsThread
+====================================================
+*/
+void Application::StartPhysicsThread() {
+	// Make sure the timer is initialized before two threads can race to do it
+	GetTimeMicroseconds();
+
+	// Give the renderer something to draw before the first update
+	std::vector< bodyTransform_t > transforms( m_scene->m_bodies.size() );
+	for ( int i = 0; i < m_scene->m_bodies.size(); i++ ) {
+		transforms[ i ].position = m_scene->m_bodies[ i ].m_position;
+		transforms[ i ].orientation = m_scene->m_bodies[ i ].m_orientation;
+	}
+	PublishPhysicsFrame( transforms, true, 1.0f / m_physicsRate, 0, 0.0f );
+
+	m_quitPhysics = false;
+	m_physicsThread = std::thread( &Application::PhysicsLoop, this );
+}
+
+/*
+====================================================
+Application::StopPhysicsThread
+====================================================
+*/
+void Application::StopPhysicsThread() {
+	if ( m_physicsThread.joinable() ) {
+		m_quitPhysics = true;
+		m_physicsThread.join();
+	}
+}
+
+/*
+====================================================
+Application::PublishPhysicsFrame
+====================================================
+*/
+void Application::PublishPhysicsFrame( const std::vector< bodyTransform_t > & previous, const bool isPaused, const float step_sec, const int numSteps, const float updateTime_us ) {
 	static int numSamples = 0;
 	static float avgTime = 0.0f;
 	static float maxTime = 0.0f;
 
+	if ( isPaused ) {
+		numSamples = 0;
+		maxTime = 0.0f;
+	}
+	if ( numSteps > 0 ) {
+		if ( updateTime_us > maxTime ) {
+			maxTime = updateTime_us;
+		}
+		avgTime = ( avgTime * float( numSamples ) + updateTime_us ) / float( numSamples + 1 );
+		numSamples++;
+	}
+
+	physicsFrame_t & frame = m_physicsFrames.GetWriteBuffer();
+	frame.previous = previous;
+	frame.current.resize( m_scene->m_bodies.size() );
+	for ( int i = 0; i < m_scene->m_bodies.size(); i++ ) {
+		frame.current[ i ].position = m_scene->m_bodies[ i ].m_position;
+		frame.current[ i ].orientation = m_scene->m_bodies[ i ].m_orientation;
+	}
+	frame.time = GetTimeMicroseconds();
+	frame.step_sec = step_sec;
+	frame.isPaused = isPaused;
+	frame.numSteps = numSteps;
+	frame.updateTime_us = updateTime_us;
+	frame.avgUpdateTime_us = avgTime;
+	frame.maxUpdateTime_us = maxTime;
+	m_physicsFrames.Publish();
+}
+
+/*
+====================================================
+Application::PhysicsLoop
+Runs on the physics thread, stepping the scene at a fixed rate until StopPhysicsThread
+====================================================
+*/
+void Application::PhysicsLoop() {
+	PROFILE_THREAD_NAME( "Physics" );
+
+	const float step_sec = 1.0f / m_physicsRate;
+	float timeAccumulator = 0.0f;	// real time that hasn't been simulated yet
+	int timeLastUpdate = GetTimeMicroseconds();
+	std::vector< bodyTransform_t > previous;
+
+	while ( !m_quitPhysics ) {
+		const int time = GetTimeMicroseconds();
+		const float dt_us = (float)time - (float)timeLastUpdate;
+		timeLastUpdate = time;
+
+		const bool didReset = m_resetPhysics.exchange( false );
+		if ( didReset ) {
+			m_scene->Reset();
+			timeAccumulator = 0.0f;
+		}
+
+		//
+		//	Work out how many fixed steps are due
+		//
+		const bool isPaused = m_isPaused;
+		int numSteps = 0;
+		if ( isPaused ) {
+			timeAccumulator = 0.0f;
+			if ( m_stepFrame.exchange( false ) ) {
+				numSteps = 1;
+			}
+		} else {
+			timeAccumulator += dt_us * 0.001f * 0.001f;
+			numSteps = (int)( timeAccumulator / step_sec );
+
+			// If the physics can't keep up, drop the extra time rather than
+			// trying to catch up and making the next update even slower.
+			if ( numSteps > m_maxSubsteps ) {
+				numSteps = m_maxSubsteps;
+				timeAccumulator = (float)numSteps * step_sec;
+			}
+			timeAccumulator -= (float)numSteps * step_sec;
+		}
+
+		if ( numSteps > 0 ) {
+			PROFILE_SCOPE( "Physics" );
+			const int startTime = GetTimeMicroseconds();
+			for ( int i = 0; i < numSteps; i++ ) {
+				// Only the state before the last step is needed for interpolating
+				if ( i == numSteps - 1 ) {
+					previous.resize( m_scene->m_bodies.size() );
+					for ( int b = 0; b < m_scene->m_bodies.size(); b++ ) {
+						previous[ b ].position = m_scene->m_bodies[ b ].m_position;
+						previous[ b ].orientation = m_scene->m_bodies[ b ].m_orientation;
+					}
+				}
+				m_scene->Update( step_sec );
+			}
+			const int endTime = GetTimeMicroseconds();
+
+			PublishPhysicsFrame( previous, isPaused, step_sec, numSteps, (float)( endTime - startTime ) );
+		} else if ( didReset ) {
+			previous.clear();
+			PublishPhysicsFrame( previous, isPaused, step_sec, 0, 0.0f );
+		}
+
+		// Sleep until the next step is due
+		const float timeToNextStep_sec = step_sec - timeAccumulator;
+		if ( timeToNextStep_sec > 0.0f ) {
+			std::this_thread::sleep_for( std::chrono::microseconds( (int)( timeToNextStep_sec * 1000000.0f ) ) );
+		}
+	}
+}
+
+/*
+====================================================
+Application::MainLoop
+====================================================
+*/
+void Application::MainLoop() {
+	static int timeLastFrame = 0;
+
+	PROFILE_THREAD_NAME( "Main" );
+
 	while ( !glfwWindowShouldClose( m_glfwWindow ) ) {
 		int time					= GetTimeMicroseconds();
 		float dt_us					= (float)time - (float)timeLastFrame;
@@ -465,49 +635,49 @@ void Application::MainLoop() {
 		// Get User Input
 		glfwPollEvents();
 
-		// If the time is greater than 33ms (30fps)
-		// then force the time difference to smaller
-		// to prevent super large simulation steps.
-		if ( dt_us > 33000.0f ) {
-			dt_us = 33000.0f;
-		}
-
-		bool runPhysics = true;
-		if ( m_isPaused ) {
-			dt_us = 0.0f;
-			runPhysics = false;
-			if ( m_stepFrame ) {
-				dt_us = 16667.0f;
-				m_stepFrame = false;
-				runPhysics = true;
+		// Pick up the latest body transforms from the physics thread
+		if ( m_physicsFrames.Consume() ) {
+			const physicsFrame_t & frame = m_physicsFrames.GetReadBuffer();
+			if ( frame.numSteps > 0 ) {
+				printf( "frame dt_ms: %.2f %.2f %.2f steps: %i", frame.avgUpdateTime_us * 0.001f, frame.maxUpdateTime_us * 0.001f, frame.updateTime_us * 0.001f, frame.numSteps );
 			}
-			numSamples = 0;
-			maxTime = 0.0f;
-		}
-		float dt_sec = dt_us * 0.001f * 0.001f;
-
-		// Run Update
-		if ( runPhysics ) {
-			int startTime = GetTimeMicroseconds();
-			for ( int i = 0; i < 2; i++ ) {
-				m_scene->Update( dt_sec * 0.5f );
-			}
-			int endTime = GetTimeMicroseconds();
-
-			dt_us = (float)endTime - (float)startTime;
-			if ( dt_us > maxTime ) {
-				maxTime = dt_us;
-			}
-
-			avgTime = ( avgTime * float( numSamples ) + dt_us ) / float( numSamples + 1 );
-			numSamples++;
-
-			printf( "frame dt_ms: %.2f %.2f %.2f", avgTime * 0.001f, maxTime * 0.001f, dt_us * 0.001f );
 		}
 
 		// Draw the Scene
 		DrawFrame();
 	}
+
+	StopPhysicsThread();
+}
+
+/*
+====================================================
+InterpolatePosition
+====================================================
+*/
+static Vec3 InterpolatePosition( const Vec3 & a, const Vec3 & b, const float t ) {
+	return a + ( b - a ) * t;
+}
+
+/*
+====================================================
+InterpolateOrientation
+Normalized lerp, the rotation between two physics steps is small enough that it's
+indistinguishable from a slerp
+====================================================
+*/
+static Quat InterpolateOrientation( const Quat & a, const Quat & b, const float t ) {
+	// q and -q are the same rotation, go the short way around
+	const float dot = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+	const float sign = ( dot < 0.0f ) ? -1.0f : 1.0f;
+
+	Quat q;
+	q.w = a.w + ( b.w * sign - a.w ) * t;
+	q.x = a.x + ( b.x * sign - a.x ) * t;
+	q.y = a.y + ( b.y * sign - a.y ) * t;
+	q.z = a.z + ( b.z * sign - a.z ) * t;
+	q.Normalize();
+	return q;
 }
 
 /*
@@ -516,6 +686,7 @@ Application::UpdateUniforms
 ====================================================
 */
 void Application::UpdateUniforms() {
+	PROFILE_SCOPE( "UpdateUniforms" );
 	m_renderModels.clear();
 
 	uint32_t uboByteOffset = 0;
@@ -616,14 +787,30 @@ void Application::UpdateUniforms() {
 		//
 		//	Update the uniform buffer with the body positions/orientations
 		//
-		for ( int i = 0; i < m_scene->m_bodies.size(); i++ ) {
-			Body & body = m_scene->m_bodies[ i ];
+		const physicsFrame_t & frame = m_physicsFrames.GetReadBuffer();
+
+		// Render the bodies part way between the last two physics states, by how much
+		// real time has passed since the physics thread published them
+		float interpolation = 1.0f;
+		if ( !frame.isPaused ) {
+			interpolation = (float)( GetTimeMicroseconds() - frame.time ) * 0.001f * 0.001f / frame.step_sec;
+			interpolation = ( interpolation > 1.0f ) ? 1.0f : interpolation;
+		}
+
+		const bool canInterpolate = ( frame.previous.size() == frame.current.size() );
+		for ( int i = 0; i < frame.current.size() && i < m_models.size(); i++ ) {
+			Vec3 position = frame.current[ i ].position;
+			Quat orientation = frame.current[ i ].orientation;
+			if ( canInterpolate ) {
+				position = InterpolatePosition( frame.previous[ i ].position, frame.current[ i ].position, interpolation );
+				orientation = InterpolateOrientation( frame.previous[ i ].orientation, frame.current[ i ].orientation, interpolation );
+			}
 
-			Vec3 fwd = body.m_orientation.RotatePoint( Vec3( 1, 0, 0 ) );
-			Vec3 up = body.m_orientation.RotatePoint( Vec3( 0, 0, 1 ) );
+			Vec3 fwd = orientation.RotatePoint( Vec3( 1, 0, 0 ) );
+			Vec3 up = orientation.RotatePoint( Vec3( 0, 0, 1 ) );
 
 			Mat4 matOrient;
-			matOrient.Orient( body.m_position, fwd, up );
+			matOrient.Orient( position, fwd, up );
 			matOrient = matOrient.Transpose();
 
 			// Update the uniform buffer with the orientation of this body
@@ -633,8 +820,8 @@ void Application::UpdateUniforms() {
 			renderModel.model = m_models[ i ];
 			renderModel.uboByteOffset = uboByteOffset;
 			renderModel.uboByteSize = sizeof( matOrient );
-			renderModel.pos = body.m_position;
-			renderModel.orient = body.m_orientation;
+			renderModel.pos = position;
+			renderModel.orient = orientation;
 			m_renderModels.push_back( renderModel );
 
 			uboByteOffset += m_deviceContext.GetAligendUniformByteOffset( sizeof( matOrient ) );
@@ -650,6 +837,7 @@ Application::DrawFrame
 ====================================================
 */
 void Application::DrawFrame() {
+	PROFILE_SCOPE( "DrawFrame" );
 	UpdateUniforms();
 
 	//
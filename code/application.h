@@ -8,6 +8,8 @@
 #include <stdlib.h>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <thread>
 
 #include "Math/Vector.h"
 #include "Math/Quat.h"
@@ -18,6 +20,37 @@
 #include "Renderer/model.h"
 #include "Renderer/shader.h"
 #include "Renderer/FrameBuffer.h"
+#include "TripleBuffer.h"
+
+/*
+====================================================
+bodyTransform_t
+====================================================
+*/
+struct bodyTransform_t {
+	Vec3 position;
+	Quat orientation;
+};
+
+/*
+====================================================
+physicsFrame_t
+Body transforms published by the physics thread for rendering
+====================================================
+*/
+struct physicsFrame_t {
+	std::vector< bodyTransform_t > previous;	// before the last physics update
+	std::vector< bodyTransform_t > current;
+	int time;			// GetTimeMicroseconds when current was published
+	float step_sec;
+	bool isPaused;
+
+	// Time spent in Scene::Update for the steps in this frame
+	int numSteps;
+	float updateTime_us;
+	float avgUpdateTime_us;
+	float maxUpdateTime_us;
+};
 
 /*
 ====================================================
@@ -26,12 +59,15 @@ Application
 */
 class Application {
 public:
-	Application() : m_isPaused( true ), m_stepFrame( false ) {}
+	Application() : m_isPaused( true ), m_stepFrame( false ), m_physicsRate( 120.0f ), m_maxSubsteps( 8 ), m_quitPhysics( false ), m_resetPhysics( false ) {}
 	~Application();
 
 	void Initialize();
 	void MainLoop();
 
+	// Physics runs in fixed steps of 1 / rate seconds, at most maxSubsteps per frame
+	void SetPhysicsRate( const float rate, const int maxSubsteps );
+
 private:
 	std::vector< const char * > GetGLFWRequiredExtensions() const;
 
@@ -39,6 +75,10 @@ private:
 	bool InitializeVulkan();
 	void Cleanup();
 	void UpdateUniforms();
+	void StartPhysicsThread();
+	void StopPhysicsThread();
+	void PhysicsLoop();
+	void PublishPhysicsFrame( const std::vector< bodyTransform_t > & previous, const bool isPaused, const float step_sec, const int numSteps, const float updateTime_us );
 	void DrawFrame();
 	void ResizeWindow( int windowWidth, int windowHeight );
 	void MouseMoved( float x, float y );
@@ -81,8 +121,21 @@ private:
 	float m_cameraPositionTheta;
 	float m_cameraPositionPhi;
 	float m_cameraRadius;
-	bool m_isPaused;
-	bool m_stepFrame;
+	std::atomic< bool > m_isPaused;
+	std::atomic< bool > m_stepFrame;
+
+	// Fixed timestep
+	float m_physicsRate;		// physics updates per second
+	int m_maxSubsteps;			// most physics updates per frame, time beyond that is dropped
+
+	//
+	//	Physics thread, owns m_scene once started.  The main thread only sees
+	//	the body transforms it publishes through m_physicsFrames.
+	//
+	std::thread m_physicsThread;
+	std::atomic< bool > m_quitPhysics;
+	std::atomic< bool > m_resetPhysics;
+	TripleBuffer< physicsFrame_t > m_physicsFrames;
 
 	std::vector< RenderModel > m_renderModels;
 
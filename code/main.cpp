@@ -2,6 +2,7 @@
 //  main.cpp
 //
 #include "application.h"
+#include <string.h>
 
 /*
 ====================================================
@@ -9,7 +10,18 @@ main
 ====================================================
 */
 int main( int argc, char * argv[] ) {
+	float physicsRate = 120.0f;
+	int maxSubsteps = 8;
+	for ( int i = 1; i + 1 < argc; i += 2 ) {
+		if ( 0 == strcmp( argv[ i ], "--physics-hz" ) ) {
+			physicsRate = (float)atof( argv[ i + 1 ] );
+		} else if ( 0 == strcmp( argv[ i ], "--max-substeps" ) ) {
+			maxSubsteps = atoi( argv[ i + 1 ] );
+		}
+	}
+
 	g_application = new Application;
+	g_application->SetPhysicsRate( physicsRate, maxSubsteps );
 	g_application->Initialize();
 
 	g_application->MainLoop();
@@ -11,8 +11,12 @@ Body::Body
 Body::Body() :
 m_position( 0.0f ),
 m_orientation( 0.0f, 0.0f, 0.0f, 1.0f ),
-m_shape( NULL ) {
+m_shape( NULL ),
+m_collisionLayer( 1 ),
+m_collisionMask( ~0u ) {
 	m_linearVelocity.Zero();
+	m_pseudoLinearVelocity.Zero();
+	m_pseudoAngularVelocity.Zero();
 }
 
 /*
@@ -146,6 +150,11 @@ Body::Update
 ====================================================
 */
 void Body::Update( const float dt_sec ) {
+	// Static bodies don't move, and skipping them keeps rounding from nudging them every step
+	if ( m_linearVelocity.GetLengthSqr() == 0.0f && m_angularVelocity.GetLengthSqr() == 0.0f ) {
+		return;
+	}
+
 	m_position += m_linearVelocity * dt_sec;
 
 	// okay, we have an angular velocity around the center of mass, this needs to be
@@ -172,4 +181,30 @@ void Body::Update( const float dt_sec ) {
 
 	// Now get the new model position
 	m_position = positionCM + dq.RotatePoint( cmToPos );
-}
\ No newline at end of file
+}
+
+/*
+====================================================
+Body::ApplyPseudoVelocity
+====================================================
+*/
+void Body::ApplyPseudoVelocity( const float dt_sec ) {
+	if ( m_pseudoLinearVelocity.GetLengthSqr() == 0.0f && m_pseudoAngularVelocity.GetLengthSqr() == 0.0f ) {
+		return;
+	}
+
+	// Rotate about the center of mass, the same as Update
+	Vec3 positionCM = GetCenterOfMassWorldSpace();
+	Vec3 cmToPos = m_position - positionCM;
+
+	Vec3 dAngle = m_pseudoAngularVelocity * dt_sec;
+	Quat dq = Quat( dAngle, dAngle.GetMagnitude() );
+	m_orientation = dq * m_orientation;
+	m_orientation.Normalize();
+
+	positionCM += m_pseudoLinearVelocity * dt_sec;
+	m_position = positionCM + dq.RotatePoint( cmToPos );
+
+	m_pseudoLinearVelocity.Zero();
+	m_pseudoAngularVelocity.Zero();
+}
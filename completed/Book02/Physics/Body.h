@@ -8,9 +8,6 @@
 #include "../Math/Bounds.h"
 #include "Shapes.h"
 
-#include "../Renderer/model.h"
-#include "../Renderer/shader.h"
-
 /*
 ====================================================
 Body
@@ -24,12 +21,23 @@ public:
 	Quat		m_orientation;
 	Vec3		m_linearVelocity;
 	Vec3		m_angularVelocity;
+
+	// Split impulse position correction, moves the body without adding to its real velocity.
+	// Consumed and cleared by ApplyPseudoVelocity after the body is integrated.
+	Vec3		m_pseudoLinearVelocity;
+	Vec3		m_pseudoAngularVelocity;
 	
 	float		m_invMass;
 	float		m_elasticity;
 	float		m_friction;
 	Shape *		m_shape;
 
+	// Bits of the layers the body is in, and of the layers it collides with.  Two bodies only
+	// collide when each is in a layer the other's mask has, and scene queries skip bodies outside
+	// the layers they ask for.
+	unsigned int	m_collisionLayer;
+	unsigned int	m_collisionMask;
+
 	Vec3 GetCenterOfMassWorldSpace() const;
 	Vec3 GetCenterOfMassModelSpace() const;
 
@@ -44,4 +52,5 @@ public:
 	void ApplyImpulseAngular( const Vec3 & impulse );
 
 	void Update( const float dt_sec );
+	void ApplyPseudoVelocity( const float dt_sec );
 };
\ No newline at end of file
@@ -0,0 +1,126 @@
+//
+//  BoundsTree.cpp
+//
+#include "BoundsTree.h"
+#include <algorithm>
+
+/*
+====================================================
+BoundsTree::Build
+====================================================
+*/
+void BoundsTree::Build( const Bounds * bounds, const int num, const int * ids ) {
+	Clear();
+	if ( num <= 0 ) {
+		return;
+	}
+
+	m_buildItems.resize( num );
+	for ( int i = 0; i < num; i++ ) {
+		buildItem_t & item = m_buildItems[ i ];
+		item.bounds = bounds[ i ];
+		item.center = ( bounds[ i ].mins + bounds[ i ].maxs ) * 0.5f;
+		item.id = ( NULL != ids ) ? ids[ i ] : i;
+	}
+
+	m_nodes.reserve( 2 * ( num / MAX_LEAF_ITEMS + 1 ) );
+	BuildNode( 0, num, 0 );
+
+	m_items.resize( num );
+	m_itemBounds.resize( num );
+	for ( int i = 0; i < num; i++ ) {
+		m_items[ i ] = m_buildItems[ i ].id;
+		m_itemBounds[ i ] = m_buildItems[ i ].bounds;
+	}
+}
+
+/*
+====================================================
+BoundsTree::Clear
+====================================================
+*/
+void BoundsTree::Clear() {
+	m_nodes.clear();
+	m_items.clear();
+	m_itemBounds.clear();
+}
+
+/*
+====================================================
+BoundsTree::BuildNode
+Builds the node over m_buildItems[ first, first + num ) and its children, and returns its index
+====================================================
+*/
+int BoundsTree::BuildNode( const int first, const int num, const int depth ) {
+	const int nodeIdx = (int)m_nodes.size();
+	m_nodes.push_back( node_t() );
+
+	Bounds bounds;
+	Bounds centers;
+	for ( int i = first; i < first + num; i++ ) {
+		bounds.Expand( m_buildItems[ i ].bounds );
+		centers.Expand( m_buildItems[ i ].center );
+	}
+
+	if ( num <= MAX_LEAF_ITEMS || depth >= MAX_DEPTH - 1 ) {
+		node_t & node = m_nodes[ nodeIdx ];
+		node.bounds = bounds;
+		node.right = -1;
+		node.firstItem = first;
+		node.numItems = num;
+		return nodeIdx;
+	}
+
+	// Split at the median along the axis the centers spread furthest along
+	int axis = 0;
+	if ( centers.WidthY() > centers.WidthX() ) {
+		axis = 1;
+	}
+	if ( centers.WidthZ() > ( ( 0 == axis ) ? centers.WidthX() : centers.WidthY() ) ) {
+		axis = 2;
+	}
+
+	const int half = num / 2;
+	std::nth_element( m_buildItems.begin() + first, m_buildItems.begin() + first + half, m_buildItems.begin() + first + num,
+		[ axis ]( const buildItem_t & a, const buildItem_t & b ) {
+			if ( a.center[ axis ] != b.center[ axis ] ) {
+				return a.center[ axis ] < b.center[ axis ];
+			}
+			return a.id < b.id;	// so the tree doesn't depend on the sort implementation
+		} );
+
+	BuildNode( first, half, depth + 1 );
+	const int right = BuildNode( first + half, num - half, depth + 1 );
+
+	node_t & node = m_nodes[ nodeIdx ];
+	node.bounds = bounds;
+	node.right = right;
+	node.firstItem = first;
+	node.numItems = num;
+	return nodeIdx;
+}
+
+/*
+====================================================
+BoundsTree::RayBounds
+Slab test of the ray start + t * dir, t in [ 0, maxFraction ], against the bounds
+====================================================
+*/
+bool BoundsTree::RayBounds( const Vec3 & start, const Vec3 & invDir, const Bounds & bounds, const float maxFraction, float & tEnter ) {
+	float tMin = 0.0f;
+	float tMax = maxFraction;
+	for ( int i = 0; i < 3; i++ ) {
+		float t0 = ( bounds.mins[ i ] - start[ i ] ) * invDir[ i ];
+		float t1 = ( bounds.maxs[ i ] - start[ i ] ) * invDir[ i ];
+		if ( t0 > t1 ) {
+			std::swap( t0, t1 );
+		}
+		tMin = std::max( tMin, t0 );
+		tMax = std::min( tMax, t1 );
+		if ( tMin > tMax ) {
+			return false;
+		}
+	}
+	tEnter = tMin;
+	return true;
+}
@@ -0,0 +1,167 @@
+//
+//	BoundsTree.h
+//
+#pragma once
+#include "../Math/Vector.h"
+#include "../Math/Bounds.h"
+#include <vector>
+
+/*
+================================
+BoundsTree
+Bounding volume hierarchy over a set of bounds, each with an integer id.  It's built top down in
+one go, splitting each node at the median of the longest axis of its items' centers, so it suits
+sets that are rebuilt rather than updated, like the bodies after a step.
+
+Nodes are stored depth first, a node's first child directly follows it, so a traversal mostly
+walks forward through memory.
+================================
+*/
+class BoundsTree {
+public:
+	BoundsTree() {}
+
+	// Builds the tree over num bounds, the ids are the indices into the array unless ids are given
+	void Build( const Bounds * bounds, const int num, const int * ids = NULL );
+	void Clear();
+
+	int GetNumItems() const { return (int)m_items.size(); }
+	Bounds GetBounds() const { return m_nodes.empty() ? Bounds() : m_nodes[ 0 ].bounds; }
+
+	// Calls callback( id ) for every item whose bounds overlap these.  The callback returns false to stop.
+	template< typename callback_t >
+	void QueryBounds( const Bounds & bounds, callback_t & callback ) const;
+
+	// Sweeps the bounds from where they are by translation, and calls callback( id, maxFraction ) for
+	// every item they pass through before maxFraction, roughly nearest first.  The callback can lower
+	// maxFraction to cut the sweep short, and returns false to stop.  Bounds of zero size cast a ray.
+	template< typename callback_t >
+	void CastBounds( const Bounds & bounds, const Vec3 & translation, float maxFraction, callback_t & callback ) const;
+
+	static const int MAX_LEAF_ITEMS = 4;
+	static const int MAX_DEPTH = 64;
+
+private:
+	struct node_t {
+		Bounds bounds;
+		int right;		// index of the second child, the first follows this node.  -1 for a leaf.
+		int firstItem;	// index into m_items, for leaves
+		int numItems;
+	};
+
+	struct buildItem_t {
+		Bounds bounds;
+		Vec3 center;
+		int id;
+	};
+
+	int BuildNode( const int first, const int num, const int depth );
+	static bool RayBounds( const Vec3 & start, const Vec3 & invDir, const Bounds & bounds, const float maxFraction, float & tEnter );
+
+	std::vector< node_t > m_nodes;
+	std::vector< int > m_items;				// ids in leaf order
+	std::vector< Bounds > m_itemBounds;		// the bounds of each entry in m_items
+	std::vector< buildItem_t > m_buildItems;	// scratch for Build
+};
+
+/*
+====================================================
+BoundsTree::QueryBounds
+====================================================
+*/
+template< typename callback_t >
+inline void BoundsTree::QueryBounds( const Bounds & bounds, callback_t & callback ) const {
+	if ( m_nodes.empty() ) {
+		return;
+	}
+
+	int stack[ MAX_DEPTH * 2 ];
+	int numStack = 0;
+	stack[ numStack++ ] = 0;
+	while ( numStack > 0 ) {
+		const int nodeIdx = stack[ --numStack ];
+		const node_t & node = m_nodes[ nodeIdx ];
+		if ( !node.bounds.DoesIntersect( bounds ) ) {
+			continue;
+		}
+
+		if ( node.right < 0 ) {
+			for ( int i = node.firstItem; i < node.firstItem + node.numItems; i++ ) {
+				if ( m_itemBounds[ i ].DoesIntersect( bounds ) && !callback( m_items[ i ] ) ) {
+					return;
+				}
+			}
+			continue;
+		}
+
+		stack[ numStack++ ] = node.right;
+		stack[ numStack++ ] = nodeIdx + 1;
+	}
+}
+
+/*
+====================================================
+BoundsTree::CastBounds
+Sweeping bounds against a box is the same as casting their center against the box grown by their
+half size, so the traversal is a ray cast against grown node bounds
+====================================================
+*/
+template< typename callback_t >
+inline void BoundsTree::CastBounds( const Bounds & bounds, const Vec3 & translation, float maxFraction, callback_t & callback ) const {
+	if ( m_nodes.empty() ) {
+		return;
+	}
+
+	const Vec3 rayStart = ( bounds.mins + bounds.maxs ) * 0.5f;
+	const Vec3 halfSize = ( bounds.maxs - bounds.mins ) * 0.5f;
+
+	// Axes the ray doesn't move along get a huge inverse, so the slab test only checks the start
+	Vec3 invDir;
+	for ( int i = 0; i < 3; i++ ) {
+		invDir[ i ] = ( fabsf( translation[ i ] ) > 1e-20f ) ? 1.0f / translation[ i ] : 1e20f;
+	}
+
+	int stack[ MAX_DEPTH * 2 ];
+	int numStack = 0;
+	stack[ numStack++ ] = 0;
+	while ( numStack > 0 ) {
+		const int nodeIdx = stack[ --numStack ];
+		const node_t & node = m_nodes[ nodeIdx ];
+
+		Bounds grown = node.bounds;
+		grown.mins -= halfSize;
+		grown.maxs += halfSize;
+		float tEnter;
+		if ( !RayBounds( rayStart, invDir, grown, maxFraction, tEnter ) ) {
+			continue;
+		}
+
+		if ( node.right < 0 ) {
+			for ( int i = node.firstItem; i < node.firstItem + node.numItems; i++ ) {
+				Bounds item = m_itemBounds[ i ];
+				item.mins -= halfSize;
+				item.maxs += halfSize;
+				if ( !RayBounds( rayStart, invDir, item, maxFraction, tEnter ) ) {
+					continue;
+				}
+				if ( !callback( m_items[ i ], maxFraction ) ) {
+					return;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first, so the closest hit is found early and cuts the rest short
+		const node_t & first = m_nodes[ nodeIdx + 1 ];
+		const node_t & second = m_nodes[ node.right ];
+		const Vec3 firstCenter = ( first.bounds.mins + first.bounds.maxs ) * 0.5f;
+		const Vec3 secondCenter = ( second.bounds.mins + second.bounds.maxs ) * 0.5f;
+		if ( translation.Dot( firstCenter ) <= translation.Dot( secondCenter ) ) {
+			stack[ numStack++ ] = node.right;
+			stack[ numStack++ ] = nodeIdx + 1;
+		} else {
+			stack[ numStack++ ] = nodeIdx + 1;
+			stack[ numStack++ ] = node.right;
+		}
+	}
+}
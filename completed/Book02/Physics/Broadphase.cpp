@@ -2,12 +2,7 @@
 //  Broadphase.cpp
 //
 #include "Broadphase.h"
-
-struct psuedoBody_t {
-	int id;
-	float value;
-	bool ismin;
-};
+#include <algorithm>
 
 /*
 ====================================================
@@ -21,7 +16,38 @@ int CompareSAP( const void * a, const void * b ) {
 	if ( ea->value < eb->value ) {
 		return -1;
 	}
-	return 1;
+	if ( ea->value > eb->value ) {
+		return 1;
+	}
+
+	// Break ties so the sort order doesn't depend on the qsort implementation.
+	// Mins go first so touching bounds still count as overlapping.
+	if ( ea->ismin != eb->ismin ) {
+		return ea->ismin ? -1 : 1;
+	}
+	if ( ea->id != eb->id ) {
+		return ( ea->id < eb->id ) ? -1 : 1;
+	}
+	return 0;
+}
+
+/*
+====================================================
+GetSweptBounds
+The body's bounds grown to cover where it moves during the step, plus a little
+====================================================
+*/
+static Bounds GetSweptBounds( const Body & body, const float dt_sec ) {
+	Bounds bounds = body.m_shape->GetBounds( body.m_position, body.m_orientation );
+
+	// Expand the bounds by the linear velocity
+	bounds.Expand( bounds.mins + body.m_linearVelocity * dt_sec );
+	bounds.Expand( bounds.maxs + body.m_linearVelocity * dt_sec );
+
+	const float epsilon = 0.01f;
+	bounds.Expand( bounds.mins + Vec3(-1,-1,-1 ) * epsilon );
+	bounds.Expand( bounds.maxs + Vec3( 1, 1, 1 ) * epsilon );
+	return bounds;
 }
 
 /*
@@ -29,28 +55,17 @@ int CompareSAP( const void * a, const void * b ) {
 SortBodiesBounds
 ====================================================
 */
-void SortBodiesBounds( const Body * bodies, const int num, psuedoBody_t * sortedArray, const float dt_sec ) {
+void SortBodiesBounds( const Bounds * bounds, const int * ids, const int num, psuedoBody_t * sortedArray ) {
 	Vec3 axis = Vec3( 1, 1, 1 );
 	axis.Normalize();
 
 	for ( int i = 0; i < num; i++ ) {
-		const Body & body = bodies[ i ];
-		Bounds bounds = body.m_shape->GetBounds( body.m_position, body.m_orientation );
-
-		// Expand the bounds by the linear velocity
-		bounds.Expand( bounds.mins + body.m_linearVelocity * dt_sec );
-		bounds.Expand( bounds.maxs + body.m_linearVelocity * dt_sec );
-
-		const float epsilon = 0.01f;
-		bounds.Expand( bounds.mins + Vec3(-1,-1,-1 ) * epsilon );
-		bounds.Expand( bounds.maxs + Vec3( 1, 1, 1 ) * epsilon );
-
-		sortedArray[ i * 2 + 0 ].id = i;
-		sortedArray[ i * 2 + 0 ].value = axis.Dot( bounds.mins );
+		sortedArray[ i * 2 + 0 ].id = ids[ i ];
+		sortedArray[ i * 2 + 0 ].value = axis.Dot( bounds[ i ].mins );
 		sortedArray[ i * 2 + 0 ].ismin = true;
 
-		sortedArray[ i * 2 + 1 ].id = i;
-		sortedArray[ i * 2 + 1 ].value = axis.Dot( bounds.maxs );
+		sortedArray[ i * 2 + 1 ].id = ids[ i ];
+		sortedArray[ i * 2 + 1 ].value = axis.Dot( bounds[ i ].maxs );
 		sortedArray[ i * 2 + 1 ].ismin = false;
 	}
 
@@ -59,12 +74,24 @@ void SortBodiesBounds( const Body * bodies, const int num, psuedoBody_t * sorted
 
 /*
 ====================================================
-BuildPairs
+IsExcluded
 ====================================================
 */
-void BuildPairs( std::vector< collisionPair_t > & collisionPairs, const psuedoBody_t * sortedBodies, const int num ) {
-	collisionPairs.clear();
+static bool IsExcluded( const collisionPair_t * excludedPairs, const int numExcluded, const collisionPair_t & pair ) {
+	collisionPair_t key;
+	key.a = std::min( pair.a, pair.b );
+	key.b = std::max( pair.a, pair.b );
+	return std::binary_search( excludedPairs, excludedPairs + numExcluded, key, []( const collisionPair_t & lhs, const collisionPair_t & rhs ) {
+		return ( lhs.a != rhs.a ) ? ( lhs.a < rhs.a ) : ( lhs.b < rhs.b );
+	} );
+}
 
+/*
+====================================================
+BuildPairs
+====================================================
+*/
+void BuildPairs( std::vector< collisionPair_t > & collisionPairs, const Body * bodies, const psuedoBody_t * sortedBodies, const int num, const collisionPair_t * excludedPairs, const int numExcluded ) {
 	// Now that the bodies are sorted, build the collision pairs
 	for ( int i = 0; i < num * 2; i++ ) {
 		const psuedoBody_t & a = sortedBodies[ i ];
@@ -73,7 +100,7 @@ void BuildPairs( std::vector< collisionPair_t > & collisionPairs, const psuedoBo
 		}
 
 		collisionPair_t pair;
-		pair.a = a.id;		
+		pair.a = a.id;
 
 		for ( int j = i + 1; j < num * 2; j++ ) {
 			const psuedoBody_t & b = sortedBodies[ j ];
@@ -86,7 +113,14 @@ void BuildPairs( std::vector< collisionPair_t > & collisionPairs, const psuedoBo
 				continue;
 			}
 
+			if ( !CanCollide( bodies[ a.id ], bodies[ b.id ] ) ) {
+				continue;
+			}
+
 			pair.b = b.id;
+			if ( numExcluded > 0 && IsExcluded( excludedPairs, numExcluded, pair ) ) {
+				continue;
+			}
 			collisionPairs.push_back( pair );
 		}
 	}
@@ -94,23 +128,130 @@ void BuildPairs( std::vector< collisionPair_t > & collisionPairs, const psuedoBo
 
 /*
 ====================================================
-SweepAndPrune1D
+Broadphase::HasStaticChanged
 ====================================================
 */
-void SweepAndPrune1D( const Body * bodies, const int num, std::vector< collisionPair_t > & finalPairs, const float dt_sec ) {
-	psuedoBody_t * sortedBodies = (psuedoBody_t *)alloca( sizeof( psuedoBody_t ) * num * 2 );
+bool Broadphase::HasStaticChanged( const Body * bodies, const int num ) const {
+	int numStatic = 0;
+	for ( int i = 0; i < num; i++ ) {
+		const Body & body = bodies[ i ];
+		if ( !IsStatic( body ) ) {
+			continue;
+		}
 
-	SortBodiesBounds( bodies, num, sortedBodies, dt_sec );
-	BuildPairs( finalPairs, sortedBodies, num );
+		if ( numStatic >= (int)m_staticBodies.size() ) {
+			return true;
+		}
+		const staticBody_t & old = m_staticBodies[ numStatic ];
+		if ( old.id != i || old.shape != body.m_shape || !( old.position == body.m_position ) ||
+			old.orientation.x != body.m_orientation.x || old.orientation.y != body.m_orientation.y ||
+			old.orientation.z != body.m_orientation.z || old.orientation.w != body.m_orientation.w ) {
+			return true;
+		}
+		numStatic++;
+	}
+	return ( numStatic != (int)m_staticBodies.size() );
 }
 
 /*
 ====================================================
-BroadPhase
+Broadphase::UpdateStatic
+Rebuilds the tree if the static bodies aren't the ones it was built from
 ====================================================
 */
-void BroadPhase( const Body * bodies, const int num, std::vector< collisionPair_t > & finalPairs, const float dt_sec ) {
+void Broadphase::UpdateStatic( const Body * bodies, const int num ) {
+	m_movingBodies.clear();
+	for ( int i = 0; i < num; i++ ) {
+		if ( !IsStatic( bodies[ i ] ) ) {
+			m_movingBodies.push_back( i );
+		}
+	}
+
+	if ( !HasStaticChanged( bodies, num ) ) {
+		return;
+	}
+
+	m_staticBodies.clear();
+	m_bounds.clear();
+	m_ids.clear();
+	for ( int i = 0; i < num; i++ ) {
+		const Body & body = bodies[ i ];
+		if ( !IsStatic( body ) ) {
+			continue;
+		}
+
+		staticBody_t staticBody;
+		staticBody.id = i;
+		staticBody.shape = body.m_shape;
+		staticBody.position = body.m_position;
+		staticBody.orientation = body.m_orientation;
+		m_staticBodies.push_back( staticBody );
+
+		m_bounds.push_back( GetSweptBounds( body, 0.0f ) );
+		m_ids.push_back( i );
+	}
+	m_staticTree.Build( m_bounds.data(), (int)m_bounds.size(), m_ids.data() );
+}
+
+/*
+====================================================
+Broadphase::Update
+====================================================
+*/
+void Broadphase::Update( const Body * bodies, const int num, std::vector< collisionPair_t > & finalPairs, const float dt_sec, const collisionPair_t * excludedPairs, const int numExcluded ) {
 	finalPairs.clear();
 
-	SweepAndPrune1D( bodies, num, finalPairs, dt_sec );
-}
\ No newline at end of file
+	UpdateStatic( bodies, num );
+
+	const int numMoving = (int)m_movingBodies.size();
+	m_bounds.resize( numMoving );
+	for ( int i = 0; i < numMoving; i++ ) {
+		m_bounds[ i ] = GetSweptBounds( bodies[ m_movingBodies[ i ] ], dt_sec );
+	}
+
+	// Moving against moving
+	m_sortedBodies.resize( numMoving * 2 );
+	SortBodiesBounds( m_bounds.data(), m_movingBodies.data(), numMoving, m_sortedBodies.data() );
+	BuildPairs( finalPairs, bodies, m_sortedBodies.data(), numMoving, excludedPairs, numExcluded );
+
+	// Moving against static
+	if ( m_staticBodies.empty() ) {
+		return;
+	}
+	for ( int i = 0; i < numMoving; i++ ) {
+		collisionPair_t pair;
+		pair.a = m_movingBodies[ i ];
+		auto callback = [ & ]( const int id ) {
+			if ( !CanCollide( bodies[ pair.a ], bodies[ id ] ) ) {
+				return true;
+			}
+			pair.b = id;
+			if ( numExcluded > 0 && IsExcluded( excludedPairs, numExcluded, pair ) ) {
+				return true;
+			}
+			finalPairs.push_back( pair );
+			return true;
+		};
+		m_staticTree.QueryBounds( m_bounds[ i ], callback );
+	}
+}
+
+/*
+====================================================
+Broadphase::Clear
+====================================================
+*/
+void Broadphase::Clear() {
+	m_staticBodies.clear();
+	m_staticTree.Clear();
+}
+
+/*
+====================================================
+BroadPhase
+====================================================
+*/
+void BroadPhase( const Body * bodies, const int num, std::vector< collisionPair_t > & finalPairs, const float dt_sec, const collisionPair_t * excludedPairs, const int numExcluded ) {
+	Broadphase broadphase;
+	broadphase.Update( bodies, num, finalPairs, dt_sec, excludedPairs, numExcluded );
+}
@@ -3,6 +3,7 @@
 //
 #pragma once
 #include "Body.h"
+#include "BoundsTree.h"
 #include <vector>
 
 
@@ -18,4 +19,76 @@ struct collisionPair_t {
 	}
 };
 
-void BroadPhase( const Body * bodies, const int num, std::vector< collisionPair_t > & finalPairs, const float dt_sec );
\ No newline at end of file
+/*
+====================================================
+CanCollide
+Whether the broadphase pairs the bodies at all, before their bounds are considered
+====================================================
+*/
+inline bool CanCollide( const Body & bodyA, const Body & bodyB ) {
+	// Bodies with infinite mass can't push each other
+	if ( 0.0f == bodyA.m_invMass && 0.0f == bodyB.m_invMass ) {
+		return false;
+	}
+	return ( 0 != ( bodyA.m_collisionLayer & bodyB.m_collisionMask ) ) && ( 0 != ( bodyB.m_collisionLayer & bodyA.m_collisionMask ) );
+}
+
+struct psuedoBody_t {
+	int id;
+	float value;
+	bool ismin;
+};
+
+/*
+====================================================
+Broadphase
+Bodies that aren't moving (no mass and no velocity, like the sand box walls) are kept in a
+BoundsTree that's only rebuilt when one of them is added, removed or moved.  Each update sorts and
+sweeps just the moving bodies to pair them with each other, and pairs each of them with the static
+bodies by querying the tree with its bounds.  Static bodies never pair with each other, so a large
+static world with a few movers costs little more than the movers.
+====================================================
+*/
+class Broadphase {
+public:
+	// Builds the pairs of bodies whose bounds overlap and that can collide.  The excluded pairs
+	// never collide either, they have a < b and are sorted by a then b.
+	void Update( const Body * bodies, const int num, std::vector< collisionPair_t > & finalPairs, const float dt_sec, const collisionPair_t * excludedPairs = NULL, const int numExcluded = 0 );
+	void Clear();
+
+	int GetNumStaticBodies() const { return (int)m_staticBodies.size(); }
+
+	// The static bodies' bounds as of the last update, the ids are the bodies' indices.  Only
+	// current while HasStaticChanged is false.
+	const BoundsTree & GetStaticTree() const { return m_staticTree; }
+
+	// Whether static bodies have been added, removed or moved since the tree was built
+	bool HasStaticChanged( const Body * bodies, const int num ) const;
+
+	// Bodies with no mass and no velocity, the ones kept in the static tree
+	static bool IsStatic( const Body & body ) {
+		return 0.0f == body.m_invMass && 0.0f == body.m_linearVelocity.GetLengthSqr() && 0.0f == body.m_angularVelocity.GetLengthSqr();
+	}
+
+private:
+	struct staticBody_t {
+		int id;
+		const Shape * shape;
+		Vec3 position;
+		Quat orientation;
+	};
+
+	void UpdateStatic( const Body * bodies, const int num );
+
+	std::vector< staticBody_t > m_staticBodies;	// as they were when the tree was built
+	BoundsTree m_staticTree;
+
+	// Scratch
+	std::vector< int > m_movingBodies;
+	std::vector< Bounds > m_bounds;
+	std::vector< int > m_ids;
+	std::vector< psuedoBody_t > m_sortedBodies;
+};
+
+// Builds the pairs from scratch, without keeping the static bodies between calls
+void BroadPhase( const Body * bodies, const int num, std::vector< collisionPair_t > & finalPairs, const float dt_sec, const collisionPair_t * excludedPairs = NULL, const int numExcluded = 0 );
\ No newline at end of file
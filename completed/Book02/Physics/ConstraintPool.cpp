@@ -0,0 +1,190 @@
+//
+//	ConstraintPool.cpp
+//
+#include "ConstraintPool.h"
+
+/*
+====================================================
+ConstraintPool::ConstraintPool
+====================================================
+*/
+ConstraintPool::ConstraintPool() {
+	m_pools[ Constraint::CONSTRAINT_DISTANCE ] = &m_distances;
+	m_pools[ Constraint::CONSTRAINT_HINGE_QUAT ] = &m_hinges;
+	m_pools[ Constraint::CONSTRAINT_HINGE_QUAT_LIMITED ] = &m_hingesLimited;
+	m_pools[ Constraint::CONSTRAINT_CONSTANT_VELOCITY ] = &m_constantVelocities;
+	m_pools[ Constraint::CONSTRAINT_CONSTANT_VELOCITY_LIMITED ] = &m_constantVelocitiesLimited;
+	m_pools[ Constraint::CONSTRAINT_MOTOR ] = &m_motors;
+	m_pools[ Constraint::CONSTRAINT_MOVER_SIMPLE ] = &m_movers;
+	m_pools[ Constraint::CONSTRAINT_ORIENTATION ] = &m_orientations;
+}
+
+/*
+====================================================
+ConstraintPool::Remove
+====================================================
+*/
+bool ConstraintPool::Remove( const constraintHandle_t & handle ) {
+	if ( NULL == Get( handle ) ) {
+		return false;
+	}
+
+	const int idx = m_slots[ handle.slot ].listIdx;
+	const int poolIdx = m_poolIdx[ idx ];
+	switch ( GetType( idx ) ) {
+		case Constraint::CONSTRAINT_DISTANCE: RemoveFromPool( m_distances, poolIdx ); break;
+		case Constraint::CONSTRAINT_HINGE_QUAT: RemoveFromPool( m_hinges, poolIdx ); break;
+		case Constraint::CONSTRAINT_HINGE_QUAT_LIMITED: RemoveFromPool( m_hingesLimited, poolIdx ); break;
+		case Constraint::CONSTRAINT_CONSTANT_VELOCITY: RemoveFromPool( m_constantVelocities, poolIdx ); break;
+		case Constraint::CONSTRAINT_CONSTANT_VELOCITY_LIMITED: RemoveFromPool( m_constantVelocitiesLimited, poolIdx ); break;
+		case Constraint::CONSTRAINT_MOTOR: RemoveFromPool( m_motors, poolIdx ); break;
+		case Constraint::CONSTRAINT_MOVER_SIMPLE: RemoveFromPool( m_movers, poolIdx ); break;
+		case Constraint::CONSTRAINT_ORIENTATION: RemoveFromPool( m_orientations, poolIdx ); break;
+		default: break;
+	}
+
+	// Move the last constraint in the list into the removed one's place
+	const int last = (int)m_constraints.size() - 1;
+	if ( idx != last ) {
+		m_constraints[ idx ] = m_constraints[ last ];
+		m_types[ idx ] = m_types[ last ];
+		m_poolIdx[ idx ] = m_poolIdx[ last ];
+		m_slotIdx[ idx ] = m_slotIdx[ last ];
+		m_slots[ m_slotIdx[ idx ] ].listIdx = idx;
+		m_pools[ m_types[ idx ] ]->listIdx[ m_poolIdx[ idx ] ] = idx;
+	}
+	m_constraints.pop_back();
+	m_types.pop_back();
+	m_poolIdx.pop_back();
+	m_slotIdx.pop_back();
+
+	m_slots[ handle.slot ].listIdx = -1;
+	m_slots[ handle.slot ].generation++;
+	m_freeSlots.push_back( handle.slot );
+	return true;
+}
+
+/*
+====================================================
+ConstraintPool::Clear
+====================================================
+*/
+void ConstraintPool::Clear() {
+	Free( m_distances );
+	Free( m_hinges );
+	Free( m_hingesLimited );
+	Free( m_constantVelocities );
+	Free( m_constantVelocitiesLimited );
+	Free( m_motors );
+	Free( m_movers );
+	Free( m_orientations );
+
+	m_constraints.clear();
+	m_types.clear();
+	m_poolIdx.clear();
+	m_slotIdx.clear();
+
+	// Keep the slots so that handles from before stay stale
+	m_freeSlots.clear();
+	for ( int i = (int)m_slots.size() - 1; i >= 0; i-- ) {
+		if ( m_slots[ i ].listIdx >= 0 ) {
+			m_slots[ i ].listIdx = -1;
+			m_slots[ i ].generation++;
+		}
+		m_freeSlots.push_back( i );
+	}
+}
+
+/*
+====================================================
+ConstraintPool::GetHandle
+====================================================
+*/
+constraintHandle_t ConstraintPool::GetHandle( const int idx ) const {
+	constraintHandle_t handle;
+	handle.slot = m_slotIdx[ idx ];
+	handle.generation = m_slots[ handle.slot ].generation;
+	return handle;
+}
+
+/*
+====================================================
+ConstraintPool::Get
+====================================================
+*/
+Constraint * ConstraintPool::Get( const constraintHandle_t & handle ) const {
+	if ( handle.slot < 0 || handle.slot >= (int)m_slots.size() ) {
+		return NULL;
+	}
+	const slot_t & slot = m_slots[ handle.slot ];
+	if ( slot.generation != handle.generation || slot.listIdx < 0 ) {
+		return NULL;
+	}
+	return m_constraints[ slot.listIdx ];
+}
+
+/*
+====================================================
+ConstraintPool::PreSolve
+====================================================
+*/
+void ConstraintPool::PreSolve( const float dt_sec, solverContext_t & context ) {
+	PreSolvePool( m_distances, dt_sec, context );
+	PreSolvePool( m_hinges, dt_sec, context );
+	PreSolvePool( m_hingesLimited, dt_sec, context );
+	PreSolvePool( m_constantVelocities, dt_sec, context );
+	PreSolvePool( m_constantVelocitiesLimited, dt_sec, context );
+	PreSolvePool( m_motors, dt_sec, context );
+	PreSolvePool( m_movers, dt_sec, context );
+	PreSolvePool( m_orientations, dt_sec, context );
+}
+
+/*
+====================================================
+ConstraintPool::PostSolve
+====================================================
+*/
+void ConstraintPool::PostSolve() {
+	PostSolvePool( m_distances );
+	PostSolvePool( m_hinges );
+	PostSolvePool( m_hingesLimited );
+	PostSolvePool( m_constantVelocities );
+	PostSolvePool( m_constantVelocitiesLimited );
+	PostSolvePool( m_motors );
+	PostSolvePool( m_movers );
+	PostSolvePool( m_orientations );
+}
+
+/*
+====================================================
+ConstraintPool::Solve
+====================================================
+*/
+void ConstraintPool::Solve( const int * indices, const int num, solverContext_t & context ) const {
+	int first = 0;
+	while ( first < num ) {
+		const Constraint::constraintType_t type = GetType( indices[ first ] );
+		int end = first + 1;
+		while ( end < num && GetType( indices[ end ] ) == type ) {
+			end++;
+		}
+
+		switch ( type ) {
+			case Constraint::CONSTRAINT_DISTANCE: SolveRun< ConstraintDistance >( indices + first, end - first, context ); break;
+			case Constraint::CONSTRAINT_HINGE_QUAT: SolveRun< ConstraintHingeQuat >( indices + first, end - first, context ); break;
+			case Constraint::CONSTRAINT_HINGE_QUAT_LIMITED: SolveRun< ConstraintHingeQuatLimited >( indices + first, end - first, context ); break;
+			case Constraint::CONSTRAINT_CONSTANT_VELOCITY: SolveRun< ConstraintConstantVelocity >( indices + first, end - first, context ); break;
+			case Constraint::CONSTRAINT_CONSTANT_VELOCITY_LIMITED: SolveRun< ConstraintConstantVelocityLimited >( indices + first, end - first, context ); break;
+			case Constraint::CONSTRAINT_MOTOR: SolveRun< ConstraintMotor >( indices + first, end - first, context ); break;
+			case Constraint::CONSTRAINT_MOVER_SIMPLE: SolveRun< ConstraintMoverSimple >( indices + first, end - first, context ); break;
+			case Constraint::CONSTRAINT_ORIENTATION: SolveRun< ConstraintOrientation >( indices + first, end - first, context ); break;
+			default: {
+				for ( int i = first; i < end; i++ ) {
+					m_constraints[ indices[ i ] ]->Solve( context );
+				}
+				break;
+			}
+		}
+		first = end;
+	}
+}
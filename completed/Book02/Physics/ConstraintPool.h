@@ -0,0 +1,275 @@
+//
+//	ConstraintPool.h
+//
+#pragma once
+#include "Constraints.h"
+#include <vector>
+#include <new>
+
+/*
+====================================================
+constraintHandle_t
+Refers to a constraint for as long as it exists.  Removing the constraint invalidates the handle,
+and a handle to a removed constraint never finds the constraint that later reuses its slot.
+====================================================
+*/
+struct constraintHandle_t {
+	int slot;
+	int generation;
+};
+
+/*
+================================
+ConstraintPool
+Owns the scene's constraints.  Each type has its own pool of fixed size blocks, so constraints of
+one type sit next to each other in memory, and the solver passes run over one pool after the other
+with direct calls instead of a virtual call per constraint.
+
+The constraints are also kept in one dense list, which is how the rest of the scene refers to them
+(islands, scene files and snapshots all index them in that order).  Removing a constraint moves the
+last one of its type into its place in the pool, and the last one in the list into its place in
+the list, so both stay dense.  Pointers to constraints are only good until the next Remove, keep a
+handle to refer to a constraint for longer.
+
+Removed constraints aren't destroyed, the next Create of the same type resets one from a default
+constructed prototype, so once the pools have grown adding and removing constraints doesn't touch
+the heap.
+================================
+*/
+class ConstraintPool {
+public:
+	ConstraintPool();
+	~ConstraintPool() { Clear(); }
+
+	ConstraintPool( const ConstraintPool & rhs ) = delete;
+	ConstraintPool & operator = ( const ConstraintPool & rhs ) = delete;
+
+	// Default constructs a constraint in its type's pool and adds it to the end of the list
+	template< typename T > T * Create( constraintHandle_t * handle = NULL );
+
+	// Removes the constraint in O(1), returns false if the handle is stale
+	bool Remove( const constraintHandle_t & handle );
+
+	// Destroys every constraint and invalidates every handle
+	void Clear();
+
+	int size() const { return (int)m_constraints.size(); }
+	Constraint * operator[]( const int idx ) const { return m_constraints[ idx ]; }
+	Constraint * const * data() const { return m_constraints.data(); }
+	Constraint::constraintType_t GetType( const int idx ) const { return (Constraint::constraintType_t)m_types[ idx ]; }
+
+	// Handles of the listed constraints, and the constraint a handle refers to (NULL if it's been removed)
+	constraintHandle_t GetHandle( const int idx ) const;
+	Constraint * Get( const constraintHandle_t & handle ) const;
+	bool IsValid( const constraintHandle_t & handle ) const { return NULL != Get( handle ); }
+
+	void PreSolve( const float dt_sec, solverContext_t & context );
+	void PostSolve();
+
+	// Solves the listed constraints in the order given.  Runs of the same type are solved
+	// together, so lists should keep constraints of one type next to each other.
+	void Solve( const int * indices, const int num, solverContext_t & context ) const;
+
+	static const int BLOCK_SIZE = 64;
+	static const int NUM_TYPES = Constraint::CONSTRAINT_ORIENTATION + 1;	// the types that can be created
+
+private:
+	struct poolBase_t {
+		poolBase_t() : count( 0 ), numConstructed( 0 ) {}
+		int count;				// live constraints
+		int numConstructed;		// live and removed constraints, removed ones are reused by Create
+		std::vector< int > listIdx;	// index into the list of each live constraint
+	};
+
+	template< typename T >
+	struct pool_t : public poolBase_t {
+		std::vector< T * > blocks;	// each has room for BLOCK_SIZE constraints
+		T prototype;				// copied over removed constraints to reuse them
+
+		T & operator[]( const int idx ) { return blocks[ idx / BLOCK_SIZE ][ idx % BLOCK_SIZE ]; }
+	};
+
+	struct slot_t {
+		int listIdx;	// -1 while free
+		int generation;
+	};
+
+	template< typename T > static T * Allocate( pool_t< T > & pool );
+	template< typename T > void RemoveFromPool( pool_t< T > & pool, const int idx );
+	template< typename T > static void Free( pool_t< T > & pool );
+	template< typename T > static void PreSolvePool( pool_t< T > & pool, const float dt_sec, solverContext_t & context );
+	template< typename T > static void PostSolvePool( pool_t< T > & pool );
+	template< typename T > void SolveRun( const int * indices, const int num, solverContext_t & context ) const;
+
+	pool_t< ConstraintDistance > & GetPool( const ConstraintDistance * ) { return m_distances; }
+	pool_t< ConstraintHingeQuat > & GetPool( const ConstraintHingeQuat * ) { return m_hinges; }
+	pool_t< ConstraintHingeQuatLimited > & GetPool( const ConstraintHingeQuatLimited * ) { return m_hingesLimited; }
+	pool_t< ConstraintConstantVelocity > & GetPool( const ConstraintConstantVelocity * ) { return m_constantVelocities; }
+	pool_t< ConstraintConstantVelocityLimited > & GetPool( const ConstraintConstantVelocityLimited * ) { return m_constantVelocitiesLimited; }
+	pool_t< ConstraintMotor > & GetPool( const ConstraintMotor * ) { return m_motors; }
+	pool_t< ConstraintMoverSimple > & GetPool( const ConstraintMoverSimple * ) { return m_movers; }
+	pool_t< ConstraintOrientation > & GetPool( const ConstraintOrientation * ) { return m_orientations; }
+
+	pool_t< ConstraintDistance > m_distances;
+	pool_t< ConstraintHingeQuat > m_hinges;
+	pool_t< ConstraintHingeQuatLimited > m_hingesLimited;
+	pool_t< ConstraintConstantVelocity > m_constantVelocities;
+	pool_t< ConstraintConstantVelocityLimited > m_constantVelocitiesLimited;
+	pool_t< ConstraintMotor > m_motors;
+	pool_t< ConstraintMoverSimple > m_movers;
+	pool_t< ConstraintOrientation > m_orientations;
+	poolBase_t * m_pools[ NUM_TYPES ];	// the pools above by constraint type
+
+	// The list, one entry per live constraint
+	std::vector< Constraint * > m_constraints;
+	std::vector< unsigned char > m_types;	// GetType of each constraint, without the virtual call
+	std::vector< int > m_poolIdx;			// index into its type's pool
+	std::vector< int > m_slotIdx;			// index into m_slots
+
+	std::vector< slot_t > m_slots;
+	std::vector< int > m_freeSlots;
+};
+
+/*
+====================================================
+ConstraintPool::Create
+====================================================
+*/
+template< typename T >
+inline T * ConstraintPool::Create( constraintHandle_t * handle ) {
+	pool_t< T > & pool = GetPool( (const T *)NULL );
+	const int poolIdx = pool.count;
+	T * constraint = Allocate( pool );
+	pool.listIdx.push_back( (int)m_constraints.size() );
+
+	int slot;
+	if ( !m_freeSlots.empty() ) {
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	} else {
+		slot = (int)m_slots.size();
+		slot_t newSlot;
+		newSlot.generation = 0;
+		m_slots.push_back( newSlot );
+	}
+	m_slots[ slot ].listIdx = (int)m_constraints.size();
+
+	m_constraints.push_back( constraint );
+	m_types.push_back( (unsigned char)constraint->GetType() );
+	m_poolIdx.push_back( poolIdx );
+	m_slotIdx.push_back( slot );
+
+	if ( NULL != handle ) {
+		handle->slot = slot;
+		handle->generation = m_slots[ slot ].generation;
+	}
+	return constraint;
+}
+
+/*
+====================================================
+ConstraintPool::Allocate
+====================================================
+*/
+template< typename T >
+inline T * ConstraintPool::Allocate( pool_t< T > & pool ) {
+	T * constraint;
+	if ( pool.count < pool.numConstructed ) {
+		constraint = &pool[ pool.count ];
+		*constraint = pool.prototype;
+	} else {
+		if ( pool.numConstructed == (int)pool.blocks.size() * BLOCK_SIZE ) {
+			pool.blocks.push_back( (T *)::operator new( sizeof( T ) * BLOCK_SIZE ) );
+		}
+		constraint = new ( &pool[ pool.numConstructed ] ) T();
+		pool.numConstructed++;
+	}
+	pool.count++;
+	return constraint;
+}
+
+/*
+====================================================
+ConstraintPool::RemoveFromPool
+Moves the pool's last constraint into the removed one's place
+====================================================
+*/
+template< typename T >
+inline void ConstraintPool::RemoveFromPool( pool_t< T > & pool, const int idx ) {
+	const int last = pool.count - 1;
+	if ( idx != last ) {
+		pool[ idx ] = pool[ last ];
+
+		const int movedListIdx = pool.listIdx[ last ];
+		pool.listIdx[ idx ] = movedListIdx;
+		m_constraints[ movedListIdx ] = &pool[ idx ];
+		m_poolIdx[ movedListIdx ] = idx;
+	}
+	pool.listIdx.pop_back();
+	pool.count--;
+}
+
+/*
+====================================================
+ConstraintPool::Free
+====================================================
+*/
+template< typename T >
+inline void ConstraintPool::Free( pool_t< T > & pool ) {
+	for ( int i = 0; i < pool.numConstructed; i++ ) {
+		pool[ i ].~T();
+	}
+	for ( int i = 0; i < pool.blocks.size(); i++ ) {
+		::operator delete( pool.blocks[ i ] );
+	}
+	pool.blocks.clear();
+	pool.listIdx.clear();
+	pool.count = 0;
+	pool.numConstructed = 0;
+}
+
+/*
+====================================================
+ConstraintPool::PreSolvePool
+The qualified calls name the final override, so they aren't dispatched through the vtable
+====================================================
+*/
+template< typename T >
+inline void ConstraintPool::PreSolvePool( pool_t< T > & pool, const float dt_sec, solverContext_t & context ) {
+	for ( int b = 0; b * BLOCK_SIZE < pool.count; b++ ) {
+		T * block = pool.blocks[ b ];
+		const int num = ( pool.count - b * BLOCK_SIZE < BLOCK_SIZE ) ? pool.count - b * BLOCK_SIZE : BLOCK_SIZE;
+		for ( int i = 0; i < num; i++ ) {
+			block[ i ].T::PreSolve( dt_sec, context );
+		}
+	}
+}
+
+/*
+====================================================
+ConstraintPool::PostSolvePool
+====================================================
+*/
+template< typename T >
+inline void ConstraintPool::PostSolvePool( pool_t< T > & pool ) {
+	for ( int b = 0; b * BLOCK_SIZE < pool.count; b++ ) {
+		T * block = pool.blocks[ b ];
+		const int num = ( pool.count - b * BLOCK_SIZE < BLOCK_SIZE ) ? pool.count - b * BLOCK_SIZE : BLOCK_SIZE;
+		for ( int i = 0; i < num; i++ ) {
+			block[ i ].T::PostSolve();
+		}
+	}
+}
+
+/*
+====================================================
+ConstraintPool::SolveRun
+====================================================
+*/
+template< typename T >
+inline void ConstraintPool::SolveRun( const int * indices, const int num, solverContext_t & context ) const {
+	for ( int i = 0; i < num; i++ ) {
+		T * constraint = static_cast< T * >( m_constraints[ indices[ i ] ] );
+		constraint->T::Solve( context );
+	}
+}
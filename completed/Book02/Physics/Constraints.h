@@ -4,6 +4,7 @@
 #pragma once
 #include "Constraints/ConstraintConstantVelocity.h"
 #include "Constraints/ConstraintDistance.h"
+#include "Constraints/ConstraintFriction.h"
 #include "Constraints/ConstraintHinge.h"
 #include "Constraints/ConstraintMotor.h"
 #include "Constraints/ConstraintMover.h"
@@ -9,6 +9,41 @@
 #include "../../Math/LCP.h"
 #include "../Body.h"
 #include <vector>
+#include <string.h>
+
+struct physicsStats_t;
+
+/*
+====================================================
+solverContext_t
+The settings and running totals of one scene's solve.  The scene passes its own down to every
+constraint and manifold, so scenes updating on different threads don't share any solver state.
+====================================================
+*/
+struct solverContext_t {
+	// Scales the Baumgarte stabilization of every constraint.  Substepping sets it to
+	// 1 / numSubsteps, so that each substep corrects its share of the error and the error
+	// is corrected at the same rate per update as without substeps.
+	float baumgarteScale;
+
+	// When set the contacts' velocity solve ignores the Baumgarte bias and their penetration is
+	// corrected by SolvePositions instead (see Scene::m_useSplitImpulse).  Joints keep theirs.
+	bool useSplitImpulse;
+
+	// Manifolds solve the normal impulses of all their contacts together instead of one after
+	// the other (see ConstraintPenetration::SolveNormalBlock and Scene::m_useBlockSolver)
+	bool useBlockSolver;
+
+	// Manifolds have friction as a whole instead of for each contact (see ConstraintFriction and
+	// Scene::m_useManifoldFriction)
+	bool useManifoldFriction;
+
+	// Largest linear or angular impulse (squared) applied through ApplyImpulses since it was
+	// last cleared, the scene uses it to tell when the solver has converged
+	float maxImpulseSqr;
+
+	physicsStats_t * stats;	// counters of the update being solved, NULL counts nothing
+};
 
 /*
 ====================================================
@@ -17,17 +52,64 @@ Constraint
 */
 class Constraint {
 public:
-	virtual void PreSolve( const float dt_sec ) {}
-	virtual void Solve() {}
+	Constraint() : m_bodyA( NULL ), m_bodyB( NULL ), m_breakImpulse( 0.0f ), m_disableCollision( false ) {}
+	virtual ~Constraint() {}
+
+	enum constraintType_t {
+		CONSTRAINT_DISTANCE,
+		CONSTRAINT_HINGE_QUAT,
+		CONSTRAINT_HINGE_QUAT_LIMITED,
+		CONSTRAINT_CONSTANT_VELOCITY,
+		CONSTRAINT_CONSTANT_VELOCITY_LIMITED,
+		CONSTRAINT_MOTOR,
+		CONSTRAINT_MOVER_SIMPLE,
+		CONSTRAINT_ORIENTATION,
+		CONSTRAINT_PENETRATION,
+		CONSTRAINT_FRICTION,
+	};
+	virtual constraintType_t GetType() const = 0;
+
+	// Solver state that carries over between frames (warm starting accumulators), used by scene snapshots
+	virtual int GetStateSize() const { return 0; }
+	virtual void SaveState( float * state ) const {}
+	virtual void RestoreState( const float * state ) {}
+
+	virtual void PreSolve( const float dt_sec, solverContext_t & context ) {}
+	virtual void Solve( solverContext_t & context ) {}
 	virtual void PostSolve() {}
 
+	// Split impulse position pass of the contacts, run after the velocity iterations.  Solves the
+	// penetration into the bodies' pseudo velocities so that correcting it doesn't add energy to
+	// the real ones.
+	virtual void SolvePositions() {}
+
+	// Direct joint solver (see JointTree).  Writes the rows of the joint that must hold exactly,
+	// J * v = -bias, and returns how many there are.  Joints that return zero stay with Solve.
+	static const int MAX_JOINT_ROWS = 6;
+	virtual int GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const { return 0; }
+
+	// Angle limits are inequalities, so while one is being pushed against the joint's own Solve
+	// has to run after the direct solve
+	virtual bool HasActiveLimits() const { return false; }
+
+	// Linear impulse applied to bodyB by the accumulated Lagrange multipliers, that is over the
+	// whole substep once the iterations are done.  Joints without accumulators return zero.
+	virtual Vec3 GetAccumulatedImpulse() const { return Vec3( 0.0f ); }
+
 	static Mat4 Left( const Quat & q );
 	static Mat4 Right( const Quat & q );
 
 protected:
 	MatMN GetInverseMassMatrix() const;
 	VecN GetVelocities() const;
-	void ApplyImpulses( const VecN & impulses );
+	void ApplyImpulses( const VecN & impulses, solverContext_t & context );
+
+	VecN GetPseudoVelocities() const;
+	void ApplyPseudoImpulses( const VecN & impulses );
+
+	int GetAnchorRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const;
+	int AddJacobianRows( const MatMN & src, const int first, const int num, float jacobian[][ 12 ], float * bias, const int numRows ) const;
+	Vec3 GetLinearImpulseB( const MatMN & jacobian, const VecN & lambda ) const;
 
 public:
 	Body * m_bodyA;
@@ -38,6 +120,14 @@ public:
 
 	Vec3 m_anchorB;		// The anchor location in bodyB's space
 	Vec3 m_axisB;		// The axis direction in bodyB's space
+
+	// The joint breaks when its impulse summed over all the substeps of a step is larger than
+	// this (see Scene::m_brokenConstraints).  Zero never breaks.
+	float m_breakImpulse;
+
+	// The broadphase never pairs the two bodies, for joints whose bodies overlap where they meet,
+	// like ragdoll limbs, and would otherwise push against the joint
+	bool m_disableCollision;
 };
 
 /*
@@ -106,7 +196,7 @@ inline VecN Constraint::GetVelocities() const {
 Constraint::ApplyImpulses
 ====================================================
 */
-inline void Constraint::ApplyImpulses( const VecN & impulses ) {
+inline void Constraint::ApplyImpulses( const VecN & impulses, solverContext_t & context ) {
 	Vec3 forceInternalA( 0.0f );
 	Vec3 torqueInternalA( 0.0f );
 	Vec3 forceInternalB( 0.0f );
@@ -128,6 +218,14 @@ inline void Constraint::ApplyImpulses( const VecN & impulses ) {
 	torqueInternalB[ 1 ] = impulses[ 10];
 	torqueInternalB[ 2 ] = impulses[ 11];
 
+	const float impulseSqr[ 4 ] = {
+		forceInternalA.GetLengthSqr(), torqueInternalA.GetLengthSqr(),
+		forceInternalB.GetLengthSqr(), torqueInternalB.GetLengthSqr()
+	};
+	for ( int i = 0; i < 4; i++ ) {
+		context.maxImpulseSqr = ( impulseSqr[ i ] > context.maxImpulseSqr ) ? impulseSqr[ i ] : context.maxImpulseSqr;
+	}
+
 	m_bodyA->ApplyImpulseLinear( forceInternalA );
 	m_bodyA->ApplyImpulseAngular( torqueInternalA );
 
@@ -135,6 +233,118 @@ inline void Constraint::ApplyImpulses( const VecN & impulses ) {
 	m_bodyB->ApplyImpulseAngular( torqueInternalB );
 }
 
+/*
+====================================================
+Constraint::GetPseudoVelocities
+====================================================
+*/
+inline VecN Constraint::GetPseudoVelocities() const {
+	VecN q_dt( 12 );
+
+	q_dt[ 0 ] = m_bodyA->m_pseudoLinearVelocity.x;
+	q_dt[ 1 ] = m_bodyA->m_pseudoLinearVelocity.y;
+	q_dt[ 2 ] = m_bodyA->m_pseudoLinearVelocity.z;
+
+	q_dt[ 3 ] = m_bodyA->m_pseudoAngularVelocity.x;
+	q_dt[ 4 ] = m_bodyA->m_pseudoAngularVelocity.y;
+	q_dt[ 5 ] = m_bodyA->m_pseudoAngularVelocity.z;
+
+	q_dt[ 6 ] = m_bodyB->m_pseudoLinearVelocity.x;
+	q_dt[ 7 ] = m_bodyB->m_pseudoLinearVelocity.y;
+	q_dt[ 8 ] = m_bodyB->m_pseudoLinearVelocity.z;
+
+	q_dt[ 9 ] = m_bodyB->m_pseudoAngularVelocity.x;
+	q_dt[ 10] = m_bodyB->m_pseudoAngularVelocity.y;
+	q_dt[ 11] = m_bodyB->m_pseudoAngularVelocity.z;
+
+	return q_dt;
+}
+
+/*
+====================================================
+Constraint::ApplyPseudoImpulses
+The same as ApplyImpulses, but into the pseudo velocities
+====================================================
+*/
+inline void Constraint::ApplyPseudoImpulses( const VecN & impulses ) {
+	Body * bodies[ 2 ] = { m_bodyA, m_bodyB };
+	for ( int i = 0; i < 2; i++ ) {
+		Body * body = bodies[ i ];
+		if ( 0.0f == body->m_invMass ) {
+			continue;
+		}
+
+		const Vec3 linear( impulses[ i * 6 + 0 ], impulses[ i * 6 + 1 ], impulses[ i * 6 + 2 ] );
+		const Vec3 angular( impulses[ i * 6 + 3 ], impulses[ i * 6 + 4 ], impulses[ i * 6 + 5 ] );
+		body->m_pseudoLinearVelocity += linear * body->m_invMass;
+		body->m_pseudoAngularVelocity += body->GetInverseInertiaTensorWorldSpace() * angular;
+	}
+}
+
+/*
+====================================================
+Constraint::GetAnchorRows
+Three rows that keep the two anchors together, one per world axis.  The joints' own distance
+row is the gradient of the squared distance, which vanishes once the anchors meet, so it can't
+hold them there by itself.
+====================================================
+*/
+inline int Constraint::GetAnchorRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const {
+	const Vec3 a = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
+	const Vec3 b = m_bodyB->BodySpaceToWorldSpace( m_anchorB );
+	const Vec3 ra = a - m_bodyA->GetCenterOfMassWorldSpace();
+	const Vec3 rb = b - m_bodyB->GetCenterOfMassWorldSpace();
+	const Vec3 r = b - a;
+
+	const float Beta = 0.2f;
+	const float scale = Beta * context.baumgarteScale / dt_sec;
+
+	for ( int i = 0; i < 3; i++ ) {
+		Vec3 axis( 0.0f );
+		axis[ i ] = 1.0f;
+
+		const Vec3 J2 = ra.Cross( axis ) * -1.0f;
+		const Vec3 J4 = rb.Cross( axis );
+		for ( int j = 0; j < 3; j++ ) {
+			jacobian[ i ][ 0 + j ] = -axis[ j ];
+			jacobian[ i ][ 3 + j ] = J2[ j ];
+			jacobian[ i ][ 6 + j ] = axis[ j ];
+			jacobian[ i ][ 9 + j ] = J4[ j ];
+		}
+		bias[ i ] = scale * r[ i ];
+	}
+	return 3;
+}
+
+/*
+====================================================
+Constraint::AddJacobianRows
+Appends rows of one of the joint's own jacobians, with no bias, after the first numRows
+====================================================
+*/
+inline int Constraint::AddJacobianRows( const MatMN & src, const int first, const int num, float jacobian[][ 12 ], float * bias, const int numRows ) const {
+	for ( int i = 0; i < num; i++ ) {
+		memcpy( jacobian[ numRows + i ], src.rows[ first + i ].data, sizeof( float ) * 12 );
+		bias[ numRows + i ] = 0.0f;
+	}
+	return numRows + num;
+}
+
+/*
+====================================================
+Constraint::GetLinearImpulseB
+====================================================
+*/
+inline Vec3 Constraint::GetLinearImpulseB( const MatMN & jacobian, const VecN & lambda ) const {
+	Vec3 impulse( 0.0f );
+	for ( int i = 0; i < jacobian.M; i++ ) {
+		impulse.x += jacobian.rows[ i ][ 6 ] * lambda[ i ];
+		impulse.y += jacobian.rows[ i ][ 7 ] * lambda[ i ];
+		impulse.z += jacobian.rows[ i ][ 8 ] * lambda[ i ];
+	}
+	return impulse;
+}
+
 /*
 ====================================================
 Constraint::Left
@@ -16,7 +16,7 @@ ConstraintConstantVelocity
 ConstraintConstantVelocity::PreSolve
 ================================
 */
-void ConstraintConstantVelocity::PreSolve( const float dt_sec ) {
+void ConstraintConstantVelocity::PreSolve( const float dt_sec, solverContext_t & context ) {
 	// Get the world space position of the hinge from A's orientation
 	const Vec3 worldAnchorA = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
 
@@ -111,7 +111,7 @@ void ConstraintConstantVelocity::PreSolve( const float dt_sec ) {
 	// Apply warm starting from last frame
 	//
 	const VecN impulses = m_Jacobian.Transpose() * m_cachedLambda;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	//
 	//	Calculate the baumgarte stabilization
@@ -119,7 +119,7 @@ void ConstraintConstantVelocity::PreSolve( const float dt_sec ) {
 	float C = r.Dot( r );
 	C = std::max( 0.0f, C - 0.01f );
 	const float Beta = 0.05f;
-	m_baumgarte = ( Beta / dt_sec ) * C;
+	m_baumgarte = ( Beta * context.baumgarteScale / dt_sec ) * C;
 }
 
 /*
@@ -127,7 +127,7 @@ void ConstraintConstantVelocity::PreSolve( const float dt_sec ) {
 ConstraintConstantVelocity::Solve
 ================================
 */
-void ConstraintConstantVelocity::Solve() {
+void ConstraintConstantVelocity::Solve( solverContext_t & context ) {
 	const MatMN JacobianTranspose = m_Jacobian.Transpose();
 
 	// Build the system of equations
@@ -138,11 +138,11 @@ void ConstraintConstantVelocity::Solve() {
 	rhs[ 0 ] -= m_baumgarte;
 
 	// Solve for the Lagrange multipliers
-	const VecN lambdaN = LCP_GaussSeidel( J_W_Jt, rhs );
+	const VecN lambdaN = LCP_SolveDirect( J_W_Jt, rhs );
 
 	// Apply the impulses
 	const VecN impulses = JacobianTranspose * lambdaN;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	// Accumulate the impulses for warm starting
 	m_cachedLambda += lambdaN;
@@ -169,6 +169,17 @@ void ConstraintConstantVelocity::PostSolve() {
 	}
 }
 
+/*
+================================
+ConstraintConstantVelocity::GetJointRows
+================================
+*/
+int ConstraintConstantVelocity::GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const {
+	// The anchor rows take the place of the distance row, the twist row is used as it is
+	const int numRows = GetAnchorRows( jacobian, bias, dt_sec, context );
+	return AddJacobianRows( m_Jacobian, 1, 1, jacobian, bias, numRows );
+}
+
 /*
 ================================================================================================
 
@@ -182,7 +193,7 @@ ConstraintConstantVelocityLimited
 ConstraintConstantVelocityLimited::PreSolve
 ================================
 */
-void ConstraintConstantVelocityLimited::PreSolve( const float dt_sec ) {
+void ConstraintConstantVelocityLimited::PreSolve( const float dt_sec, solverContext_t & context ) {
 	// Get the world space position of the hinge from A's orientation
 	const Vec3 worldAnchorA = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
 
@@ -354,7 +365,7 @@ void ConstraintConstantVelocityLimited::PreSolve( const float dt_sec ) {
 	// Apply warm starting from last frame
 	//
 	const VecN impulses = m_Jacobian.Transpose() * m_cachedLambda;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	//
 	//	Calculate the baumgarte stabilization
@@ -362,7 +373,7 @@ void ConstraintConstantVelocityLimited::PreSolve( const float dt_sec ) {
 	float C = r.Dot( r );
 	C = std::max( 0.0f, C - 0.01f );
 	const float Beta = 0.05f;
-	m_baumgarte = ( Beta / dt_sec ) * C;
+	m_baumgarte = ( Beta * context.baumgarteScale / dt_sec ) * C;
 }
 
 /*
@@ -370,7 +381,7 @@ void ConstraintConstantVelocityLimited::PreSolve( const float dt_sec ) {
 ConstraintConstantVelocityLimited::Solve
 ================================
 */
-void ConstraintConstantVelocityLimited::Solve() {
+void ConstraintConstantVelocityLimited::Solve( solverContext_t & context ) {
 	const MatMN JacobianTranspose = m_Jacobian.Transpose();
 
 	// Build the system of equations
@@ -380,31 +391,37 @@ void ConstraintConstantVelocityLimited::Solve() {
 	VecN rhs = m_Jacobian * q_dt * -1.0f;
 	rhs[ 0 ] -= m_baumgarte;
 
-	// Solve for the Lagrange multipliers
-	VecN lambdaN = LCP_GaussSeidel( J_W_Jt, rhs );
-
-	// Clamp the torque from the angle constraint.
+	// Bound the torque from the angle constraint.
 	// We need to make sure it's a restorative torque.
+	VecN lo( m_Jacobian.M );
+	VecN hi( m_Jacobian.M );
+	for ( int i = 0; i < m_Jacobian.M; i++ ) {
+		lo[ i ] = -FLT_MAX;
+		hi[ i ] = FLT_MAX;
+	}
 	if ( m_isAngleViolatedU ) {
 		if ( m_angleU > 0.0f ) {
-			lambdaN[ 2 ] = std::min( 0.0f, lambdaN[ 2 ] );
+			hi[ 2 ] = 0.0f;
 		}
 		if ( m_angleU < 0.0f ) {
-			lambdaN[ 2 ] = std::max( 0.0f, lambdaN[ 2 ] );
+			lo[ 2 ] = 0.0f;
 		}
 	}
 	if ( m_isAngleViolatedV ) {
 		if ( m_angleV > 0.0f ) {
-			lambdaN[ 3 ] = std::min( 0.0f, lambdaN[ 3 ] );
+			hi[ 3 ] = 0.0f;
 		}
 		if ( m_angleV < 0.0f ) {
-			lambdaN[ 3 ] = std::max( 0.0f, lambdaN[ 3 ] );
+			lo[ 3 ] = 0.0f;
 		}
 	}
 
+	// Solve for the Lagrange multipliers
+	const VecN lambdaN = LCP_SolveBoxed( J_W_Jt, rhs, lo, hi, m_Jacobian.M );
+
 	// Apply the impulses
 	const VecN impulses = JacobianTranspose * lambdaN;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	// Accumulate the impulses for warm starting
 	m_cachedLambda += lambdaN;
@@ -433,4 +450,15 @@ void ConstraintConstantVelocityLimited::PostSolve() {
 			m_cachedLambda[ i ] = -limit;
 		}
 	}
+}
+
+/*
+================================
+ConstraintConstantVelocityLimited::GetJointRows
+================================
+*/
+int ConstraintConstantVelocityLimited::GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const {
+	// The same rows as the unlimited joint, the two limit rows stay with Solve
+	const int numRows = GetAnchorRows( jacobian, bias, dt_sec, context );
+	return AddJacobianRows( m_Jacobian, 1, 1, jacobian, bias, numRows );
 }
\ No newline at end of file
@@ -8,7 +8,7 @@
 ConstraintDistance::PreSolve
 ================================
 */
-void ConstraintDistance::PreSolve( const float dt_sec ) {
+void ConstraintDistance::PreSolve( const float dt_sec, solverContext_t & context ) {
 	// Get the world space position of the hinge from A's orientation
 	const Vec3 worldAnchorA = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
 
@@ -47,7 +47,7 @@ void ConstraintDistance::PreSolve( const float dt_sec ) {
 	// Apply warm starting from last frame
 	//
 	const VecN impulses = m_Jacobian.Transpose() * m_cachedLambda;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	//
 	//	Calculate the baumgarte stabilization
@@ -55,7 +55,7 @@ void ConstraintDistance::PreSolve( const float dt_sec ) {
 	float C = r.Dot( r );
 	C = std::max( 0.0f, C - 0.01f );
 	const float Beta = 0.05f;
-	m_baumgarte = ( Beta / dt_sec ) * C;
+	m_baumgarte = ( Beta * context.baumgarteScale / dt_sec ) * C;
 }
 
 /*
@@ -63,7 +63,7 @@ void ConstraintDistance::PreSolve( const float dt_sec ) {
 ConstraintDistance::Solve
 ================================
 */
-void ConstraintDistance::Solve() {
+void ConstraintDistance::Solve( solverContext_t & context ) {
 	const MatMN JacobianTranspose = m_Jacobian.Transpose();
 
 	// Build the system of equations
@@ -78,7 +78,7 @@ void ConstraintDistance::Solve() {
 
 	// Apply the impulses
 	const VecN impulses = JacobianTranspose * lambdaN;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	// Accumulate the impulses for warm starting
 	m_cachedLambda += lambdaN;
@@ -101,4 +101,14 @@ void ConstraintDistance::PostSolve() {
 	if ( m_cachedLambda[ 0 ] < -limit ) {
 		m_cachedLambda[ 0 ] = -limit;
 	}
+}
+
+/*
+================================
+ConstraintDistance::GetJointRows
+================================
+*/
+int ConstraintDistance::GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const {
+	// The anchor rows take the place of the distance row
+	return GetAnchorRows( jacobian, bias, dt_sec, context );
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+//
+//  ConstraintFriction.cpp
+//
+#include "ConstraintFriction.h"
+
+/*
+================================
+ConstraintFriction::PreSolve
+================================
+*/
+void ConstraintFriction::PreSolve( const float dt_sec, solverContext_t & context ) {
+	const Vec3 worldAnchorA = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
+	const Vec3 worldAnchorB = m_bodyB->BodySpaceToWorldSpace( m_anchorB );
+
+	const Vec3 ra = worldAnchorA - m_bodyA->GetCenterOfMassWorldSpace();
+	const Vec3 rb = worldAnchorB - m_bodyB->GetCenterOfMassWorldSpace();
+
+	m_friction = m_bodyA->m_friction * m_bodyB->m_friction;
+
+	Vec3 u;
+	Vec3 v;
+	m_normal.GetOrtho( u, v );
+
+	// Convert tangent space from model space to world space
+	const Vec3 normal = m_bodyA->m_orientation.RotatePoint( m_normal );
+	u = m_bodyA->m_orientation.RotatePoint( u );
+	v = m_bodyA->m_orientation.RotatePoint( v );
+
+	m_Jacobian.Zero();
+
+	//
+	//	Tangent rows, the relative velocity of the anchors along u and v
+	//
+	const Vec3 tangents[ 2 ] = { u, v };
+	for ( int i = 0; i < 2; i++ ) {
+		const Vec3 & t = tangents[ i ];
+
+		Vec3 J1 = t * -1.0f;
+		m_Jacobian.rows[ i ][ 0 ] = J1.x;
+		m_Jacobian.rows[ i ][ 1 ] = J1.y;
+		m_Jacobian.rows[ i ][ 2 ] = J1.z;
+
+		Vec3 J2 = ra.Cross( t * -1.0f );
+		m_Jacobian.rows[ i ][ 3 ] = J2.x;
+		m_Jacobian.rows[ i ][ 4 ] = J2.y;
+		m_Jacobian.rows[ i ][ 5 ] = J2.z;
+
+		Vec3 J3 = t * 1.0f;
+		m_Jacobian.rows[ i ][ 6 ] = J3.x;
+		m_Jacobian.rows[ i ][ 7 ] = J3.y;
+		m_Jacobian.rows[ i ][ 8 ] = J3.z;
+
+		Vec3 J4 = rb.Cross( t * 1.0f );
+		m_Jacobian.rows[ i ][ 9 ] = J4.x;
+		m_Jacobian.rows[ i ][ 10] = J4.y;
+		m_Jacobian.rows[ i ][ 11] = J4.z;
+	}
+
+	//
+	//	Twist row, the relative angular velocity about the normal
+	//
+	m_Jacobian.rows[ 2 ][ 3 ] = -normal.x;
+	m_Jacobian.rows[ 2 ][ 4 ] = -normal.y;
+	m_Jacobian.rows[ 2 ][ 5 ] = -normal.z;
+	m_Jacobian.rows[ 2 ][ 9 ] = normal.x;
+	m_Jacobian.rows[ 2 ][ 10] = normal.y;
+	m_Jacobian.rows[ 2 ][ 11] = normal.z;
+
+	m_JacobianTranspose = m_Jacobian.Transpose();
+	m_J_W_Jt = m_Jacobian * GetInverseMassMatrix() * m_JacobianTranspose;
+
+	//
+	// Apply warm starting from last frame
+	//
+	const VecN impulses = m_JacobianTranspose * m_cachedLambda;
+	ApplyImpulses( impulses, context );
+}
+
+/*
+================================
+ConstraintFriction::Solve
+================================
+*/
+void ConstraintFriction::Solve( solverContext_t & context ) {
+	if ( m_friction <= 0.0f ) {
+		return;
+	}
+
+	// Build the system of equations
+	const VecN q_dt = GetVelocities();
+	const VecN rhs = m_Jacobian * q_dt * -1.0f;
+
+	// Solve for the Lagrange multipliers
+	VecN lambdaN = LCP_GaussSeidel( m_J_W_Jt, rhs );
+
+	// Accumulate the impulses and clamp the tangent impulse to the friction cone
+	// and the twist impulse to what that friction can do at the contacts' radius
+	const VecN oldLambda = m_cachedLambda;
+	m_cachedLambda += lambdaN;
+
+	const float maxForce = m_friction * m_normalImpulse;
+	const float tangentSqr = m_cachedLambda[ 0 ] * m_cachedLambda[ 0 ] + m_cachedLambda[ 1 ] * m_cachedLambda[ 1 ];
+	if ( tangentSqr > maxForce * maxForce ) {
+		const float scale = maxForce / sqrtf( tangentSqr );
+		m_cachedLambda[ 0 ] *= scale;
+		m_cachedLambda[ 1 ] *= scale;
+	}
+
+	const float maxTorque = maxForce * m_radius;
+	if ( m_cachedLambda[ 2 ] > maxTorque ) {
+		m_cachedLambda[ 2 ] = maxTorque;
+	}
+	if ( m_cachedLambda[ 2 ] < -maxTorque ) {
+		m_cachedLambda[ 2 ] = -maxTorque;
+	}
+	lambdaN = m_cachedLambda - oldLambda;
+
+	// Apply the impulses
+	const VecN impulses = m_JacobianTranspose * lambdaN;
+	ApplyImpulses( impulses, context );
+}
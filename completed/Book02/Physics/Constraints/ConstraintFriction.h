@@ -0,0 +1,41 @@
+//
+//	ConstraintFriction.h
+//
+#pragma once
+#include "ConstraintBase.h"
+
+/*
+====================================================
+ConstraintFriction
+Friction for a whole manifold, two tangent rows and a twist row about the normal at the centroid
+of the contacts.  Replaces the two friction rows of every ConstraintPenetration in the manifold.
+====================================================
+*/
+class ConstraintFriction : public Constraint {
+public:
+	ConstraintFriction() : Constraint(), m_cachedLambda( 3 ), m_Jacobian( 3, 12 ), m_JacobianTranspose( 12, 3 ), m_J_W_Jt( 3 ) {
+		m_cachedLambda.Zero();
+		m_friction = 0.0f;
+		m_radius = 0.0f;
+		m_normalImpulse = 0.0f;
+	}
+
+	void PreSolve( const float dt_sec, solverContext_t & context ) override;
+	void Solve( solverContext_t & context ) override;
+
+	constraintType_t GetType() const override { return CONSTRAINT_FRICTION; }
+	int GetStateSize() const override { return m_cachedLambda.N; }
+	void SaveState( float * state ) const override { memcpy( state, m_cachedLambda.data, sizeof( float ) * m_cachedLambda.N ); }
+	void RestoreState( const float * state ) override { memcpy( m_cachedLambda.data, state, sizeof( float ) * m_cachedLambda.N ); }
+
+	VecN m_cachedLambda;
+	Vec3 m_normal;		// in Body A's local space
+
+	MatMN m_Jacobian;
+	MatMN m_JacobianTranspose;
+	MatN m_J_W_Jt;		// the bodies don't turn during the solve, so this is built once in PreSolve
+
+	float m_friction;
+	float m_radius;			// mean distance of the contacts from the anchor, the lever arm of the twist friction
+	float m_normalImpulse;	// summed normal impulse of the manifold's contacts, set before each Solve
+};
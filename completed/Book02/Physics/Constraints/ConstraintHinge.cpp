@@ -16,7 +16,7 @@ ConstraintHingeQuat
 ConstraintHingeQuat::PreSolve
 ================================
 */
-void ConstraintHingeQuat::PreSolve( const float dt_sec ) {
+void ConstraintHingeQuat::PreSolve( const float dt_sec, solverContext_t & context ) {
 	// Get the world space position of the hinge from A's orientation
 	const Vec3 worldAnchorA = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
 
@@ -135,7 +135,7 @@ void ConstraintHingeQuat::PreSolve( const float dt_sec ) {
 	// Apply warm starting from last frame
 	//
 	const VecN impulses = m_Jacobian.Transpose() * m_cachedLambda;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	//
 	//	Calculate the baumgarte stabilization
@@ -143,7 +143,7 @@ void ConstraintHingeQuat::PreSolve( const float dt_sec ) {
 	float C = r.Dot( r );
 	C = std::max( 0.0f, C - 0.01f );
 	const float Beta = 0.05f;
-	m_baumgarte = ( Beta / dt_sec ) * C;
+	m_baumgarte = ( Beta * context.baumgarteScale / dt_sec ) * C;
 }
 
 /*
@@ -151,7 +151,7 @@ void ConstraintHingeQuat::PreSolve( const float dt_sec ) {
 ConstraintHingeQuat::Solve
 ================================
 */
-void ConstraintHingeQuat::Solve() {
+void ConstraintHingeQuat::Solve( solverContext_t & context ) {
 	const MatMN JacobianTranspose = m_Jacobian.Transpose();
 
 	// Build the system of equations
@@ -162,11 +162,11 @@ void ConstraintHingeQuat::Solve() {
 	rhs[ 0 ] -= m_baumgarte;
 
 	// Solve for the Lagrange multipliers
-	const VecN lambdaN = LCP_GaussSeidel( J_W_Jt, rhs );
+	const VecN lambdaN = LCP_SolveDirect( J_W_Jt, rhs );
 
 	// Apply the impulses
 	const VecN impulses = JacobianTranspose * lambdaN;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	// Accumulate the impulses for warm starting
 	m_cachedLambda += lambdaN;
@@ -193,6 +193,18 @@ void ConstraintHingeQuat::PostSolve() {
 	}
 }
 
+/*
+================================
+ConstraintHingeQuat::GetJointRows
+================================
+*/
+int ConstraintHingeQuat::GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const {
+	// The anchor rows take the place of the distance row, the two rows that keep the hinge axes
+	// lined up are used as they are
+	const int numRows = GetAnchorRows( jacobian, bias, dt_sec, context );
+	return AddJacobianRows( m_Jacobian, 1, 2, jacobian, bias, numRows );
+}
+
 /*
 ================================================================================================
 
@@ -206,7 +218,7 @@ ConstraintHingeQuatLimited
 ConstraintHingeQuatLimited::PreSolve
 ================================
 */
-void ConstraintHingeQuatLimited::PreSolve( const float dt_sec ) {
+void ConstraintHingeQuatLimited::PreSolve( const float dt_sec, solverContext_t & context ) {
 	// Get the world space position of the hinge from A's orientation
 	const Vec3 worldAnchorA = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
 
@@ -359,7 +371,7 @@ void ConstraintHingeQuatLimited::PreSolve( const float dt_sec ) {
 	// Apply warm starting from last frame
 	//
 	const VecN impulses = m_Jacobian.Transpose() * m_cachedLambda;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	//
 	//	Calculate the baumgarte stabilization
@@ -367,7 +379,7 @@ void ConstraintHingeQuatLimited::PreSolve( const float dt_sec ) {
 	float C = r.Dot( r );
 	C = std::max( 0.0f, C - 0.01f );
 	const float Beta = 0.05f;
-	m_baumgarte = ( Beta / dt_sec ) * C;
+	m_baumgarte = ( Beta * context.baumgarteScale / dt_sec ) * C;
 }
 
 /*
@@ -375,7 +387,7 @@ void ConstraintHingeQuatLimited::PreSolve( const float dt_sec ) {
 ConstraintHingeQuatLimited::Solve
 ================================
 */
-void ConstraintHingeQuatLimited::Solve() {
+void ConstraintHingeQuatLimited::Solve( solverContext_t & context ) {
 	const MatMN JacobianTranspose = m_Jacobian.Transpose();
 
 	// Build the system of equations
@@ -385,23 +397,29 @@ void ConstraintHingeQuatLimited::Solve() {
 	VecN rhs = m_Jacobian * q_dt * -1.0f;
 	rhs[ 0 ] -= m_baumgarte;
 
-	// Solve for the Lagrange multipliers
-	VecN lambdaN = LCP_GaussSeidel( J_W_Jt, rhs );
-
-	// Clamp the torque from the angle constraint.
+	// Bound the torque from the angle constraint.
 	// We need to make sure it's a restorative torque.
+	VecN lo( m_Jacobian.M );
+	VecN hi( m_Jacobian.M );
+	for ( int i = 0; i < m_Jacobian.M; i++ ) {
+		lo[ i ] = -FLT_MAX;
+		hi[ i ] = FLT_MAX;
+	}
 	if ( m_isAngleViolated ) {
 		if ( m_relativeAngle > 0.0f ) {
-			lambdaN[ 3 ] = std::min( 0.0f, lambdaN[ 3 ] );
+			hi[ 3 ] = 0.0f;
 		}
 		if ( m_relativeAngle < 0.0f ) {
-			lambdaN[ 3 ] = std::max( 0.0f, lambdaN[ 3 ] );
+			lo[ 3 ] = 0.0f;
 		}
 	}
 
+	// Solve for the Lagrange multipliers
+	const VecN lambdaN = LCP_SolveBoxed( J_W_Jt, rhs, lo, hi, m_Jacobian.M );
+
 	// Apply the impulses
 	const VecN impulses = JacobianTranspose * lambdaN;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	// Accumulate the impulses for warm starting
 	m_cachedLambda += lambdaN;
@@ -430,4 +448,15 @@ void ConstraintHingeQuatLimited::PostSolve() {
 			m_cachedLambda[ i ] = -limit;
 		}
 	}
+}
+
+/*
+================================
+ConstraintHingeQuatLimited::GetJointRows
+================================
+*/
+int ConstraintHingeQuatLimited::GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const {
+	// The same rows as the unlimited hinge, the limit row stays with Solve
+	const int numRows = GetAnchorRows( jacobian, bias, dt_sec, context );
+	return AddJacobianRows( m_Jacobian, 1, 2, jacobian, bias, numRows );
 }
\ No newline at end of file
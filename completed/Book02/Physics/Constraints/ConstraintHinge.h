@@ -15,10 +15,17 @@ public:
 		m_cachedLambda.Zero();
 		m_baumgarte = 0.0f;
 	}
-	void PreSolve( const float dt_sec ) override;
-	void Solve() override;
+	void PreSolve( const float dt_sec, solverContext_t & context ) override;
+	void Solve( solverContext_t & context ) override;
+	int GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const override;
 	void PostSolve() override;
 
+	constraintType_t GetType() const override { return CONSTRAINT_HINGE_QUAT; }
+	Vec3 GetAccumulatedImpulse() const override { return GetLinearImpulseB( m_Jacobian, m_cachedLambda ); }
+	int GetStateSize() const override { return m_cachedLambda.N; }
+	void SaveState( float * state ) const override { memcpy( state, m_cachedLambda.data, sizeof( float ) * m_cachedLambda.N ); }
+	void RestoreState( const float * state ) override { memcpy( m_cachedLambda.data, state, sizeof( float ) * m_cachedLambda.N ); }
+
 	Quat q0;	// The initial relative quaternion q1^-1 * q2
 
 	VecN m_cachedLambda;
@@ -40,10 +47,18 @@ public:
 		m_isAngleViolated = false;
 		m_relativeAngle = 0.0f;
 	}
-	void PreSolve( const float dt_sec ) override;
-	void Solve() override;
+	void PreSolve( const float dt_sec, solverContext_t & context ) override;
+	void Solve( solverContext_t & context ) override;
+	int GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const override;
 	void PostSolve() override;
 
+	constraintType_t GetType() const override { return CONSTRAINT_HINGE_QUAT_LIMITED; }
+	bool HasActiveLimits() const override { return m_isAngleViolated; }
+	Vec3 GetAccumulatedImpulse() const override { return GetLinearImpulseB( m_Jacobian, m_cachedLambda ); }
+	int GetStateSize() const override { return m_cachedLambda.N; }
+	void SaveState( float * state ) const override { memcpy( state, m_cachedLambda.data, sizeof( float ) * m_cachedLambda.N ); }
+	void RestoreState( const float * state ) override { memcpy( m_cachedLambda.data, state, sizeof( float ) * m_cachedLambda.N ); }
+
 	Quat m_q0;	// The initial relative quaternion q1^-1 * q2
 
 	VecN m_cachedLambda;
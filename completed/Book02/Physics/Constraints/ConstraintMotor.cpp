@@ -8,7 +8,7 @@
 ConstraintMotor::PreSolve
 ================================
 */
-void ConstraintMotor::PreSolve( const float dt_sec ) {
+void ConstraintMotor::PreSolve( const float dt_sec, solverContext_t & context ) {
 	// Get the world space position of the hinge from A's orientation
 	const Vec3 worldAnchorA = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
 
@@ -152,7 +152,7 @@ void ConstraintMotor::PreSolve( const float dt_sec ) {
 	//
 	//	Calculate the baumgarte stabilization
 	//
-	const float Beta = 0.05f;
+	const float Beta = 0.05f * context.baumgarteScale;
 	const float C = r.Dot( r );
 
 	const Quat qr = m_bodyA->m_orientation.Inverse() * m_bodyB->m_orientation;
@@ -169,10 +169,11 @@ void ConstraintMotor::PreSolve( const float dt_sec ) {
 
 /*
 ================================
-ConstraintMotor::Solve
+ConstraintMotor::GetMotorVelocities
+The velocities that spin the bodies against each other at the motor speed
 ================================
 */
-void ConstraintMotor::Solve() {
+VecN ConstraintMotor::GetMotorVelocities() const {
 	const Vec3 motorAxis = m_bodyA->m_orientation.RotatePoint( m_motorAxis );
 
 	VecN w_dt( 12 );
@@ -183,6 +184,16 @@ void ConstraintMotor::Solve() {
 	w_dt[ 9 ] = motorAxis[ 0 ] * m_motorSpeed;
 	w_dt[ 10 ] = motorAxis[ 1 ] * m_motorSpeed;
 	w_dt[ 11 ] = motorAxis[ 2 ] * m_motorSpeed;
+	return w_dt;
+}
+
+/*
+================================
+ConstraintMotor::Solve
+================================
+*/
+void ConstraintMotor::Solve( solverContext_t & context ) {
+	const VecN w_dt = GetMotorVelocities();
 
 	const MatMN JacobianTranspose = m_Jacobian.Transpose();
 
@@ -196,9 +207,31 @@ void ConstraintMotor::Solve() {
 	}
 
 	// Solve for the Lagrange multipliers
-	VecN lambdaN = LCP_GaussSeidel( J_W_Jt, rhs );
+	VecN lambdaN = LCP_SolveDirect( J_W_Jt, rhs );
 
 	// Apply the impulses
 	const VecN impulses = JacobianTranspose * lambdaN;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
+}
+
+/*
+================================
+ConstraintMotor::GetJointRows
+================================
+*/
+int ConstraintMotor::GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const {
+	int numRows = GetAnchorRows( jacobian, bias, dt_sec, context );
+	numRows = AddJacobianRows( m_Jacobian, 1, 3, jacobian, bias, numRows );
+
+	// The same targets as Solve, the axes are corrected back into line and the motor row is
+	// driven at the motor speed instead of zero
+	bias[ 3 ] = m_baumgarte[ 1 ];
+	bias[ 4 ] = m_baumgarte[ 2 ];
+	const VecN w_dt = GetMotorVelocities();
+	for ( int i = 3; i < numRows; i++ ) {
+		for ( int j = 0; j < 12; j++ ) {
+			bias[ i ] -= jacobian[ i ][ j ] * w_dt[ j ];
+		}
+	}
+	return numRows;
 }
\ No newline at end of file
@@ -13,8 +13,11 @@ public:
 		m_baumgarte = 0.0f;
 	}
 
-	void PreSolve( const float dt_sec ) override;
-	void Solve() override;
+	void PreSolve( const float dt_sec, solverContext_t & context ) override;
+	void Solve( solverContext_t & context ) override;
+	int GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const override;
+
+	constraintType_t GetType() const override { return CONSTRAINT_MOTOR; }
 
 	float m_motorSpeed;
 	Vec3 m_motorAxis;	// Motor Axis in BodyA's local space
@@ -23,4 +26,7 @@ public:
 	MatMN m_Jacobian;
 
 	Vec3 m_baumgarte;
+
+private:
+	VecN GetMotorVelocities() const;
 };
\ No newline at end of file
@@ -8,7 +8,7 @@
 ConstraintMoverSimple::PreSolve
 ====================================================
 */
-void ConstraintMoverSimple::PreSolve( const float dt_sec ) {
+void ConstraintMoverSimple::PreSolve( const float dt_sec, solverContext_t & context ) {
 	m_time += dt_sec;
 	m_bodyA->m_linearVelocity.y = cosf( m_time * 0.25f ) * 4.0f;
 }
\ No newline at end of file
@@ -13,7 +13,12 @@ class ConstraintMoverSimple : public Constraint {
 public:
 	ConstraintMoverSimple() : Constraint(), m_time( 0 ) {}
 
-	void PreSolve( const float dt_sec ) override;
+	void PreSolve( const float dt_sec, solverContext_t & context ) override;
+
+	constraintType_t GetType() const override { return CONSTRAINT_MOVER_SIMPLE; }
+	int GetStateSize() const override { return 1; }
+	void SaveState( float * state ) const override { state[ 0 ] = m_time; }
+	void RestoreState( const float * state ) override { m_time = state[ 0 ]; }
 
 	float m_time;
 };
\ No newline at end of file
@@ -8,7 +8,7 @@
 ConstraintOrientation::PreSolve
 ================================
 */
-void ConstraintOrientation::PreSolve( const float dt_sec ) {
+void ConstraintOrientation::PreSolve( const float dt_sec, solverContext_t & context ) {
 	// Get the world space position of the hinge from A's orientation
 	const Vec3 worldAnchorA = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
 
@@ -149,7 +149,7 @@ void ConstraintOrientation::PreSolve( const float dt_sec ) {
 	//
 	float C = r.Dot( r );
 	const float Beta = 0.5f;
-	m_baumgarte = ( Beta / dt_sec ) * C;
+	m_baumgarte = ( Beta * context.baumgarteScale / dt_sec ) * C;
 }
 
 /*
@@ -157,7 +157,7 @@ void ConstraintOrientation::PreSolve( const float dt_sec ) {
 ConstraintOrientation::Solve
 ================================
 */
-void ConstraintOrientation::Solve() {
+void ConstraintOrientation::Solve( solverContext_t & context ) {
 	const MatMN JacobianTranspose = m_Jacobian.Transpose();
 
 	// Build the system of equations
@@ -168,9 +168,21 @@ void ConstraintOrientation::Solve() {
 	rhs[ 0 ] -= m_baumgarte;
 
 	// Solve for the Lagrange multipliers
-	VecN lambdaN = LCP_GaussSeidel( J_W_Jt, rhs );
+	VecN lambdaN = LCP_SolveDirect( J_W_Jt, rhs );
 
 	// Apply the impulses
 	const VecN impulses = JacobianTranspose * lambdaN;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
+}
+
+/*
+================================
+ConstraintOrientation::GetJointRows
+================================
+*/
+int ConstraintOrientation::GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const {
+	// The anchor rows take the place of the distance row, the three orientation rows are used
+	// as they are
+	const int numRows = GetAnchorRows( jacobian, bias, dt_sec, context );
+	return AddJacobianRows( m_Jacobian, 1, 3, jacobian, bias, numRows );
 }
\ No newline at end of file
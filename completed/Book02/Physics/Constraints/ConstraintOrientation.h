@@ -10,8 +10,11 @@ public:
 		m_baumgarte = 0.0f;
 	}
 
-	void PreSolve( const float dt_sec ) override;
-	void Solve() override;
+	void PreSolve( const float dt_sec, solverContext_t & context ) override;
+	void Solve( solverContext_t & context ) override;
+	int GetJointRows( float jacobian[][ 12 ], float * bias, const float dt_sec, const solverContext_t & context ) const override;
+
+	constraintType_t GetType() const override { return CONSTRAINT_ORIENTATION; }
 
 	Quat m_q0;			// The initial relative quaternion q1^-1 * q2
 
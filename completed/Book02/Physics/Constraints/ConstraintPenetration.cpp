@@ -2,9 +2,10 @@
 //  ConstraintPenetration.cpp
 //
 #include "ConstraintPenetration.h"
+#include "../Stats.h"
 
 
-void ConstraintPenetration::PreSolve( const float dt_sec ) {
+void ConstraintPenetration::PreSolve( const float dt_sec, solverContext_t & context ) {
 	// Get the world space position of the hinge from A's orientation
 	const Vec3 worldAnchorA = m_bodyA->BodySpaceToWorldSpace( m_anchorA );
 
@@ -101,22 +102,31 @@ void ConstraintPenetration::PreSolve( const float dt_sec ) {
 		m_Jacobian.rows[ 2 ][ 11] = J4.z;
 	}
 
+	// Effective mass of the normal row, the bodies don't turn during the solve so it holds for every iteration
+	const Vec3 angularA = ra.Cross( normal );
+	const Vec3 angularB = rb.Cross( normal );
+	const float normalInvMass = m_bodyA->m_invMass + m_bodyB->m_invMass
+		+ angularA.Dot( m_bodyA->GetInverseInertiaTensorWorldSpace() * angularA )
+		+ angularB.Dot( m_bodyB->GetInverseInertiaTensorWorldSpace() * angularB );
+	m_normalMass = ( normalInvMass > 0.0f ) ? 1.0f / normalInvMass : 0.0f;
+
 	//
 	// Apply warm starting from last frame
 	//
 	const VecN impulses = m_Jacobian.Transpose() * m_cachedLambda;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
 
 	//
 	//	Calculate the baumgarte stabilization
 	//
 	float C = ( b - a ).Dot( normal );
 	C = std::min( 0.0f, C + 0.02f );	// Add slop
-	float Beta = 0.25f;
-	m_baumgarte = Beta * C / dt_sec;
+	float Beta = context.useSplitImpulse ? 0.5f : 0.25f;
+	m_baumgarte = Beta * context.baumgarteScale * C / dt_sec;
+	m_pseudoLambda = 0.0f;
 }
 
-void ConstraintPenetration::Solve() {
+void ConstraintPenetration::Solve( solverContext_t & context ) {
 	const MatMN JacobianTranspose = m_Jacobian.Transpose();
 
 	// Build the system of equations
@@ -124,7 +134,9 @@ void ConstraintPenetration::Solve() {
 	const MatMN invMassMatrix = GetInverseMassMatrix();
 	const MatMN J_W_Jt = m_Jacobian * invMassMatrix * JacobianTranspose;
 	VecN rhs = m_Jacobian * q_dt * -1.0f;
-	rhs[ 0 ] -= m_baumgarte;
+	if ( !context.useSplitImpulse ) {
+		rhs[ 0 ] -= m_baumgarte;
+	}
 
 	// Solve for the Lagrange multipliers
 	VecN lambdaN = LCP_GaussSeidel( J_W_Jt, rhs );
@@ -159,5 +171,257 @@ void ConstraintPenetration::Solve() {
 
 	// Apply the impulses
 	const VecN impulses = JacobianTranspose * lambdaN;
-	ApplyImpulses( impulses );
+	ApplyImpulses( impulses, context );
+}
+
+void ConstraintPenetration::SolvePositions() {
+	// Only the normal row corrects penetration, friction has no position error.  It's the same
+	// single row as SolveNormal, so it shares the effective mass instead of building the system.
+	const VecN q_dt = GetPseudoVelocities();
+	float Jv = 0.0f;
+	for ( int i = 0; i < 12; i++ ) {
+		Jv += m_Jacobian.rows[ 0 ][ i ] * q_dt[ i ];
+	}
+
+	// Accumulate and clamp so the bodies are only ever pushed apart
+	const float oldLambda = m_pseudoLambda;
+	m_pseudoLambda += ( -Jv - m_baumgarte ) * m_normalMass;
+	if ( m_pseudoLambda < 0.0f ) {
+		m_pseudoLambda = 0.0f;
+	}
+	const float lambda = m_pseudoLambda - oldLambda;
+
+	VecN impulses( 12 );
+	for ( int i = 0; i < 12; i++ ) {
+		impulses[ i ] = m_Jacobian.rows[ 0 ][ i ] * lambda;
+	}
+	ApplyPseudoImpulses( impulses );
+}
+
+// Normal row only, the contact is left to someone else's friction
+void ConstraintPenetration::SolveNormal( solverContext_t & context ) {
+	const VecN q_dt = GetVelocities();
+	float Jv = 0.0f;
+	for ( int i = 0; i < 12; i++ ) {
+		Jv += m_Jacobian.rows[ 0 ][ i ] * q_dt[ i ];
+	}
+	float rhs = -Jv;
+	if ( !context.useSplitImpulse ) {
+		rhs -= m_baumgarte;
+	}
+
+	// Accumulate and clamp so the bodies are only ever pushed apart
+	const float oldLambda = m_cachedLambda[ 0 ];
+	m_cachedLambda[ 0 ] += rhs * m_normalMass;
+	if ( m_cachedLambda[ 0 ] < 0.0f ) {
+		m_cachedLambda[ 0 ] = 0.0f;
+	}
+	const float lambda = m_cachedLambda[ 0 ] - oldLambda;
+
+	VecN impulses( 12 );
+	for ( int i = 0; i < 12; i++ ) {
+		impulses[ i ] = m_Jacobian.rows[ 0 ][ i ] * lambda;
+	}
+	ApplyImpulses( impulses, context );
+}
+
+// Friction rows only, clamped by the accumulated normal impulse
+void ConstraintPenetration::SolveFriction( solverContext_t & context ) {
+	if ( m_friction <= 0.0f ) {
+		return;
+	}
+
+	MatMN jacobian( 2, 12 );
+	for ( int i = 0; i < 12; i++ ) {
+		jacobian.rows[ 0 ][ i ] = m_Jacobian.rows[ 1 ][ i ];
+		jacobian.rows[ 1 ][ i ] = m_Jacobian.rows[ 2 ][ i ];
+	}
+	const MatMN JacobianTranspose = jacobian.Transpose();
+
+	const VecN q_dt = GetVelocities();
+	const MatMN invMassMatrix = GetInverseMassMatrix();
+	const MatMN J_W_Jt = jacobian * invMassMatrix * JacobianTranspose;
+	const VecN rhs = jacobian * q_dt * -1.0f;
+	VecN lambdaN = LCP_GaussSeidel( J_W_Jt, rhs );
+
+	const float umg = m_friction * 10.0f * 1.0f / ( m_bodyA->m_invMass + m_bodyB->m_invMass );
+	const float normalForce = m_cachedLambda[ 0 ] * m_friction;
+	const float maxForce = ( umg > normalForce ) ? umg : normalForce;
+	for ( int i = 0; i < 2; i++ ) {
+		const float oldLambda = m_cachedLambda[ 1 + i ];
+		float lambda = oldLambda + lambdaN[ i ];
+		lambda = ( lambda > maxForce ) ? maxForce : lambda;
+		lambda = ( lambda < -maxForce ) ? -maxForce : lambda;
+		m_cachedLambda[ 1 + i ] = lambda;
+		lambdaN[ i ] = lambda - oldLambda;
+	}
+
+	ApplyImpulses( JacobianTranspose * lambdaN, context );
+}
+
+// Relative to the contacts' largest velocity, how far below zero a velocity or impulse can be
+// and still count as zero
+static const float BLOCK_SOLVER_TOLERANCE = 1e-4f;
+
+// Number of set bits, for trying the contact subsets from largest to smallest
+static int CountBits( int mask ) {
+	int count = 0;
+	for ( ; mask; mask >>= 1 ) {
+		count += mask & 1;
+	}
+	return count;
+}
+
+/*
+Solves the normal impulses of up to four contacts between the same two bodies at once.  With
+w = A * lambda + c the relative normal velocities after the impulses, this finds lambda >= 0,
+w >= 0 with lambda_i * w_i = 0 by trying every set of touching contacts from all of them down
+to none, and taking the first that's consistent.
+
+Contacts that duplicate each other give rows that are equal in exact math.  Sets holding both
+copies fail the Cholesky, and a set holding one leaves the other's w at zero give or take rounding,
+so lambda and w only have to be non-negative to within a tolerance relative to the velocities.
+Falls back to solving the contacts one by one if no set is consistent even so.
+*/
+void ConstraintPenetration::SolveNormalBlock( ConstraintPenetration * constraints, const int numConstraints, solverContext_t & context ) {
+	const int n = numConstraints;
+	Body * bodyA = constraints[ 0 ].m_bodyA;
+	Body * bodyB = constraints[ 0 ].m_bodyB;
+
+	const VecN q_dt = constraints[ 0 ].GetVelocities();
+	const Mat3 invInertiaA = bodyA->GetInverseInertiaTensorWorldSpace();
+	const Mat3 invInertiaB = bodyB->GetInverseInertiaTensorWorldSpace();
+
+	// Normal rows of the Jacobians, and the same multiplied by the inverse mass matrix
+	float J[ 4 ][ 12 ];
+	float WJ[ 4 ][ 12 ];
+	for ( int i = 0; i < n; i++ ) {
+		for ( int k = 0; k < 12; k++ ) {
+			J[ i ][ k ] = constraints[ i ].m_Jacobian.rows[ 0 ][ k ];
+		}
+		const Vec3 angularA = invInertiaA * Vec3( J[ i ][ 3 ], J[ i ][ 4 ], J[ i ][ 5 ] );
+		const Vec3 angularB = invInertiaB * Vec3( J[ i ][ 9 ], J[ i ][ 10 ], J[ i ][ 11 ] );
+		for ( int k = 0; k < 3; k++ ) {
+			WJ[ i ][ 0 + k ] = J[ i ][ 0 + k ] * bodyA->m_invMass;
+			WJ[ i ][ 3 + k ] = angularA[ k ];
+			WJ[ i ][ 6 + k ] = J[ i ][ 6 + k ] * bodyB->m_invMass;
+			WJ[ i ][ 9 + k ] = angularB[ k ];
+		}
+	}
+
+	float A[ 4 ][ 4 ];
+	float c[ 4 ];
+	float oldLambda[ 4 ];
+	for ( int i = 0; i < n; i++ ) {
+		oldLambda[ i ] = constraints[ i ].m_cachedLambda[ 0 ];
+	}
+	for ( int i = 0; i < n; i++ ) {
+		float vn = 0.0f;
+		for ( int k = 0; k < 12; k++ ) {
+			vn += J[ i ][ k ] * q_dt[ k ];
+		}
+		for ( int j = 0; j < n; j++ ) {
+			float sum = 0.0f;
+			for ( int k = 0; k < 12; k++ ) {
+				sum += J[ i ][ k ] * WJ[ j ][ k ];
+			}
+			A[ i ][ j ] = sum;
+		}
+
+		// Velocities without the impulses accumulated so far, so that the result is the total impulse
+		c[ i ] = vn;
+		if ( !context.useSplitImpulse ) {
+			c[ i ] += constraints[ i ].m_baumgarte;
+		}
+		for ( int j = 0; j < n; j++ ) {
+			c[ i ] -= A[ i ][ j ] * oldLambda[ j ];
+		}
+	}
+
+	// Velocities are compared to the largest one, and impulses to what it takes to cause that
+	float velocityScale = 0.0f;
+	for ( int i = 0; i < n; i++ ) {
+		velocityScale = std::max( velocityScale, fabsf( c[ i ] ) );
+	}
+	const float tolerance = BLOCK_SOLVER_TOLERANCE * velocityScale;
+
+	float lambda[ 4 ] = { 0.0f };
+	bool isSolved = false;
+	for ( int numActive = n; numActive >= 0 && !isSolved; numActive-- ) {
+		for ( int mask = ( 1 << n ) - 1; mask >= 0 && !isSolved; mask-- ) {
+			if ( CountBits( mask ) != numActive ) {
+				continue;
+			}
+
+			// Solve the active contacts for zero relative velocity
+			int active[ 4 ];
+			float subA[ LCP_MAX_ROWS ][ LCP_MAX_ROWS ];
+			float subB[ 4 ];
+			float subX[ 4 ];
+			int m = 0;
+			for ( int i = 0; i < n; i++ ) {
+				if ( mask & ( 1 << i ) ) {
+					active[ m++ ] = i;
+				}
+			}
+			for ( int i = 0; i < m; i++ ) {
+				for ( int j = 0; j < m; j++ ) {
+					subA[ i ][ j ] = A[ active[ i ] ][ active[ j ] ];
+				}
+				subB[ i ] = -c[ active[ i ] ];
+			}
+			// Fails if the rows are dependent, like four coplanar contacts
+			if ( m > 0 && !LCP_SolveCholesky( subA, subB, m, subX, 1e-4f ) ) {
+				continue;
+			}
+
+			float x[ 4 ] = { 0.0f };
+			bool isValid = true;
+			for ( int i = 0; i < m; i++ ) {
+				x[ active[ i ] ] = std::max( subX[ i ], 0.0f );
+				isValid = isValid && ( subX[ i ] * A[ active[ i ] ][ active[ i ] ] >= -tolerance );
+			}
+
+			// The inactive contacts must be separating
+			for ( int i = 0; i < n && isValid; i++ ) {
+				if ( mask & ( 1 << i ) ) {
+					continue;
+				}
+				float w = c[ i ];
+				for ( int j = 0; j < n; j++ ) {
+					w += A[ i ][ j ] * x[ j ];
+				}
+				isValid = ( w >= -tolerance );
+			}
+
+			if ( isValid ) {
+				for ( int i = 0; i < n; i++ ) {
+					lambda[ i ] = x[ i ];
+				}
+				isSolved = true;
+			}
+		}
+	}
+
+	if ( !isSolved ) {
+		// Friction was already solved by Manifold::Solve, so only the normal rows fall back
+		if ( NULL != context.stats ) {
+			context.stats->numBlockFallbacks++;
+		}
+		for ( int i = 0; i < n; i++ ) {
+			constraints[ i ].SolveNormal( context );
+		}
+		return;
+	}
+
+	VecN impulses( 12 );
+	impulses.Zero();
+	for ( int i = 0; i < n; i++ ) {
+		const float dLambda = lambda[ i ] - oldLambda[ i ];
+		constraints[ i ].m_cachedLambda[ 0 ] = lambda[ i ];
+		for ( int k = 0; k < 12; k++ ) {
+			impulses[ k ] += J[ i ][ k ] * dLambda;
+		}
+	}
+	constraints[ 0 ].ApplyImpulses( impulses, context );
 }
\ No newline at end of file
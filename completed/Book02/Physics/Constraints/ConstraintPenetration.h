@@ -10,10 +10,24 @@ public:
 		m_cachedLambda.Zero();
 		m_baumgarte = 0.0f;
 		m_friction = 0.0f;
+		m_pseudoLambda = 0.0f;
+		m_normalMass = 0.0f;
 	}
 
-	void PreSolve( const float dt_sec ) override;
-	void Solve() override;
+	void PreSolve( const float dt_sec, solverContext_t & context ) override;
+	void Solve( solverContext_t & context ) override;
+	void SolvePositions() override;
+
+	// Used by the manifold block solver, which solves the normals of all its contacts together,
+	// and by manifold friction, which replaces the friction rows
+	void SolveNormal( solverContext_t & context );
+	void SolveFriction( solverContext_t & context );
+	static void SolveNormalBlock( ConstraintPenetration * constraints, const int numConstraints, solverContext_t & context );
+
+	constraintType_t GetType() const override { return CONSTRAINT_PENETRATION; }
+	int GetStateSize() const override { return m_cachedLambda.N; }
+	void SaveState( float * state ) const override { memcpy( state, m_cachedLambda.data, sizeof( float ) * m_cachedLambda.N ); }
+	void RestoreState( const float * state ) override { memcpy( m_cachedLambda.data, state, sizeof( float ) * m_cachedLambda.N ); }
 
 	VecN m_cachedLambda;
 	Vec3 m_normal;		// in Body A's local space
@@ -22,4 +36,6 @@ public:
 
 	float m_baumgarte;
 	float m_friction;
+	float m_pseudoLambda;	// accumulated split impulse along the normal
+	float m_normalMass;		// 1 / ( J W J^T ) of the normal row, for SolveNormal
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 //  GJK.cpp
 //
 #include "GJK.h"
+#include "Stats.h"
+#include <string.h>
 
 /*
 ================================================================================================
@@ -470,10 +472,10 @@ static int NumValids( const Vec4 & lambdas ) {
 
 /*
 ================================
-GJK_DoesIntersect
+GJK_Intersect
 ================================
 */
-bool GJK_DoesIntersect( const Body * bodyA, const Body * bodyB ) {
+static bool GJK_Intersect( const Body * bodyA, const Body * bodyB, int & numIters ) {
 	const Vec3 origin( 0.0f );
 
 	int numPts = 1;
@@ -483,7 +485,10 @@ bool GJK_DoesIntersect( const Body * bodyA, const Body * bodyB ) {
 	float closestDist = 1e10f;
 	bool doesContainOrigin = false;
 	Vec3 newDir = simplexPoints[ 0 ].xyz * -1.0f;
+	numIters = 0;
 	do {
+		numIters++;
+
 		// Get the new point to check on
 		point_t newPt = Support( bodyA, bodyB, newDir, 0.0f );
 
@@ -524,6 +529,33 @@ bool GJK_DoesIntersect( const Body * bodyA, const Body * bodyB ) {
 	return doesContainOrigin;
 }
 
+/*
+================================
+GJK_DoesIntersect
+================================
+*/
+bool GJK_DoesIntersect( const Body * bodyA, const Body * bodyB ) {
+	int numIters;
+	const bool doesIntersect = GJK_Intersect( bodyA, bodyB, numIters );
+
+	if ( NULL != g_collisionStats ) {
+		g_collisionStats->numGJK++;
+		g_collisionStats->gjkIterations[ physicsStats_t::HistogramBucket( numIters ) ]++;
+	}
+
+	return doesIntersect;
+}
+
+/*
+================================
+GJK_Overlap
+================================
+*/
+bool GJK_Overlap( const Body * bodyA, const Body * bodyB ) {
+	int numIters;
+	return GJK_Intersect( bodyA, bodyB, numIters );
+}
+
 void GJK_ClosestPoints( const Body * bodyA, const Body * bodyB, Vec3 & ptOnA, Vec3 & ptOnB ) {
 	const Vec3 origin( 0.0f );
 
@@ -536,7 +568,10 @@ void GJK_ClosestPoints( const Body * bodyA, const Body * bodyB, Vec3 & ptOnA, Ve
 
 	Vec4 lambdas = Vec4( 1, 0, 0, 0 );
 	Vec3 newDir = simplexPoints[ 0 ].xyz * -1.0f;
+	int numIters = 0;
 	do {
+		numIters++;
+
 		// Get the new point to check on
 		point_t newPt = Support( bodyA, bodyB, newDir, bias );
 
@@ -561,6 +596,11 @@ void GJK_ClosestPoints( const Body * bodyA, const Body * bodyB, Vec3 & ptOnA, Ve
 		closestDist = dist;
 	} while ( numPts < 4 );
 
+	if ( NULL != g_collisionStats ) {
+		g_collisionStats->numGJK++;
+		g_collisionStats->gjkIterations[ physicsStats_t::HistogramBucket( numIters ) ]++;
+	}
+
 	ptOnA.Zero();
 	ptOnB.Zero();
 	for ( int i = 0; i < 4; i++ ) {
@@ -579,7 +619,10 @@ bool GJK_DoesIntersect( const Body * bodyA, const Body * bodyB, const float bias
 	float closestDist = 1e10f;
 	bool doesContainOrigin = false;
 	Vec3 newDir = simplexPoints[ 0 ].xyz * -1.0f;
+	int numIters = 0;
 	do {
+		numIters++;
+
 		// Get the new point to check on
 		point_t newPt = Support( bodyA, bodyB, newDir, 0.0f );
 
@@ -617,6 +660,11 @@ bool GJK_DoesIntersect( const Body * bodyA, const Body * bodyB, const float bias
 		doesContainOrigin = ( 4 == numPts );
 	} while ( !doesContainOrigin );
 
+	if ( NULL != g_collisionStats ) {
+		g_collisionStats->numGJK++;
+		g_collisionStats->gjkIterations[ physicsStats_t::HistogramBucket( numIters ) ]++;
+	}
+
 	if ( !doesContainOrigin ) {
 		return false;
 	}
@@ -961,7 +1009,10 @@ float EPA_Expand( const Body * bodyA, const Body * bodyB, const float bias, cons
 	//
 	//	Expand the simplex to find the closest face of the CSO to the origin
 	//
+	int numIters = 0;
 	while ( 1 ) {
+		numIters++;
+
 		const int idx = ClosestTriangle( triangles, points );
 		Vec3 normal = NormalDirection( triangles[ idx ], points );
 
@@ -1015,6 +1066,11 @@ float EPA_Expand( const Body * bodyA, const Body * bodyB, const float bias, cons
 		}
 	}
 
+	if ( NULL != g_collisionStats ) {
+		g_collisionStats->numEPA++;
+		g_collisionStats->epaIterations[ physicsStats_t::HistogramBucket( numIters ) ]++;
+	}
+
 	// Get the projection of the origin on the closest triangle
 	const int idx = ClosestTriangle( triangles, points );
 	const tri_t & tri = triangles[ idx ];
@@ -1038,4 +1094,153 @@ float EPA_Expand( const Body * bodyA, const Body * bodyB, const float bias, cons
 	// Return the penetration distance
 	Vec3 delta = ptOnB - ptOnA;
 	return delta.GetMagnitude();
-}
\ No newline at end of file
+}
+
+/*
+================================================================================================
+
+Shape casts
+
+================================================================================================
+*/
+
+/*
+================================
+CastSupport
+The point of B - A furthest along dir, where A is a point when shapeA is NULL
+================================
+*/
+static point_t CastSupport( const Shape * shapeA, const Vec3 & posA, const Quat & orientA, const Shape * shapeB, const Vec3 & posB, const Quat & orientB, Vec3 dir ) {
+	dir.Normalize();
+
+	point_t point;
+	point.ptB = shapeB->Support( dir, posB, orientB, 0.0f );
+	point.ptA = ( NULL != shapeA ) ? shapeA->Support( dir * -1.0f, posA, orientA, 0.0f ) : posA;
+	point.xyz = point.ptB - point.ptA;
+	return point;
+}
+
+/*
+================================
+GJK_CastShape
+
+Ray casts against the configuration space obstacle B - A (van den Bergen, "Ray Casting against
+General Convex Objects with Application to Continuous Collision Detection").  A moved by
+t * translation touches B when t * translation is in B - A, so casting a ray from the origin
+along translation finds the first time they touch.
+
+The simplex keeps the points of B - A, each iteration measures them from the current point on
+the ray.  Whenever the closest point of the simplex shows that B - A lies entirely behind a plane
+the ray point is in front of, the ray point jumps forward to that plane, which is a conservative
+advance.  It stops when the ray point is on B - A, or when the ray leaves through the plane.
+================================
+*/
+bool GJK_CastShape( const Shape * shapeA, const Vec3 & posA, const Quat & orientA, const Vec3 & translation, const Shape * shapeB, const Vec3 & posB, const Quat & orientB, const float maxFraction, float & fraction, Vec3 & normal, Vec3 & ptOnB ) {
+	const float epsilon = 1e-4f;
+	const int maxIters = 32;
+
+	point_t cso[ 4 ];		// points of B - A
+	point_t simplex[ 4 ];	// the same points measured from the ray point
+	Vec4 lambdas( 1, 0, 0, 0 );
+	int numPts = 0;
+
+	float t = 0.0f;
+	Vec3 x( 0.0f );
+	Vec3 n( 0.0f );
+	Vec3 v = x - CastSupport( shapeA, posA, orientA, shapeB, posB, orientB, translation * -1.0f ).xyz;
+
+	int numIters = 0;
+	while ( v.GetLengthSqr() > epsilon * epsilon ) {
+		if ( ++numIters > maxIters ) {
+			// Curved shapes converge slowly, close is good enough
+			if ( v.GetLengthSqr() > 1e-4f ) {
+				return false;
+			}
+			break;
+		}
+
+		const point_t p = CastSupport( shapeA, posA, orientA, shapeB, posB, orientB, v );
+		const Vec3 w = x - p.xyz;
+		const float vw = v.Dot( w );
+
+		bool isNew = true;
+		for ( int i = 0; i < numPts; i++ ) {
+			if ( ( cso[ i ].xyz - p.xyz ).GetLengthSqr() < 1e-12f ) {
+				isNew = false;
+			}
+		}
+
+		if ( vw > 0.0f ) {
+			// Everything of B - A is behind the plane through p, advance to it or miss
+			const float vr = v.Dot( translation );
+			if ( vr >= 0.0f ) {
+				return false;
+			}
+			t -= vw / vr;
+			if ( t > maxFraction ) {
+				return false;
+			}
+			x = translation * t;
+			n = v;
+		} else if ( !isNew || v.GetLengthSqr() - vw <= epsilon * epsilon ) {
+			// p is no further out than the closest point already is, so the ray point is as close as it
+			// gets.  On large shapes rounding in the simplex solve can leave v short of zero with the
+			// support point already in the simplex, and the same iteration would just repeat.
+			break;
+		}
+
+		if ( isNew && numPts < 4 ) {
+			cso[ numPts ] = p;
+			numPts++;
+		}
+
+		for ( int i = 0; i < numPts; i++ ) {
+			simplex[ i ] = cso[ i ];
+			simplex[ i ].xyz = x - cso[ i ].xyz;
+		}
+		if ( 1 == numPts ) {
+			lambdas = Vec4( 1, 0, 0, 0 );
+			v = simplex[ 0 ].xyz;
+		} else {
+			Vec3 newDir;
+			SimplexSignedVolumes( simplex, numPts, newDir, lambdas );
+			v = newDir * -1.0f;
+		}
+
+		// Drop the points that don't support the closest point
+		int numValid = 0;
+		for ( int i = 0; i < numPts; i++ ) {
+			if ( 0.0f != lambdas[ i ] ) {
+				cso[ numValid ] = cso[ i ];
+				lambdas[ numValid ] = lambdas[ i ];
+				numValid++;
+			}
+		}
+		for ( int i = numValid; i < 4; i++ ) {
+			lambdas[ i ] = 0.0f;
+		}
+		numPts = numValid;
+		if ( 4 == numPts ) {
+			break;	// the ray point is inside B - A
+		}
+	}
+
+	fraction = t;
+	normal = n;
+	if ( normal.GetLengthSqr() > 0.0f ) {
+		normal.Normalize();
+	}
+
+	ptOnB.Zero();
+	float sum = 0.0f;
+	for ( int i = 0; i < numPts; i++ ) {
+		ptOnB += cso[ i ].ptB * lambdas[ i ];
+		sum += lambdas[ i ];
+	}
+	if ( sum > 0.0f ) {
+		ptOnB = ptOnB / sum;
+	} else {
+		ptOnB = posA + translation * t;
+	}
+	return true;
+}
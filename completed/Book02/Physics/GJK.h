@@ -13,5 +13,14 @@ bool GJK_DoesIntersect( const Body * bodyA, const Body * bodyB );
 bool GJK_DoesIntersect( const Body * bodyA, const Body * bodyB, const float bias, Vec3 & ptOnA, Vec3 & ptOnB );
 void GJK_ClosestPoints( const Body * bodyA, const Body * bodyB, Vec3 & ptOnA, Vec3 & ptOnB );
 
+// The same test as GJK_DoesIntersect, but it isn't counted in g_collisionStats, so scene queries
+// can run it between updates and on other threads
+bool GJK_Overlap( const Body * bodyA, const Body * bodyB );
+
+// Sweeps shapeA from posA by translation against shapeB, and finds the first fraction of the
+// translation at which they touch, with the normal of B there and the point on B.  A NULL shapeA
+// casts a ray from posA.  Starting out overlapping is a hit at zero with no normal.
+bool GJK_CastShape( const Shape * shapeA, const Vec3 & posA, const Quat & orientA, const Vec3 & translation, const Shape * shapeB, const Vec3 & posB, const Quat & orientB, const float maxFraction, float & fraction, Vec3 & normal, Vec3 & ptOnB );
+
 struct point_t;
 float EPA_Expand( const Body * bodyA, const Body * bodyB, const float bias, const point_t simplexPoints[ 4 ], Vec3 & ptOnA, Vec3 & ptOnB );
\ No newline at end of file
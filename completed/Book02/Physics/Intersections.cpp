@@ -3,6 +3,8 @@
 //
 #include "Intersections.h"
 #include "GJK.h"
+#include "Stats.h"
+#include <algorithm>
 
 
 /*
@@ -27,12 +29,309 @@ bool SphereSphereStatic( const ShapeSphere * sphereA, const ShapeSphere * sphere
 	return false;
 }
 
+/*
+====================================================
+ClosestPointsSegmentSegment
+====================================================
+*/
+void ClosestPointsSegmentSegment( const Vec3 & a0, const Vec3 & a1, const Vec3 & b0, const Vec3 & b1, Vec3 & ptOnA, Vec3 & ptOnB ) {
+	const Vec3 dirA = a1 - a0;
+	const Vec3 dirB = b1 - b0;
+	const Vec3 r = a0 - b0;
+	const float lengthSqrA = dirA.GetLengthSqr();
+	const float lengthSqrB = dirB.GetLengthSqr();
+	const float f = dirB.Dot( r );
+	const float epsilon = 1e-12f;
+
+	// Parameters along each segment, s for A and t for B
+	float s = 0.0f;
+	float t = 0.0f;
+	if ( lengthSqrA <= epsilon && lengthSqrB <= epsilon ) {
+		// Both are points
+	} else if ( lengthSqrA <= epsilon ) {
+		t = std::max( 0.0f, std::min( 1.0f, f / lengthSqrB ) );
+	} else {
+		const float c = dirA.Dot( r );
+		if ( lengthSqrB <= epsilon ) {
+			s = std::max( 0.0f, std::min( 1.0f, -c / lengthSqrA ) );
+		} else {
+			// Closest points of the infinite lines, clamped to A, then B's point for that
+			const float b = dirA.Dot( dirB );
+			const float denom = lengthSqrA * lengthSqrB - b * b;
+			if ( denom > epsilon ) {
+				s = std::max( 0.0f, std::min( 1.0f, ( b * f - c * lengthSqrB ) / denom ) );
+			}
+			t = ( b * s + f ) / lengthSqrB;
+
+			// If B's point is off the end of B, clamp it and find A's point again
+			if ( t < 0.0f ) {
+				t = 0.0f;
+				s = std::max( 0.0f, std::min( 1.0f, -c / lengthSqrA ) );
+			} else if ( t > 1.0f ) {
+				t = 1.0f;
+				s = std::max( 0.0f, std::min( 1.0f, ( b - c ) / lengthSqrA ) );
+			}
+		}
+	}
+
+	ptOnA = a0 + dirA * s;
+	ptOnB = b0 + dirB * t;
+}
+
+/*
+====================================================
+HasCoreSegment
+Spheres and capsules are a segment with a radius, a sphere's segment is a point
+====================================================
+*/
+static bool HasCoreSegment( const Body * body ) {
+	const Shape::shapeType_t type = body->m_shape->GetType();
+	return ( Shape::SHAPE_SPHERE == type || Shape::SHAPE_CAPSULE == type );
+}
+
+/*
+====================================================
+GetCoreSegment
+====================================================
+*/
+static void GetCoreSegment( const Body * body, Vec3 & a, Vec3 & b, float & radius ) {
+	const Shape * shape = body->m_shape;
+	if ( Shape::SHAPE_CAPSULE == shape->GetType() ) {
+		const ShapeCapsule * capsule = (const ShapeCapsule *)shape;
+		capsule->GetSegment( body->m_position, body->m_orientation, a, b );
+		radius = capsule->m_radius;
+		return;
+	}
+
+	a = body->m_position;
+	b = body->m_position;
+	radius = ( (const ShapeSphere *)shape )->m_radius;
+}
+
+/*
+====================================================
+SegmentSegmentStatic
+Contact between two swept spheres, the closest points of their segments give the normal
+====================================================
+*/
+static bool SegmentSegmentStatic( Body * bodyA, Body * bodyB, contact_t & contact ) {
+	Vec3 a0;
+	Vec3 a1;
+	Vec3 b0;
+	Vec3 b1;
+	float radiusA;
+	float radiusB;
+	GetCoreSegment( bodyA, a0, a1, radiusA );
+	GetCoreSegment( bodyB, b0, b1, radiusB );
+
+	Vec3 closestA;
+	Vec3 closestB;
+	ClosestPointsSegmentSegment( a0, a1, b0, b1, closestA, closestB );
+
+	Vec3 ab = closestB - closestA;
+	const float distance = ab.GetMagnitude();
+	if ( distance > 1e-6f ) {
+		ab *= 1.0f / distance;
+	} else {
+		// The segments cross, push apart perpendicular to both of them
+		ab = ( a1 - a0 ).Cross( b1 - b0 );
+		if ( ab.GetLengthSqr() < 1e-12f ) {
+			ab = bodyB->m_position - bodyA->m_position;
+		}
+		if ( ab.GetLengthSqr() < 1e-12f ) {
+			ab = Vec3( 0, 0, 1 );
+		}
+		ab.Normalize();
+	}
+
+	contact.ptOnA_WorldSpace = closestA + ab * radiusA;
+	contact.ptOnB_WorldSpace = closestB - ab * radiusB;
+	contact.normal = ab * -1.0f;
+
+	contact.ptOnA_LocalSpace = bodyA->WorldSpaceToBodySpace( contact.ptOnA_WorldSpace );
+	contact.ptOnB_LocalSpace = bodyB->WorldSpaceToBodySpace( contact.ptOnB_WorldSpace );
+
+	contact.separationDistance = distance - ( radiusA + radiusB );
+	return ( contact.separationDistance <= 0.0f );
+}
+
+/*
+====================================================
+GetPartBody
+====================================================
+*/
+void GetPartBody( const Body * body, Shape * shape, const Vec3 & localPos, const Quat & localOrient, Body & part ) {
+	part = *body;
+	part.m_shape = shape;
+	part.m_position = body->m_position + body->m_orientation.RotatePoint( localPos );
+	part.m_orientation = body->m_orientation * localOrient;
+
+	// The part's center of mass is carried around the body's by the body's spin
+	const Vec3 r = part.GetCenterOfMassWorldSpace() - body->GetCenterOfMassWorldSpace();
+	part.m_linearVelocity = body->m_linearVelocity + body->m_angularVelocity.Cross( r );
+}
+
+/*
+====================================================
+GetCompoundChild
+====================================================
+*/
+void GetCompoundChild( const Body * body, const int childIdx, Body & child ) {
+	const compoundChild_t & compoundChild = ( (const ShapeCompound *)body->m_shape )->m_children[ childIdx ];
+	GetPartBody( body, compoundChild.shape, compoundChild.position, compoundChild.orientation, child );
+}
+
+/*
+====================================================
+HasParts
+Compounds are tested child by child, and meshes and heightfields triangle by triangle
+====================================================
+*/
+static bool HasParts( const Body * body ) {
+	const Shape::shapeType_t type = body->m_shape->GetType();
+	return ( Shape::SHAPE_COMPOUND == type || Shape::SHAPE_TRIANGLE_MESH == type || Shape::SHAPE_HEIGHTFIELD == type );
+}
+
+/*
+====================================================
+SwapContact
+====================================================
+*/
+static void SwapContact( contact_t & contact ) {
+	std::swap( contact.bodyA, contact.bodyB );
+	std::swap( contact.ptOnA_WorldSpace, contact.ptOnB_WorldSpace );
+	std::swap( contact.ptOnA_LocalSpace, contact.ptOnB_LocalSpace );
+	contact.normal *= -1.0f;
+}
+
+/*
+====================================================
+IntersectParts
+Tests the parts of A near B, and keeps the earliest (then deepest) contact.  B may have parts too,
+the test of each of A's parts against it then recurses into B's.
+====================================================
+*/
+static bool IntersectParts( Body * bodyA, Body * bodyB, const bool isDynamic, const float dt, contact_t & contact ) {
+	const Shape * shape = bodyA->m_shape;
+
+	// B's bounds in A's space.  For the dynamic test they're swept by B's motion relative to A, and
+	// grown by how far A's spin can carry its parts.
+	Bounds bounds = bodyB->m_shape->GetBounds( bodyB->m_position, bodyB->m_orientation );
+	if ( isDynamic ) {
+		const Vec3 relativeVelocity = bodyB->m_linearVelocity - bodyA->m_linearVelocity;
+		bounds.Expand( bounds.mins + relativeVelocity * dt );
+		bounds.Expand( bounds.maxs + relativeVelocity * dt );
+
+		float radius = 0.0f;
+		const Bounds shapeBounds = shape->GetBounds();
+		const Vec3 corners[ 2 ] = { shapeBounds.mins - shape->GetCenterOfMass(), shapeBounds.maxs - shape->GetCenterOfMass() };
+		for ( int j = 0; j < 8; j++ ) {
+			const Vec3 corner( corners[ j & 1 ].x, corners[ ( j >> 1 ) & 1 ].y, corners[ j >> 2 ].z );
+			radius = std::max( radius, corner.GetMagnitude() );
+		}
+		const float spin = bodyA->m_angularVelocity.GetMagnitude() * radius * dt;
+		bounds.mins -= Vec3( spin );
+		bounds.maxs += Vec3( spin );
+	}
+	const Bounds localBounds = ShapeCompound::ToLocalBounds( bounds, bodyA->m_position, bodyA->m_orientation );
+
+	bool didIntersect = false;
+	contact.bodyA = bodyA;
+	contact.bodyB = bodyB;
+	contact.timeOfImpact = 0.0f;
+	contact.separationDistance = 1e30f;
+	auto testPart = [ & ]( Body & part ) {
+		contact_t partContact;
+		partContact.separationDistance = 1e30f;
+		const bool partIntersect = isDynamic ? Intersect( &part, bodyB, dt, partContact ) : Intersect( &part, bodyB, partContact );
+		if ( partIntersect ) {
+			if ( !didIntersect || partContact.timeOfImpact < contact.timeOfImpact ||
+				( partContact.timeOfImpact == contact.timeOfImpact && partContact.separationDistance < contact.separationDistance ) ) {
+				contact = partContact;
+			}
+			didIntersect = true;
+		} else if ( !didIntersect && partContact.separationDistance < contact.separationDistance ) {
+			// The nearest miss, for conservative advancement
+			contact = partContact;
+		}
+	};
+
+	switch ( shape->GetType() ) {
+		case Shape::SHAPE_COMPOUND: {
+			auto callback = [ & ]( const int childIdx ) {
+				Body child;
+				GetCompoundChild( bodyA, childIdx, child );
+				testPart( child );
+				return true;
+			};
+			( (const ShapeCompound *)shape )->m_tree.QueryBounds( localBounds, callback );
+		} break;
+		case Shape::SHAPE_TRIANGLE_MESH: {
+			const ShapeTriangleMesh * mesh = (const ShapeTriangleMesh *)shape;
+			auto callback = [ & ]( const int triangleIdx ) {
+				Vec3 a;
+				Vec3 b;
+				Vec3 c;
+				mesh->GetTriangle( triangleIdx, a, b, c );
+				ShapeTriangle triangle( a, b, c );
+				Body part;
+				GetPartBody( bodyA, &triangle, Vec3( 0.0f ), Quat( 0, 0, 0, 1 ), part );
+				testPart( part );
+				return true;
+			};
+			mesh->QueryTriangles( localBounds, callback );
+		} break;
+		case Shape::SHAPE_HEIGHTFIELD: {
+			const ShapeHeightfield * heightfield = (const ShapeHeightfield *)shape;
+			auto callback = [ & ]( const int triangleIdx ) {
+				Vec3 a;
+				Vec3 b;
+				Vec3 c;
+				heightfield->GetTriangle( triangleIdx, a, b, c );
+				ShapeTriangle triangle( a, b, c );
+				Body part;
+				GetPartBody( bodyA, &triangle, Vec3( 0.0f ), Quat( 0, 0, 0, 1 ), part );
+				testPart( part );
+				return true;
+			};
+			heightfield->QueryTriangles( localBounds, callback );
+		} break;
+		default: break;
+	}
+
+	contact.bodyA = bodyA;
+	contact.bodyB = bodyB;
+	if ( contact.separationDistance == 1e30f ) {
+		// No part was near enough to test
+		return false;
+	}
+
+	// The part's contact point, in the space of the whole body at the time of impact
+	if ( contact.timeOfImpact > 0.0f ) {
+		bodyA->Update( contact.timeOfImpact );
+		contact.ptOnA_LocalSpace = bodyA->WorldSpaceToBodySpace( contact.ptOnA_WorldSpace );
+		bodyA->Update( -contact.timeOfImpact );
+	} else {
+		contact.ptOnA_LocalSpace = bodyA->WorldSpaceToBodySpace( contact.ptOnA_WorldSpace );
+	}
+	return didIntersect;
+}
+
 /*
 ====================================================
 Intersect
 ====================================================
 */
 bool Intersect( Body * bodyA, Body * bodyB, contact_t & contact ) {
+	if ( HasParts( bodyA ) ) {
+		return IntersectParts( bodyA, bodyB, false, 0.0f, contact );
+	}
+	if ( HasParts( bodyB ) ) {
+		const bool didIntersect = IntersectParts( bodyB, bodyA, false, 0.0f, contact );
+		SwapContact( contact );
+		return didIntersect;
+	}
+
 	contact.bodyA = bodyA;
 	contact.bodyB = bodyB;
 	contact.timeOfImpact = 0.0f;
@@ -56,6 +355,8 @@ bool Intersect( Body * bodyA, Body * bodyB, contact_t & contact ) {
 			contact.separationDistance = r;
 			return true;
 		}
+	} else if ( HasCoreSegment( bodyA ) && HasCoreSegment( bodyB ) ) {
+		return SegmentSegmentStatic( bodyA, bodyB, contact );
 	} else {
 		Vec3 ptOnA;
 		Vec3 ptOnB;
@@ -118,6 +419,11 @@ bool ConservativeAdvance( Body * bodyA, Body * bodyB, float dt, contact_t & cont
 			contact.timeOfImpact = toi;
 			bodyA->Update( -toi );
 			bodyB->Update( -toi );
+
+			if ( NULL != g_collisionStats ) {
+				g_collisionStats->numConservativeAdvance++;
+				g_collisionStats->conservativeAdvanceIterations[ physicsStats_t::HistogramBucket( numIters ) ]++;
+			}
 			return true;
 		}
 
@@ -156,6 +462,11 @@ bool ConservativeAdvance( Body * bodyA, Body * bodyB, float dt, contact_t & cont
 	// unwind the clock
 	bodyA->Update( -toi );
 	bodyB->Update( -toi );
+
+	if ( NULL != g_collisionStats ) {
+		g_collisionStats->numConservativeAdvance++;
+		g_collisionStats->conservativeAdvanceIterations[ physicsStats_t::HistogramBucket( numIters ) ]++;
+	}
 	return false;
 }
 
@@ -244,6 +555,15 @@ Intersect
 ====================================================
 */
 bool Intersect( Body * bodyA, Body * bodyB, const float dt, contact_t & contact ) {
+	if ( HasParts( bodyA ) ) {
+		return IntersectParts( bodyA, bodyB, true, dt, contact );
+	}
+	if ( HasParts( bodyB ) ) {
+		const bool didIntersect = IntersectParts( bodyB, bodyA, true, dt, contact );
+		SwapContact( contact );
+		return didIntersect;
+	}
+
 	contact.bodyA = bodyA;
 	contact.bodyB = bodyB;
 
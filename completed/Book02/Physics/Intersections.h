@@ -5,4 +5,15 @@
 #include "Contact.h"
 
 bool Intersect( Body * bodyA, Body * bodyB, contact_t & contact );
-bool Intersect( Body * bodyA, Body * bodyB, const float dt, contact_t & contact );
\ No newline at end of file
+bool Intersect( Body * bodyA, Body * bodyB, const float dt, contact_t & contact );
+
+// A stand in for part of a body, like a child of a compound or a triangle of a mesh, placed and
+// moving with the body.  The part's shape is placed at localPos and localOrient in the body's space.
+void GetPartBody( const Body * body, Shape * shape, const Vec3 & localPos, const Quat & localOrient, Body & part );
+void GetCompoundChild( const Body * body, const int childIdx, Body & child );
+
+// Solves for where the ray rayStart + t * rayDir enters (t1) and leaves (t2) the sphere, false if it misses
+bool RaySphere( const Vec3 & rayStart, const Vec3 & rayDir, const Vec3 & sphereCenter, const float sphereRadius, float & t1, float & t2 );
+
+// Closest points between the segments a0-a1 and b0-b1
+void ClosestPointsSegmentSegment( const Vec3 & a0, const Vec3 & a1, const Vec3 & b0, const Vec3 & b1, Vec3 & ptOnA, Vec3 & ptOnB );
\ No newline at end of file
@@ -0,0 +1,384 @@
+//
+//	JointTree.cpp
+//
+#include "JointTree.h"
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+
+/*
+====================================================
+InvertSymmetric
+Inverts a small symmetric block through its LDLt factorization.  Pivots that are negligible next
+to the largest diagonal entry are dropped, so a joint row that has degenerated (the hinge's
+distance row once the anchors meet) gets no impulse instead of an enormous one.
+====================================================
+*/
+static void InvertSymmetric( const float A[ JointTree::MAX_BLOCK ][ JointTree::MAX_BLOCK ], const int n, float inv[ JointTree::MAX_BLOCK ][ JointTree::MAX_BLOCK ] ) {
+	ldlt_t ldlt;
+	LCP_FactorLDLT( A, n, 1e-6f, ldlt );
+
+	// Solve for each column of the identity
+	for ( int c = 0; c < n; c++ ) {
+		float e[ JointTree::MAX_BLOCK ] = { 0.0f };
+		float x[ JointTree::MAX_BLOCK ];
+		e[ c ] = 1.0f;
+		LCP_SolveLDLT( ldlt, e, x );
+		for ( int i = 0; i < n; i++ ) {
+			inv[ i ][ c ] = x[ i ];
+		}
+	}
+}
+
+/*
+====================================================
+JointTree::FindRoot
+====================================================
+*/
+int JointTree::FindRoot( int idx ) {
+	while ( m_unionParent[ idx ] != idx ) {
+		m_unionParent[ idx ] = m_unionParent[ m_unionParent[ idx ] ];	// path halving
+		idx = m_unionParent[ idx ];
+	}
+	return idx;
+}
+
+/*
+====================================================
+JointTree::Build
+====================================================
+*/
+void JointTree::Build( Constraint * const * constraints, const int * indices, const int numConstraints, const float dt_sec, const solverContext_t & context ) {
+	m_joints.clear();
+	m_bodies.clear();
+	m_nodes.clear();
+	m_order.clear();
+	m_remaining.clear();
+
+	//
+	//	Gather the dynamic bodies, sorted so they can be looked up by address
+	//
+	for ( int i = 0; i < numConstraints; i++ ) {
+		const Constraint * constraint = constraints[ indices[ i ] ];
+		if ( 0.0f != constraint->m_bodyA->m_invMass ) {
+			m_bodies.push_back( constraint->m_bodyA );
+		}
+		if ( 0.0f != constraint->m_bodyB->m_invMass ) {
+			m_bodies.push_back( constraint->m_bodyB );
+		}
+	}
+	std::sort( m_bodies.begin(), m_bodies.end() );
+	m_bodies.erase( std::unique( m_bodies.begin(), m_bodies.end() ), m_bodies.end() );
+	const int numBodies = (int)m_bodies.size();
+
+	//
+	//	Add the joints that don't close a loop.  Every static body is the same element,
+	//	the world, so two joints to static bodies in one tree are a loop too.
+	//
+	const int world = numBodies;
+	m_unionParent.resize( numBodies + 1 );
+	for ( int i = 0; i <= numBodies; i++ ) {
+		m_unionParent[ i ] = i;
+	}
+
+	for ( int i = 0; i < numConstraints; i++ ) {
+		Constraint * constraint = constraints[ indices[ i ] ];
+
+		joint_t joint;
+		joint.constraint = constraint;
+		joint.index = indices[ i ];
+		joint.impulse = Vec3( 0.0f );
+		joint.numRows = constraint->GetJointRows( joint.jacobian, joint.bias, dt_sec, context );
+		if ( 0 == joint.numRows ) {
+			m_remaining.push_back( constraint );
+			continue;
+		}
+
+		const Body * bodies[ 2 ] = { constraint->m_bodyA, constraint->m_bodyB };
+		int elements[ 2 ];
+		for ( int j = 0; j < 2; j++ ) {
+			joint.bodyNodes[ j ] = -1;
+			elements[ j ] = world;
+			if ( 0.0f != bodies[ j ]->m_invMass ) {
+				joint.bodyNodes[ j ] = (int)( std::lower_bound( m_bodies.begin(), m_bodies.end(), bodies[ j ] ) - m_bodies.begin() );
+				elements[ j ] = joint.bodyNodes[ j ];
+			}
+		}
+
+		const int rootA = FindRoot( elements[ 0 ] );
+		const int rootB = FindRoot( elements[ 1 ] );
+		if ( rootA == rootB ) {
+			m_remaining.push_back( constraint );
+			continue;
+		}
+		m_unionParent[ rootA ] = rootB;
+		m_joints.push_back( joint );
+	}
+
+	//
+	//	Body nodes come first, then a node for every joint
+	//
+	const int numJoints = (int)m_joints.size();
+	const int numNodes = numBodies + numJoints;
+	m_nodes.resize( numNodes );
+	for ( int i = 0; i < numNodes; i++ ) {
+		node_t & node = m_nodes[ i ];
+		node.parent = -1;
+		node.body = ( i < numBodies ) ? i : -1;
+		node.joint = ( i < numBodies ) ? -1 : ( i - numBodies );
+		node.dim = ( i < numBodies ) ? 6 : m_joints[ i - numBodies ].numRows;
+	}
+
+	m_adjacencyStart.assign( numNodes + 1, 0 );
+	for ( int j = 0; j < numJoints; j++ ) {
+		for ( int k = 0; k < 2; k++ ) {
+			if ( m_joints[ j ].bodyNodes[ k ] >= 0 ) {
+				m_adjacencyStart[ m_joints[ j ].bodyNodes[ k ] + 1 ]++;
+				m_adjacencyStart[ numBodies + j + 1 ]++;
+			}
+		}
+	}
+	for ( int i = 0; i < numNodes; i++ ) {
+		m_adjacencyStart[ i + 1 ] += m_adjacencyStart[ i ];
+	}
+	m_adjacency.resize( m_adjacencyStart[ numNodes ] );
+	m_adjacencyFill.assign( m_adjacencyStart.begin(), m_adjacencyStart.end() - 1 );
+	for ( int j = 0; j < numJoints; j++ ) {
+		for ( int k = 0; k < 2; k++ ) {
+			const int bodyNode = m_joints[ j ].bodyNodes[ k ];
+			if ( bodyNode >= 0 ) {
+				m_adjacency[ m_adjacencyFill[ bodyNode ]++ ] = numBodies + j;
+				m_adjacency[ m_adjacencyFill[ numBodies + j ]++ ] = bodyNode;
+			}
+		}
+	}
+
+	//
+	//	Order the nodes parents first.  A joint to the world has no children until it's the
+	//	root, and a leaf joint would have nothing to eliminate it with, so trees that are
+	//	attached to the world are rooted at that joint.
+	//
+	m_isVisited.assign( numNodes, false );
+	for ( int pass = 0; pass < 2; pass++ ) {
+		for ( int i = 0; i < numNodes; i++ ) {
+			if ( m_isVisited[ i ] ) {
+				continue;
+			}
+			if ( 0 == pass && ( m_nodes[ i ].joint < 0 || ( m_joints[ m_nodes[ i ].joint ].bodyNodes[ 0 ] >= 0 && m_joints[ m_nodes[ i ].joint ].bodyNodes[ 1 ] >= 0 ) ) ) {
+				continue;
+			}
+
+			m_isVisited[ i ] = true;
+			int next = (int)m_order.size();
+			m_order.push_back( i );
+			while ( next < m_order.size() ) {
+				const int nodeIdx = m_order[ next++ ];
+				for ( int k = m_adjacencyStart[ nodeIdx ]; k < m_adjacencyStart[ nodeIdx + 1 ]; k++ ) {
+					const int neighbor = m_adjacency[ k ];
+					if ( !m_isVisited[ neighbor ] ) {
+						m_isVisited[ neighbor ] = true;
+						m_nodes[ neighbor ].parent = nodeIdx;
+						m_order.push_back( neighbor );
+					}
+				}
+			}
+		}
+	}
+
+	Factor();
+}
+
+/*
+====================================================
+JointTree::GetParentBlock
+The block of the system that couples a node to its parent, node dim x parent dim
+====================================================
+*/
+void JointTree::GetParentBlock( const int nodeIdx, float block[ MAX_BLOCK ][ MAX_BLOCK ] ) const {
+	const node_t & node = m_nodes[ nodeIdx ];
+	const node_t & parent = m_nodes[ node.parent ];
+
+	const bool isJoint = ( node.joint >= 0 );
+	const joint_t & joint = m_joints[ isJoint ? node.joint : parent.joint ];
+	const int bodyNode = isJoint ? node.parent : nodeIdx;
+	const int offset = ( joint.bodyNodes[ 0 ] == bodyNode ) ? 0 : 6;
+
+	for ( int r = 0; r < joint.numRows; r++ ) {
+		for ( int c = 0; c < 6; c++ ) {
+			if ( isJoint ) {
+				block[ r ][ c ] = -joint.jacobian[ r ][ offset + c ];
+			} else {
+				block[ c ][ r ] = -joint.jacobian[ r ][ offset + c ];
+			}
+		}
+	}
+}
+
+/*
+====================================================
+JointTree::Factor
+Eliminates the nodes children first.  Each node's diagonal block starts as the body's mass matrix
+or zero for a joint, and every child subtracts its Schur complement from it.
+====================================================
+*/
+void JointTree::Factor() {
+	for ( int i = 0; i < m_nodes.size(); i++ ) {
+		node_t & node = m_nodes[ i ];
+		memset( node.invD, 0, sizeof( node.invD ) );
+		if ( node.body < 0 ) {
+			continue;
+		}
+
+		// Diagonal block for a body is its mass matrix, held in invD until the node is inverted
+		const Body * body = m_bodies[ node.body ];
+		const float mass = 1.0f / body->m_invMass;
+		const Mat3 inertia = body->GetInverseInertiaTensorWorldSpace().Inverse();
+		for ( int j = 0; j < 3; j++ ) {
+			node.invD[ j ][ j ] = mass;
+			for ( int k = 0; k < 3; k++ ) {
+				node.invD[ 3 + j ][ 3 + k ] = inertia.rows[ j ][ k ];
+			}
+		}
+	}
+
+	float D[ MAX_BLOCK ][ MAX_BLOCK ];
+	float block[ MAX_BLOCK ][ MAX_BLOCK ];
+	for ( int n = (int)m_order.size() - 1; n >= 0; n-- ) {
+		node_t & node = m_nodes[ m_order[ n ] ];
+		memcpy( D, node.invD, sizeof( D ) );
+		InvertSymmetric( D, node.dim, node.invD );
+
+		if ( node.parent < 0 ) {
+			continue;
+		}
+
+		// L = D^-1 * B and the parent's block loses Bt * D^-1 * B
+		node_t & parent = m_nodes[ node.parent ];
+		GetParentBlock( m_order[ n ], block );
+		for ( int r = 0; r < node.dim; r++ ) {
+			for ( int c = 0; c < parent.dim; c++ ) {
+				float sum = 0.0f;
+				for ( int k = 0; k < node.dim; k++ ) {
+					sum += node.invD[ r ][ k ] * block[ k ][ c ];
+				}
+				node.L[ r ][ c ] = sum;
+			}
+		}
+		for ( int r = 0; r < parent.dim; r++ ) {
+			for ( int c = 0; c < parent.dim; c++ ) {
+				float sum = 0.0f;
+				for ( int k = 0; k < node.dim; k++ ) {
+					sum += block[ k ][ r ] * node.L[ k ][ c ];
+				}
+				parent.invD[ r ][ c ] -= sum;
+			}
+		}
+	}
+}
+
+/*
+====================================================
+JointTree::Solve
+====================================================
+*/
+void JointTree::Solve( solverContext_t & context ) {
+	//
+	//	Right hand side, nothing for the bodies and each row's velocity error for the joints
+	//
+	const int numBodies = (int)m_bodies.size();
+	for ( int i = 0; i < m_nodes.size(); i++ ) {
+		node_t & node = m_nodes[ i ];
+		memset( node.x, 0, sizeof( node.x ) );
+		if ( node.joint < 0 ) {
+			continue;
+		}
+
+		const joint_t & joint = m_joints[ node.joint ];
+		const Body * bodies[ 2 ] = { joint.constraint->m_bodyA, joint.constraint->m_bodyB };
+		for ( int r = 0; r < joint.numRows; r++ ) {
+			float Jv = joint.bias[ r ];
+			for ( int j = 0; j < 2; j++ ) {
+				const float * row = joint.jacobian[ r ] + j * 6;
+				Jv += row[ 0 ] * bodies[ j ]->m_linearVelocity.x + row[ 1 ] * bodies[ j ]->m_linearVelocity.y + row[ 2 ] * bodies[ j ]->m_linearVelocity.z;
+				Jv += row[ 3 ] * bodies[ j ]->m_angularVelocity.x + row[ 4 ] * bodies[ j ]->m_angularVelocity.y + row[ 5 ] * bodies[ j ]->m_angularVelocity.z;
+			}
+			node.x[ r ] = Jv;
+		}
+	}
+
+	//
+	//	Children first, each pushes its part of the right hand side up to its parent
+	//
+	for ( int n = (int)m_order.size() - 1; n >= 0; n-- ) {
+		const node_t & node = m_nodes[ m_order[ n ] ];
+		if ( node.parent < 0 ) {
+			continue;
+		}
+		node_t & parent = m_nodes[ node.parent ];
+		for ( int c = 0; c < parent.dim; c++ ) {
+			for ( int k = 0; k < node.dim; k++ ) {
+				parent.x[ c ] -= node.L[ k ][ c ] * node.x[ k ];
+			}
+		}
+	}
+
+	//
+	//	Then parents first, each node's solution follows from its parent's
+	//
+	for ( int n = 0; n < m_order.size(); n++ ) {
+		node_t & node = m_nodes[ m_order[ n ] ];
+		float x[ MAX_BLOCK ];
+		for ( int r = 0; r < node.dim; r++ ) {
+			x[ r ] = 0.0f;
+			for ( int k = 0; k < node.dim; k++ ) {
+				x[ r ] += node.invD[ r ][ k ] * node.x[ k ];
+			}
+		}
+		if ( node.parent >= 0 ) {
+			const node_t & parent = m_nodes[ node.parent ];
+			for ( int r = 0; r < node.dim; r++ ) {
+				for ( int c = 0; c < parent.dim; c++ ) {
+					x[ r ] -= node.L[ r ][ c ] * parent.x[ c ];
+				}
+			}
+		}
+		memcpy( node.x, x, sizeof( float ) * node.dim );
+	}
+
+	//
+	//	Apply the joint impulses.  The body nodes hold the resulting change in velocity, but
+	//	going through the impulses keeps the bodies' own limits on their velocities.
+	//
+	for ( int j = 0; j < m_joints.size(); j++ ) {
+		joint_t & joint = m_joints[ j ];
+		const float * lambda = m_nodes[ numBodies + j ].x;
+		Body * bodies[ 2 ] = { joint.constraint->m_bodyA, joint.constraint->m_bodyB };
+		for ( int b = 0; b < 2; b++ ) {
+			float impulse[ 6 ] = { 0.0f };
+			for ( int r = 0; r < joint.numRows; r++ ) {
+				for ( int k = 0; k < 6; k++ ) {
+					impulse[ k ] += joint.jacobian[ r ][ b * 6 + k ] * lambda[ r ];
+				}
+			}
+			const Vec3 linear( impulse[ 0 ], impulse[ 1 ], impulse[ 2 ] );
+			const Vec3 angular( impulse[ 3 ], impulse[ 4 ], impulse[ 5 ] );
+			if ( 1 == b ) {
+				joint.impulse += linear;
+			}
+			if ( joint.bodyNodes[ b ] < 0 ) {
+				continue;
+			}
+
+			context.maxImpulseSqr = std::max( context.maxImpulseSqr, std::max( linear.GetLengthSqr(), angular.GetLengthSqr() ) );
+			bodies[ b ]->ApplyImpulseLinear( linear );
+			bodies[ b ]->ApplyImpulseAngular( angular );
+		}
+	}
+
+	// Limits are one sided, so they're solved after the rows that always hold
+	for ( int j = 0; j < m_joints.size(); j++ ) {
+		if ( m_joints[ j ].constraint->HasActiveLimits() ) {
+			m_joints[ j ].constraint->Solve( context );
+		}
+	}
+}
@@ -0,0 +1,86 @@
+//
+//	JointTree.h
+//
+#pragma once
+#include "Body.h"
+#include "Constraints.h"
+#include <vector>
+
+/*
+================================
+JointTree
+Direct solver for joints that connect bodies in a tree, like chains and ragdolls.  The bodies and
+joints form a block sparse system
+
+	[ M  -Jt ] [ dv     ]   [ 0      ]
+	[ -J  0  ] [ lambda ] = [ J v + b ]
+
+that has the same tree shape as the joints, so eliminating it from the leaves up doesn't fill
+anything in and factoring and solving are both linear in the number of joints (Baraff, "Linear-
+Time Dynamics using Lagrange Multipliers").  Each solve makes every joint's rows hold exactly
+for the current velocities, however long the chain.
+
+Static bodies count as one body, the world.  A joint that would close a loop, through the world
+or otherwise, is left out and solved iteratively along with the joints that have no rows.
+================================
+*/
+class JointTree {
+public:
+	// Picks the joints that form trees from the constraints and factors them.  Needs the
+	// constraints' PreSolve to have been run for this step.
+	void Build( Constraint * const * constraints, const int * indices, const int numConstraints, const float dt_sec, const solverContext_t & context );
+
+	// Applies the impulses that make the joints' rows hold for the current velocities
+	void Solve( solverContext_t & context );
+
+	int GetNumJoints() const { return (int)m_joints.size(); }
+	int GetJointIndex( const int idx ) const { return m_joints[ idx ].index; }	// into the constraints passed to Build
+
+	// Linear impulse the solves since Build applied to the joint's bodyB, on top of the joint's own
+	// accumulated impulse
+	Vec3 GetJointImpulse( const int idx ) const { return m_joints[ idx ].impulse; }
+
+	// Constraints that weren't put in a tree and still need their own Solve
+	int GetNumRemaining() const { return (int)m_remaining.size(); }
+	Constraint * GetRemaining( const int idx ) const { return m_remaining[ idx ]; }
+
+	static const int MAX_BLOCK = LCP_MAX_ROWS;
+
+private:
+	struct joint_t {
+		Constraint * constraint;
+		int index;
+		int numRows;
+		float jacobian[ Constraint::MAX_JOINT_ROWS ][ 12 ];
+		float bias[ Constraint::MAX_JOINT_ROWS ];
+		int bodyNodes[ 2 ];		// -1 for static bodies
+		Vec3 impulse;			// linear impulse applied to bodyB since Build
+	};
+
+	struct node_t {
+		int dim;
+		int parent;		// -1 for roots
+		int body;		// index into m_bodies, or -1 for a joint node
+		int joint;		// index into m_joints, or -1 for a body node
+		float invD[ MAX_BLOCK ][ MAX_BLOCK ];	// inverse of the diagonal block once the children are eliminated
+		float L[ MAX_BLOCK ][ MAX_BLOCK ];		// invD times the block coupling the node to its parent
+		float x[ MAX_BLOCK ];
+	};
+
+	int FindRoot( int idx );
+	void GetParentBlock( const int nodeIdx, float block[ MAX_BLOCK ][ MAX_BLOCK ] ) const;
+	void Factor();
+
+	std::vector< joint_t > m_joints;
+	std::vector< Body * > m_bodies;
+	std::vector< node_t > m_nodes;
+	std::vector< int > m_order;			// parents before children
+	std::vector< Constraint * > m_remaining;
+
+	// Scratch for building
+	std::vector< int > m_unionParent;
+	std::vector< int > m_adjacency;
+	std::vector< int > m_adjacencyStart;
+	std::vector< int > m_adjacencyFill;	// where each node's next neighbor goes
+	std::vector< bool > m_isVisited;
+};
@@ -2,6 +2,7 @@
 //  Manifold.cpp
 //
 #include "Manifold.h"
+#include <algorithm>
 
 
 /*
@@ -40,6 +41,7 @@ void ManifoldCollector::AddContact( const contact_t & contact ) {
 
 		manifold.AddContact( contact );
 		m_manifolds.push_back( manifold );
+		m_order.clear();
 	}
 }
 
@@ -56,18 +58,43 @@ void ManifoldCollector::RemoveExpired() {
 
 		if ( 0 == manifold.m_numContacts ) {
 			m_manifolds.erase( m_manifolds.begin() + i );
+			m_order.clear();
 		}
 	}
 }
 
+/*
+================================
+ManifoldCollector::SortByBodies
+Orders the manifolds by the bodies they connect, bodies live in a single array
+so comparing their addresses is the same as comparing their indices
+================================
+*/
+void ManifoldCollector::SortByBodies() {
+	m_order.resize( m_manifolds.size() );
+	for ( int i = 0; i < m_order.size(); i++ ) {
+		m_order[ i ] = i;
+	}
+
+	const std::vector< Manifold > & manifolds = m_manifolds;
+	std::sort( m_order.begin(), m_order.end(), [ &manifolds ]( const int a, const int b ) {
+		const Manifold & ma = manifolds[ a ];
+		const Manifold & mb = manifolds[ b ];
+		if ( ma.m_bodyA != mb.m_bodyA ) {
+			return ma.m_bodyA < mb.m_bodyA;
+		}
+		return ma.m_bodyB < mb.m_bodyB;
+	} );
+}
+
 /*
 ================================
 ManifoldCollector::PreSolve
 ================================
 */
-void ManifoldCollector::PreSolve( const float dt_sec ) {
+void ManifoldCollector::PreSolve( const float dt_sec, solverContext_t & context ) {
 	for ( int i = 0; i < m_manifolds.size(); i++ ) {
-		m_manifolds[ i ].PreSolve( dt_sec );
+		m_manifolds[ GetSolveIndex( i ) ].PreSolve( dt_sec, context );
 	}
 }
 
@@ -76,9 +103,9 @@ void ManifoldCollector::PreSolve( const float dt_sec ) {
 ManifoldCollector::Solve
 ================================
 */
-void ManifoldCollector::Solve() {
+void ManifoldCollector::Solve( solverContext_t & context ) {
 	for ( int i = 0; i < m_manifolds.size(); i++ ) {
-		m_manifolds[ i ].Solve();
+		m_manifolds[ GetSolveIndex( i ) ].Solve( context );
 	}
 }
 
@@ -89,7 +116,89 @@ Manifold::PostSolve
 */
 void ManifoldCollector::PostSolve() {
 	for ( int i = 0; i < m_manifolds.size(); i++ ) {
-		m_manifolds[ i ].PostSolve();
+		m_manifolds[ GetSolveIndex( i ) ].PostSolve();
+	}
+}
+
+/*
+================================
+ManifoldCollector::SaveState
+Writes every manifold to states, which must hold at least m_manifolds.size() entries
+================================
+*/
+void ManifoldCollector::SaveState( manifoldState_t * states, const Body * firstBody ) const {
+	for ( int i = 0; i < m_manifolds.size(); i++ ) {
+		const Manifold & manifold = m_manifolds[ i ];
+		manifoldState_t & state = states[ i ];
+
+		state.bodyA = (int)( manifold.m_bodyA - firstBody );
+		state.bodyB = (int)( manifold.m_bodyB - firstBody );
+		state.numContacts = manifold.m_numContacts;
+
+		for ( int j = 0; j < manifold.m_numContacts; j++ ) {
+			const contact_t & contact = manifold.m_contacts[ j ];
+			manifoldContactState_t & contactState = state.contacts[ j ];
+
+			contactState.ptOnA_WorldSpace = contact.ptOnA_WorldSpace;
+			contactState.ptOnB_WorldSpace = contact.ptOnB_WorldSpace;
+			contactState.ptOnA_LocalSpace = contact.ptOnA_LocalSpace;
+			contactState.ptOnB_LocalSpace = contact.ptOnB_LocalSpace;
+			contactState.normal = contact.normal;
+			contactState.separationDistance = contact.separationDistance;
+			contactState.timeOfImpact = contact.timeOfImpact;
+
+			contactState.constraintNormal = manifold.m_constraints[ j ].m_normal;
+			manifold.m_constraints[ j ].SaveState( contactState.cachedLambda );
+		}
+		manifold.m_friction.SaveState( state.frictionLambda );
+	}
+}
+
+/*
+================================
+ManifoldCollector::RestoreState
+================================
+*/
+void ManifoldCollector::RestoreState( const manifoldState_t * states, const int num, Body * firstBody ) {
+	m_manifolds.resize( num );
+	m_order.clear();
+
+	for ( int i = 0; i < num; i++ ) {
+		Manifold & manifold = m_manifolds[ i ];
+		const manifoldState_t & state = states[ i ];
+
+		manifold.m_bodyA = firstBody + state.bodyA;
+		manifold.m_bodyB = firstBody + state.bodyB;
+		manifold.m_numContacts = state.numContacts;
+		manifold.m_friction.RestoreState( state.frictionLambda );
+
+		for ( int j = 0; j < Manifold::MAX_CONTACTS; j++ ) {
+			ConstraintPenetration & constraint = manifold.m_constraints[ j ];
+			if ( j >= state.numContacts ) {
+				constraint.m_cachedLambda.Zero();
+				continue;
+			}
+
+			const manifoldContactState_t & contactState = state.contacts[ j ];
+			contact_t & contact = manifold.m_contacts[ j ];
+
+			contact.ptOnA_WorldSpace = contactState.ptOnA_WorldSpace;
+			contact.ptOnB_WorldSpace = contactState.ptOnB_WorldSpace;
+			contact.ptOnA_LocalSpace = contactState.ptOnA_LocalSpace;
+			contact.ptOnB_LocalSpace = contactState.ptOnB_LocalSpace;
+			contact.normal = contactState.normal;
+			contact.separationDistance = contactState.separationDistance;
+			contact.timeOfImpact = contactState.timeOfImpact;
+			contact.bodyA = manifold.m_bodyA;
+			contact.bodyB = manifold.m_bodyB;
+
+			constraint.m_bodyA = manifold.m_bodyA;
+			constraint.m_bodyB = manifold.m_bodyB;
+			constraint.m_anchorA = contact.ptOnA_LocalSpace;
+			constraint.m_anchorB = contact.ptOnB_LocalSpace;
+			constraint.m_normal = contactState.constraintNormal;
+			constraint.RestoreState( contactState.cachedLambda );
+		}
 	}
 }
 
@@ -146,6 +255,19 @@ void Manifold::RemoveExpiredContacts() {
 	}
 }
 
+/*
+================================
+Manifold::GetSeparation
+================================
+*/
+float Manifold::GetSeparation( const int idx ) const {
+	const contact_t & contact = m_contacts[ idx ];
+	const Vec3 a = contact.bodyA->BodySpaceToWorldSpace( contact.ptOnA_LocalSpace );
+	const Vec3 b = contact.bodyB->BodySpaceToWorldSpace( contact.ptOnB_LocalSpace );
+	const Vec3 normal = contact.bodyA->m_orientation.RotatePoint( m_constraints[ idx ].m_normal );
+	return ( b - a ).Dot( normal );
+}
+
 /*
 ================================
 Manifold::AddContact
@@ -240,10 +362,51 @@ void Manifold::AddContact( const contact_t & contact_old ) {
 Manifold::PreSolve
 ================================
 */
-void Manifold::PreSolve( const float dt_sec ) {
+void Manifold::PreSolve( const float dt_sec, solverContext_t & context ) {
+	if ( !context.useManifoldFriction ) {
+		for ( int i = 0; i < m_numContacts; i++ ) {
+			m_constraints[ i ].PreSolve( dt_sec, context );
+		}
+		return;
+	}
+
+	// The contacts' own friction rows go unused, so they mustn't warm start either
 	for ( int i = 0; i < m_numContacts; i++ ) {
-		m_constraints[ i ].PreSolve( dt_sec );
+		m_constraints[ i ].m_cachedLambda[ 1 ] = 0.0f;
+		m_constraints[ i ].m_cachedLambda[ 2 ] = 0.0f;
+		m_constraints[ i ].PreSolve( dt_sec, context );
 	}
+
+	//
+	//	Anchor the friction at the centroid of the contacts, with the average normal
+	//
+	Vec3 centroid( 0.0f );
+	Vec3 normal( 0.0f );
+	for ( int i = 0; i < m_numContacts; i++ ) {
+		const ConstraintPenetration & constraint = m_constraints[ i ];
+		const Vec3 a = m_bodyA->BodySpaceToWorldSpace( constraint.m_anchorA );
+		const Vec3 b = m_bodyB->BodySpaceToWorldSpace( constraint.m_anchorB );
+		centroid += ( a + b ) * 0.5f;
+		normal += constraint.m_normal;
+	}
+	centroid *= 1.0f / (float)m_numContacts;
+	normal.Normalize();
+
+	float radius = 0.0f;
+	for ( int i = 0; i < m_numContacts; i++ ) {
+		const ConstraintPenetration & constraint = m_constraints[ i ];
+		const Vec3 a = m_bodyA->BodySpaceToWorldSpace( constraint.m_anchorA );
+		const Vec3 b = m_bodyB->BodySpaceToWorldSpace( constraint.m_anchorB );
+		radius += ( ( a + b ) * 0.5f - centroid ).GetMagnitude();
+	}
+
+	m_friction.m_bodyA = m_bodyA;
+	m_friction.m_bodyB = m_bodyB;
+	m_friction.m_anchorA = m_bodyA->WorldSpaceToBodySpace( centroid );
+	m_friction.m_anchorB = m_bodyB->WorldSpaceToBodySpace( centroid );
+	m_friction.m_normal = normal;
+	m_friction.m_radius = radius / (float)m_numContacts;
+	m_friction.PreSolve( dt_sec, context );
 }
 
 /*
@@ -251,9 +414,45 @@ void Manifold::PreSolve( const float dt_sec ) {
 Manifold::Solve
 ================================
 */
-void Manifold::Solve() {
+void Manifold::Solve( solverContext_t & context ) {
+	const bool useBlockSolver = ( context.useBlockSolver && m_numContacts > 1 );
+	if ( !context.useManifoldFriction && !useBlockSolver ) {
+		for ( int i = 0; i < m_numContacts; i++ ) {
+			m_constraints[ i ].Solve( context );
+		}
+		return;
+	}
+
+	// Friction first, so the normals have the final say on penetration
+	if ( context.useManifoldFriction ) {
+		m_friction.m_normalImpulse = 0.0f;
+		for ( int i = 0; i < m_numContacts; i++ ) {
+			m_friction.m_normalImpulse += m_constraints[ i ].m_cachedLambda[ 0 ];
+		}
+		m_friction.Solve( context );
+	} else {
+		for ( int i = 0; i < m_numContacts; i++ ) {
+			m_constraints[ i ].SolveFriction( context );
+		}
+	}
+
+	if ( useBlockSolver ) {
+		ConstraintPenetration::SolveNormalBlock( m_constraints, m_numContacts, context );
+	} else {
+		for ( int i = 0; i < m_numContacts; i++ ) {
+			m_constraints[ i ].SolveNormal( context );
+		}
+	}
+}
+
+/*
+================================
+Manifold::SolvePositions
+================================
+*/
+void Manifold::SolvePositions() {
 	for ( int i = 0; i < m_numContacts; i++ ) {
-		m_constraints[ i ].Solve();
+		m_constraints[ i ].SolvePositions();
 	}
 }
 
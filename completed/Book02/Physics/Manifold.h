@@ -18,15 +18,22 @@ public:
 	void AddContact( const contact_t & contact );
 	void RemoveExpiredContacts();
 
-	void PreSolve( const float dt_sec );
-	void Solve();
+	void PreSolve( const float dt_sec, solverContext_t & context );
+	void Solve( solverContext_t & context );
+	void SolvePositions();
 	void PostSolve();
 
 	contact_t GetContact( const int idx ) const { return m_contacts[ idx ]; }
 	int GetNumContacts() const { return m_numContacts; }
+	Body * GetBodyA() const { return m_bodyA; }
+	Body * GetBodyB() const { return m_bodyB; }
+
+	// Separation of a contact's anchors along its normal as the bodies are now, negative when penetrating
+	float GetSeparation( const int idx ) const;
 
-private:
 	static const int MAX_CONTACTS = 4;
+
+private:
 	contact_t m_contacts[ MAX_CONTACTS ];
 
 	int m_numContacts;
@@ -35,10 +42,38 @@ private:
 	Body * m_bodyB;
 
 	ConstraintPenetration m_constraints[ MAX_CONTACTS ];
+	ConstraintFriction m_friction;
 
 	friend class ManifoldCollector;
 };
 
+/*
+================================
+manifoldState_t
+Flat copy of a manifold used by scene snapshots, bodies are stored as indices
+================================
+*/
+struct manifoldContactState_t {
+	Vec3 ptOnA_WorldSpace;
+	Vec3 ptOnB_WorldSpace;
+	Vec3 ptOnA_LocalSpace;
+	Vec3 ptOnB_LocalSpace;
+	Vec3 normal;
+	float separationDistance;
+	float timeOfImpact;
+
+	Vec3 constraintNormal;	// in Body A's local space
+	float cachedLambda[ 3 ];
+};
+
+struct manifoldState_t {
+	int bodyA;
+	int bodyB;
+	int numContacts;
+	manifoldContactState_t contacts[ Manifold::MAX_CONTACTS ];
+	float frictionLambda[ 3 ];
+};
+
 /*
 ================================
 ManifoldCollector
@@ -50,13 +85,24 @@ public:
 
 	void AddContact( const contact_t & contact );
 
-	void PreSolve( const float dt_sec );
-	void Solve();
+	void PreSolve( const float dt_sec, solverContext_t & context );
+	void Solve( solverContext_t & context );
 	void PostSolve();
 
 	void RemoveExpired();
-	void Clear() { m_manifolds.clear(); }	// For resetting the demo
+	void Clear() { m_manifolds.clear(); m_order.clear(); }	// For resetting the demo
+
+	void SortByBodies();
+
+	void SaveState( manifoldState_t * states, const Body * firstBody ) const;
+	void RestoreState( const manifoldState_t * states, const int num, Body * firstBody );
+
+	int GetSolveIndex( const int i ) const { return m_order.empty() ? i : m_order[ i ]; }
 
 public:
 	std::vector< Manifold > m_manifolds;
+
+	// Order the manifolds are solved in, empty means storage order.  Filled by SortByBodies
+	// so that the solve order doesn't depend on when each manifold was created.
+	std::vector< int > m_order;
 };
\ No newline at end of file
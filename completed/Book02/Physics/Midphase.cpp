@@ -0,0 +1,174 @@
+//
+//  Midphase.cpp
+//
+#include "Midphase.h"
+#include <algorithm>
+
+// Extra room around the boxes, well beyond the bias the narrowphase grows the shapes by
+static const float MIDPHASE_MARGIN = 0.01f;
+
+/*
+====================================================
+Midphase::CanSeparate
+====================================================
+*/
+bool Midphase::CanSeparate( const Body & body ) {
+	const Shape::shapeType_t type = body.m_shape->GetType();
+	return ( Shape::SHAPE_TRIANGLE_MESH != type && Shape::SHAPE_HEIGHTFIELD != type );
+}
+
+/*
+====================================================
+Midphase::BuildBox
+====================================================
+*/
+void Midphase::BuildBox( const Body & body, const float dt_sec, orientedBox_t & box ) {
+	const Shape * shape = body.m_shape;
+	const Bounds bounds = shape->GetBounds();
+	const Vec3 localCenter = ( bounds.mins + bounds.maxs ) * 0.5f;
+
+	box.center = body.m_position + body.m_orientation.RotatePoint( localCenter );
+	box.axes[ 0 ] = body.m_orientation.RotatePoint( Vec3( 1, 0, 0 ) );
+	box.axes[ 1 ] = body.m_orientation.RotatePoint( Vec3( 0, 1, 0 ) );
+	box.axes[ 2 ] = body.m_orientation.RotatePoint( Vec3( 0, 0, 1 ) );
+	box.halfSize = ( bounds.maxs - bounds.mins ) * 0.5f;
+
+	box.sphereRadius = box.halfSize.GetMagnitude();
+	if ( Shape::SHAPE_SPHERE == shape->GetType() ) {
+		box.sphereRadius = ( (const ShapeSphere *)shape )->m_radius;
+	} else if ( Shape::SHAPE_CAPSULE == shape->GetType() ) {
+		const ShapeCapsule * capsule = (const ShapeCapsule *)shape;
+		box.sphereRadius = capsule->m_radius + capsule->m_halfHeight;
+	}
+
+	// A point r from the center of mass turns through an arc of at most r * angle, and never
+	// further than across the circle it turns on
+	const float radius = ( localCenter - shape->GetCenterOfMass() ).GetMagnitude() + box.halfSize.GetMagnitude();
+	const float angle = body.m_angularVelocity.GetMagnitude() * dt_sec;
+	box.spin = radius * std::min( angle, 2.0f );
+}
+
+/*
+====================================================
+Midphase::GetAxis
+The axes are A's faces, B's faces, the cross products of their edges and the line between their
+centers.  Returns false for edges too close to parallel to give an axis.
+====================================================
+*/
+bool Midphase::GetAxis( const orientedBox_t & boxA, const orientedBox_t & boxB, const int idx, Vec3 & axis ) {
+	if ( idx < 3 ) {
+		axis = boxA.axes[ idx ];
+		return true;
+	}
+	if ( idx < 6 ) {
+		axis = boxB.axes[ idx - 3 ];
+		return true;
+	}
+	if ( idx < 15 ) {
+		axis = boxA.axes[ ( idx - 6 ) / 3 ].Cross( boxB.axes[ ( idx - 6 ) % 3 ] );
+	} else {
+		axis = boxB.center - boxA.center;
+	}
+
+	const float lengthSqr = axis.GetLengthSqr();
+	if ( lengthSqr < 1e-6f ) {
+		return false;
+	}
+	axis *= 1.0f / sqrtf( lengthSqr );
+	return true;
+}
+
+/*
+====================================================
+Midphase::IsSeparatedOnAxis
+A's box stays put and B's slides by the sweep, so B covers the interval it starts at stretched by
+the sweep's length along the axis
+====================================================
+*/
+bool Midphase::IsSeparatedOnAxis( const orientedBox_t & boxA, const orientedBox_t & boxB, const Vec3 & sweep, const Vec3 & axis ) {
+	float radiusA = 0.0f;
+	float radiusB = 0.0f;
+	for ( int i = 0; i < 3; i++ ) {
+		radiusA += fabsf( axis.Dot( boxA.axes[ i ] ) ) * boxA.halfSize[ i ];
+		radiusB += fabsf( axis.Dot( boxB.axes[ i ] ) ) * boxB.halfSize[ i ];
+	}
+	radiusA = std::min( radiusA, boxA.sphereRadius ) + boxA.spin + MIDPHASE_MARGIN;
+	radiusB = std::min( radiusB, boxB.sphereRadius ) + boxB.spin;
+
+	const float distance = axis.Dot( boxB.center - boxA.center );
+	const float distanceSweep = axis.Dot( sweep );
+	const float lowestB = distance + std::min( distanceSweep, 0.0f ) - radiusB;
+	const float highestB = distance + std::max( distanceSweep, 0.0f ) + radiusB;
+	return ( lowestB > radiusA || highestB < -radiusA );
+}
+
+/*
+====================================================
+Midphase::IsSeparated
+====================================================
+*/
+bool Midphase::IsSeparated( const collisionPair_t & pair, const Body & bodyA, const Body & bodyB, const float dt_sec ) {
+	if ( Shape::SHAPE_SPHERE == bodyA.m_shape->GetType() && Shape::SHAPE_SPHERE == bodyB.m_shape->GetType() ) {
+		return false;
+	}
+	if ( !CanSeparate( bodyA ) || !CanSeparate( bodyB ) ) {
+		return false;
+	}
+
+	orientedBox_t boxA;
+	orientedBox_t boxB;
+	BuildBox( bodyA, dt_sec, boxA );
+	BuildBox( bodyB, dt_sec, boxB );
+	const Vec3 sweep = ( bodyB.m_linearVelocity - bodyA.m_linearVelocity ) * dt_sec;
+
+	const unsigned long long key = ( (unsigned long long)(unsigned int)pair.a << 32 ) | (unsigned int)pair.b;
+	cachedAxis_t newPair;
+	newPair.axis = -1;
+	newPair.step = m_step;
+	cachedAxis_t & cached = m_cache.insert( std::make_pair( key, newPair ) ).first->second;
+	cached.step = m_step;
+
+	// The axis that separated the pair last time usually still does
+	Vec3 axis;
+	if ( cached.axis >= 0 && GetAxis( boxA, boxB, cached.axis, axis ) && IsSeparatedOnAxis( boxA, boxB, sweep, axis ) ) {
+		return true;
+	}
+
+	for ( int i = 0; i < NUM_AXES; i++ ) {
+		if ( i == cached.axis || !GetAxis( boxA, boxB, i, axis ) ) {
+			continue;
+		}
+		if ( IsSeparatedOnAxis( boxA, boxB, sweep, axis ) ) {
+			cached.axis = i;
+			return true;
+		}
+	}
+	cached.axis = -1;
+	return false;
+}
+
+/*
+====================================================
+Midphase::EndUpdate
+====================================================
+*/
+void Midphase::EndUpdate() {
+	for ( auto it = m_cache.begin(); it != m_cache.end(); ) {
+		if ( it->second.step != m_step ) {
+			it = m_cache.erase( it );
+		} else {
+			++it;
+		}
+	}
+	m_step++;
+}
+
+/*
+====================================================
+Midphase::Clear
+====================================================
+*/
+void Midphase::Clear() {
+	m_cache.clear();
+	m_step = 0;
+}
@@ -0,0 +1,60 @@
+//
+//	Midphase.h
+//
+#pragma once
+#include "Body.h"
+#include "Broadphase.h"
+#include <unordered_map>
+
+/*
+====================================================
+Midphase
+A cheap test of the pairs the broadphase finds, before they reach GJK and conservative advancement.
+Each body is wrapped in an oriented box (its shape's local bounds), grown by how far its spin can
+carry it during the step, and B's box is swept by its motion relative to A.  If any of the fifteen
+box separating axes, or the line between the boxes' centers, keeps the swept boxes apart, the pair
+can't touch this step.
+
+Pairs that are apart usually stay apart along the same axis, so the axis that worked is kept for
+the next update and tried first.  The cache only changes the order the axes are tried in, never the
+answer, so it doesn't affect determinism.
+
+Sphere pairs already have an exact test that's cheaper than this, and meshes and heightfields are
+too large for a box to say much, so their pairs skip it.
+====================================================
+*/
+class Midphase {
+public:
+	Midphase() : m_step( 0 ) {}
+
+	// Whether the bodies can't touch during the step, so the pair needn't go to the narrowphase
+	bool IsSeparated( const collisionPair_t & pair, const Body & bodyA, const Body & bodyB, const float dt_sec );
+
+	// Forgets the pairs that weren't tested this update
+	void EndUpdate();
+	void Clear();
+
+	static const int NUM_AXES = 16;	// three faces of each box, nine edge pairs and the centers
+
+private:
+	struct orientedBox_t {
+		Vec3 center;
+		Vec3 axes[ 3 ];
+		Vec3 halfSize;
+		float sphereRadius;	// around the center, when it's tighter than the box's corners
+		float spin;			// furthest any point can be carried by the body's rotation during the step
+	};
+
+	struct cachedAxis_t {
+		int axis;
+		int step;	// the last update that tested the pair
+	};
+
+	static bool CanSeparate( const Body & body );
+	static void BuildBox( const Body & body, const float dt_sec, orientedBox_t & box );
+	static bool GetAxis( const orientedBox_t & boxA, const orientedBox_t & boxB, const int idx, Vec3 & axis );
+	static bool IsSeparatedOnAxis( const orientedBox_t & boxA, const orientedBox_t & boxB, const Vec3 & sweep, const Vec3 & axis );
+
+	std::unordered_map< unsigned long long, cachedAxis_t > m_cache;	// keyed by the pair's bodies
+	int m_step;
+};
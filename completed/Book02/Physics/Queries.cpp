@@ -0,0 +1,477 @@
+//
+//  Queries.cpp
+//
+#include "Queries.h"
+#include "GJK.h"
+#include "Intersections.h"
+#include <algorithm>
+
+/*
+====================================================
+RaySphereFraction
+====================================================
+*/
+static bool RaySphereFraction( const Vec3 & start, const Vec3 & dir, const Vec3 & center, const float radius, const float maxFraction, queryHit_t & hit ) {
+	float t1;
+	float t2;
+	if ( !RaySphere( start, dir, center, radius, t1, t2 ) || t2 < 0.0f || t1 > maxFraction ) {
+		return false;
+	}
+
+	if ( t1 <= 0.0f ) {
+		hit.fraction = 0.0f;
+		hit.normal.Zero();
+		hit.point = start;
+		return true;
+	}
+
+	hit.fraction = t1;
+	hit.normal = start + dir * t1 - center;
+	hit.normal.Normalize();
+	hit.point = center + hit.normal * radius;
+	return true;
+}
+
+/*
+====================================================
+RayBox
+Slab test in the box's space
+====================================================
+*/
+static bool RayBox( const Body * body, const ShapeBox * box, const Vec3 & start, const Vec3 & dir, const float maxFraction, queryHit_t & hit ) {
+	const Quat invOrient = body->m_orientation.Inverse();
+	const Vec3 localStart = invOrient.RotatePoint( start - body->m_position );
+	const Vec3 localDir = invOrient.RotatePoint( dir );
+
+	float tMin = 0.0f;
+	float tMax = maxFraction;
+	int enterAxis = -1;
+	float enterSign = 0.0f;
+	for ( int i = 0; i < 3; i++ ) {
+		if ( fabsf( localDir[ i ] ) < 1e-20f ) {
+			if ( localStart[ i ] < box->m_bounds.mins[ i ] || localStart[ i ] > box->m_bounds.maxs[ i ] ) {
+				return false;
+			}
+			continue;
+		}
+
+		const float invDir = 1.0f / localDir[ i ];
+		float t0 = ( box->m_bounds.mins[ i ] - localStart[ i ] ) * invDir;
+		float t1 = ( box->m_bounds.maxs[ i ] - localStart[ i ] ) * invDir;
+		float sign = -1.0f;
+		if ( t0 > t1 ) {
+			std::swap( t0, t1 );
+			sign = 1.0f;
+		}
+		if ( t0 > tMin ) {
+			tMin = t0;
+			enterAxis = i;
+			enterSign = sign;
+		}
+		tMax = std::min( tMax, t1 );
+		if ( tMin > tMax ) {
+			return false;
+		}
+	}
+
+	hit.fraction = tMin;
+	hit.point = start + dir * tMin;
+	hit.normal.Zero();
+	if ( enterAxis >= 0 ) {
+		Vec3 localNormal( 0.0f );
+		localNormal[ enterAxis ] = enterSign;
+		hit.normal = body->m_orientation.RotatePoint( localNormal );
+	}
+	return true;
+}
+
+/*
+====================================================
+RayCastCompound
+Casts in the compound's space to find the children along the ray, then against each of them
+====================================================
+*/
+static bool RayCastCompound( const Body * body, const Vec3 & start, const Vec3 & end, const float maxFraction, queryHit_t & hit ) {
+	const ShapeCompound * compound = (const ShapeCompound *)body->m_shape;
+	const Quat invOrient = body->m_orientation.Inverse();
+	const Vec3 localStart = invOrient.RotatePoint( start - body->m_position );
+	const Vec3 localEnd = invOrient.RotatePoint( end - body->m_position );
+
+	bool didHit = false;
+	auto callback = [ & ]( const int childIdx, float & childMaxFraction ) {
+		Body child;
+		GetCompoundChild( body, childIdx, child );
+
+		queryHit_t childHit;
+		if ( RayCast( &child, start, end, childMaxFraction, childHit ) ) {
+			hit = childHit;
+			childMaxFraction = childHit.fraction;
+			didHit = true;
+		}
+		return true;
+	};
+
+	Bounds bounds;
+	bounds.Expand( localStart );
+	compound->m_tree.CastBounds( bounds, localEnd - localStart, maxFraction, callback );
+	return didHit;
+}
+
+/*
+====================================================
+RayTriangle
+Both sides of the triangle count, the normal faces the start of the ray
+====================================================
+*/
+static bool RayTriangle( const Vec3 & start, const Vec3 & dir, const Vec3 & a, const Vec3 & b, const Vec3 & c, const float maxFraction, queryHit_t & hit ) {
+	const Vec3 ab = b - a;
+	const Vec3 ac = c - a;
+	const Vec3 p = dir.Cross( ac );
+	const float det = ab.Dot( p );
+	if ( fabsf( det ) < 1e-12f ) {
+		return false;
+	}
+	const float invDet = 1.0f / det;
+
+	const Vec3 ap = start - a;
+	const float u = ap.Dot( p ) * invDet;
+	if ( u < 0.0f || u > 1.0f ) {
+		return false;
+	}
+	const Vec3 q = ap.Cross( ab );
+	const float v = dir.Dot( q ) * invDet;
+	if ( v < 0.0f || u + v > 1.0f ) {
+		return false;
+	}
+	const float t = ac.Dot( q ) * invDet;
+	if ( t < 0.0f || t > maxFraction ) {
+		return false;
+	}
+
+	hit.fraction = t;
+	hit.point = start + dir * t;
+	hit.normal = ab.Cross( ac );
+	if ( hit.normal.Dot( dir ) > 0.0f ) {
+		hit.normal *= -1.0f;
+	}
+	hit.normal.Normalize();
+	return true;
+}
+
+/*
+====================================================
+RayCastTriangles
+Casts in the mesh or heightfield's space, and keeps the nearest triangle hit
+====================================================
+*/
+template< typename shape_t >
+static bool RayCastTriangles( const Body * body, const shape_t * shape, const Vec3 & start, const Vec3 & end, const float maxFraction, queryHit_t & hit ) {
+	const Quat invOrient = body->m_orientation.Inverse();
+	const Vec3 localStart = invOrient.RotatePoint( start - body->m_position );
+	const Vec3 localDir = invOrient.RotatePoint( end - start );
+
+	bool didHit = false;
+	auto callback = [ & ]( const int triangleIdx, float & triangleMaxFraction ) {
+		Vec3 a;
+		Vec3 b;
+		Vec3 c;
+		shape->GetTriangle( triangleIdx, a, b, c );
+
+		queryHit_t triangleHit;
+		triangleHit.body = -1;
+		if ( RayTriangle( localStart, localDir, a, b, c, triangleMaxFraction, triangleHit ) ) {
+			hit = triangleHit;
+			triangleMaxFraction = triangleHit.fraction;
+			didHit = true;
+		}
+		return true;
+	};
+	shape->CastTriangles( localStart, localDir, maxFraction, callback );
+
+	if ( didHit ) {
+		hit.point = body->m_position + body->m_orientation.RotatePoint( hit.point );
+		hit.normal = body->m_orientation.RotatePoint( hit.normal );
+	}
+	return didHit;
+}
+
+/*
+====================================================
+RayCast
+====================================================
+*/
+bool RayCast( const Body * body, const Vec3 & start, const Vec3 & end, const float maxFraction, queryHit_t & hit ) {
+	const Vec3 dir = end - start;
+	const Shape * shape = body->m_shape;
+	switch ( shape->GetType() ) {
+		case Shape::SHAPE_COMPOUND: {
+			return RayCastCompound( body, start, end, maxFraction, hit );
+		}
+		case Shape::SHAPE_TRIANGLE_MESH: {
+			return RayCastTriangles( body, (const ShapeTriangleMesh *)shape, start, end, maxFraction, hit );
+		}
+		case Shape::SHAPE_HEIGHTFIELD: {
+			return RayCastTriangles( body, (const ShapeHeightfield *)shape, start, end, maxFraction, hit );
+		}
+		case Shape::SHAPE_SPHERE: {
+			const ShapeSphere * sphere = (const ShapeSphere *)shape;
+			return RaySphereFraction( start, dir, body->m_position, sphere->m_radius, maxFraction, hit );
+		}
+		case Shape::SHAPE_BOX: {
+			return RayBox( body, (const ShapeBox *)shape, start, dir, maxFraction, hit );
+		}
+		default: {
+			return GJK_CastShape( NULL, start, Quat( 0, 0, 0, 1 ), dir, shape, body->m_position, body->m_orientation, maxFraction, hit.fraction, hit.normal, hit.point );
+		}
+	}
+}
+
+/*
+====================================================
+ShapeCastCompound
+A compound cast is each of its children cast.  Against a compound body, the cast's bounds are swept
+through the compound's tree to find the children to cast against.
+====================================================
+*/
+static bool ShapeCastCompound( const Body * body, const shapeCast_t & cast, const float maxFraction, queryHit_t & hit ) {
+	bool didHit = false;
+	float nearest = maxFraction;
+
+	if ( Shape::SHAPE_COMPOUND == cast.shape->GetType() ) {
+		const ShapeCompound * compound = (const ShapeCompound *)cast.shape;
+		for ( int i = 0; i < (int)compound->m_children.size(); i++ ) {
+			shapeCast_t childCast;
+			childCast.shape = compound->m_children[ i ].shape;
+			compound->GetChildTransform( i, cast.start, cast.orientation, childCast.start, childCast.orientation );
+			childCast.end = childCast.start + ( cast.end - cast.start );
+
+			queryHit_t childHit;
+			if ( ShapeCast( body, childCast, nearest, childHit ) ) {
+				hit = childHit;
+				nearest = childHit.fraction;
+				didHit = true;
+			}
+		}
+		return didHit;
+	}
+
+	const ShapeCompound * compound = (const ShapeCompound *)body->m_shape;
+	const Quat invOrient = body->m_orientation.Inverse();
+	auto callback = [ & ]( const int childIdx, float & childMaxFraction ) {
+		Body child;
+		GetCompoundChild( body, childIdx, child );
+
+		queryHit_t childHit;
+		if ( ShapeCast( &child, cast, childMaxFraction, childHit ) ) {
+			hit = childHit;
+			childMaxFraction = childHit.fraction;
+			didHit = true;
+		}
+		return true;
+	};
+
+	const Bounds bounds = ShapeCompound::ToLocalBounds( cast.shape->GetBounds( cast.start, cast.orientation ), body->m_position, body->m_orientation );
+	compound->m_tree.CastBounds( bounds, invOrient.RotatePoint( cast.end - cast.start ), maxFraction, callback );
+	return didHit;
+}
+
+/*
+====================================================
+ShapeCastTriangles
+Casts against each triangle under the cast's swept bounds, nearest hit wins
+====================================================
+*/
+template< typename shape_t >
+static bool ShapeCastTriangles( const Body * body, const shape_t * shape, const shapeCast_t & cast, const float maxFraction, queryHit_t & hit ) {
+	const Vec3 dir = cast.end - cast.start;
+	Bounds bounds = cast.shape->GetBounds( cast.start, cast.orientation );
+	bounds.Expand( bounds.mins + dir * maxFraction );
+	bounds.Expand( bounds.maxs + dir * maxFraction );
+
+	bool didHit = false;
+	float nearest = maxFraction;
+	auto callback = [ & ]( const int triangleIdx ) {
+		Vec3 a;
+		Vec3 b;
+		Vec3 c;
+		shape->GetTriangle( triangleIdx, a, b, c );
+		const ShapeTriangle triangle( a, b, c );
+
+		queryHit_t triangleHit;
+		triangleHit.body = -1;
+		if ( GJK_CastShape( cast.shape, cast.start, cast.orientation, dir, &triangle, body->m_position, body->m_orientation, nearest, triangleHit.fraction, triangleHit.normal, triangleHit.point ) ) {
+			hit = triangleHit;
+			nearest = triangleHit.fraction;
+			didHit = true;
+		}
+		return true;
+	};
+	shape->QueryTriangles( ShapeCompound::ToLocalBounds( bounds, body->m_position, body->m_orientation ), callback );
+	return didHit;
+}
+
+/*
+====================================================
+ShapeCast
+====================================================
+*/
+bool ShapeCast( const Body * body, const shapeCast_t & cast, const float maxFraction, queryHit_t & hit ) {
+	const Vec3 dir = cast.end - cast.start;
+
+	if ( Shape::SHAPE_COMPOUND == cast.shape->GetType() || Shape::SHAPE_COMPOUND == body->m_shape->GetType() ) {
+		return ShapeCastCompound( body, cast, maxFraction, hit );
+	}
+	if ( Shape::SHAPE_TRIANGLE_MESH == body->m_shape->GetType() ) {
+		return ShapeCastTriangles( body, (const ShapeTriangleMesh *)body->m_shape, cast, maxFraction, hit );
+	}
+	if ( Shape::SHAPE_HEIGHTFIELD == body->m_shape->GetType() ) {
+		return ShapeCastTriangles( body, (const ShapeHeightfield *)body->m_shape, cast, maxFraction, hit );
+	}
+
+	// Two spheres touch when the centers are the sum of the radii apart
+	if ( Shape::SHAPE_SPHERE == cast.shape->GetType() && Shape::SHAPE_SPHERE == body->m_shape->GetType() ) {
+		const float radiusA = ( (const ShapeSphere *)cast.shape )->m_radius;
+		const float radiusB = ( (const ShapeSphere *)body->m_shape )->m_radius;
+		if ( !RaySphereFraction( cast.start, dir, body->m_position, radiusA + radiusB, maxFraction, hit ) ) {
+			return false;
+		}
+		if ( hit.fraction > 0.0f ) {
+			hit.point = body->m_position + hit.normal * radiusB;
+		}
+		return true;
+	}
+
+	return GJK_CastShape( cast.shape, cast.start, cast.orientation, dir, body->m_shape, body->m_position, body->m_orientation, maxFraction, hit.fraction, hit.normal, hit.point );
+}
+
+/*
+====================================================
+SphereBox
+====================================================
+*/
+static bool SphereBox( const Vec3 & center, const float radius, const ShapeBox * box, const Vec3 & boxPos, const Quat & boxOrient ) {
+	const Vec3 localCenter = boxOrient.Inverse().RotatePoint( center - boxPos );
+
+	Vec3 closest;
+	for ( int i = 0; i < 3; i++ ) {
+		closest[ i ] = std::max( box->m_bounds.mins[ i ], std::min( box->m_bounds.maxs[ i ], localCenter[ i ] ) );
+	}
+	return ( closest - localCenter ).GetLengthSqr() <= radius * radius;
+}
+
+/*
+====================================================
+GetCoreSegment
+Spheres and capsules are a segment with a radius, a sphere's segment is a point
+====================================================
+*/
+static bool GetCoreSegment( const Shape * shape, const Vec3 & pos, const Quat & orient, Vec3 & a, Vec3 & b, float & radius ) {
+	if ( Shape::SHAPE_SPHERE == shape->GetType() ) {
+		a = pos;
+		b = pos;
+		radius = ( (const ShapeSphere *)shape )->m_radius;
+		return true;
+	}
+	if ( Shape::SHAPE_CAPSULE == shape->GetType() ) {
+		const ShapeCapsule * capsule = (const ShapeCapsule *)shape;
+		capsule->GetSegment( pos, orient, a, b );
+		radius = capsule->m_radius;
+		return true;
+	}
+	return false;
+}
+
+/*
+====================================================
+OverlapTriangles
+====================================================
+*/
+template< typename shape_t >
+static bool OverlapTriangles( const Body * body, const shape_t * meshShape, const Shape * shape, const Vec3 & pos, const Quat & orient ) {
+	bool doesOverlap = false;
+	auto callback = [ & ]( const int triangleIdx ) {
+		Vec3 a;
+		Vec3 b;
+		Vec3 c;
+		meshShape->GetTriangle( triangleIdx, a, b, c );
+		ShapeTriangle triangle( a, b, c );
+
+		Body part;
+		GetPartBody( body, &triangle, Vec3( 0.0f ), Quat( 0, 0, 0, 1 ), part );
+		doesOverlap = Overlap( &part, shape, pos, orient );
+		return !doesOverlap;
+	};
+	meshShape->QueryTriangles( ShapeCompound::ToLocalBounds( shape->GetBounds( pos, orient ), body->m_position, body->m_orientation ), callback );
+	return doesOverlap;
+}
+
+/*
+====================================================
+Overlap
+====================================================
+*/
+bool Overlap( const Body * body, const Shape * shape, const Vec3 & pos, const Quat & orient ) {
+	const Shape::shapeType_t typeA = shape->GetType();
+	const Shape::shapeType_t typeB = body->m_shape->GetType();
+
+	if ( Shape::SHAPE_COMPOUND == typeA ) {
+		const ShapeCompound * compound = (const ShapeCompound *)shape;
+		for ( int i = 0; i < (int)compound->m_children.size(); i++ ) {
+			Vec3 childPos;
+			Quat childOrient;
+			compound->GetChildTransform( i, pos, orient, childPos, childOrient );
+			if ( Overlap( body, compound->m_children[ i ].shape, childPos, childOrient ) ) {
+				return true;
+			}
+		}
+		return false;
+	}
+	if ( Shape::SHAPE_COMPOUND == typeB ) {
+		const ShapeCompound * compound = (const ShapeCompound *)body->m_shape;
+		bool doesOverlap = false;
+		auto callback = [ & ]( const int childIdx ) {
+			Body child;
+			GetCompoundChild( body, childIdx, child );
+			doesOverlap = Overlap( &child, shape, pos, orient );
+			return !doesOverlap;
+		};
+		compound->m_tree.QueryBounds( ShapeCompound::ToLocalBounds( shape->GetBounds( pos, orient ), body->m_position, body->m_orientation ), callback );
+		return doesOverlap;
+	}
+	if ( Shape::SHAPE_TRIANGLE_MESH == typeB ) {
+		return OverlapTriangles( body, (const ShapeTriangleMesh *)body->m_shape, shape, pos, orient );
+	}
+	if ( Shape::SHAPE_HEIGHTFIELD == typeB ) {
+		return OverlapTriangles( body, (const ShapeHeightfield *)body->m_shape, shape, pos, orient );
+	}
+
+	if ( Shape::SHAPE_SPHERE == typeA && Shape::SHAPE_SPHERE == typeB ) {
+		const float radius = ( (const ShapeSphere *)shape )->m_radius + ( (const ShapeSphere *)body->m_shape )->m_radius;
+		return ( body->m_position - pos ).GetLengthSqr() <= radius * radius;
+	}
+	if ( Shape::SHAPE_SPHERE == typeA && Shape::SHAPE_BOX == typeB ) {
+		return SphereBox( pos, ( (const ShapeSphere *)shape )->m_radius, (const ShapeBox *)body->m_shape, body->m_position, body->m_orientation );
+	}
+	if ( Shape::SHAPE_BOX == typeA && Shape::SHAPE_SPHERE == typeB ) {
+		return SphereBox( body->m_position, ( (const ShapeSphere *)body->m_shape )->m_radius, (const ShapeBox *)shape, pos, orient );
+	}
+
+	Vec3 a0;
+	Vec3 a1;
+	Vec3 b0;
+	Vec3 b1;
+	float radiusA;
+	float radiusB;
+	if ( GetCoreSegment( shape, pos, orient, a0, a1, radiusA ) && GetCoreSegment( body->m_shape, body->m_position, body->m_orientation, b0, b1, radiusB ) ) {
+		Vec3 ptOnA;
+		Vec3 ptOnB;
+		ClosestPointsSegmentSegment( a0, a1, b0, b1, ptOnA, ptOnB );
+		return ( ptOnB - ptOnA ).GetLengthSqr() <= ( radiusA + radiusB ) * ( radiusA + radiusB );
+	}
+
+	Body query;
+	query.m_position = pos;
+	query.m_orientation = orient;
+	query.m_shape = const_cast< Shape * >( shape );
+	return GJK_Overlap( &query, body );
+}
@@ -0,0 +1,58 @@
+//
+//	Queries.h
+//
+#pragma once
+#include "Body.h"
+
+/*
+====================================================
+queryMode_t
+====================================================
+*/
+enum queryMode_t {
+	QUERY_CLOSEST,	// the nearest hit
+	QUERY_ANY,		// whichever hit is found first, for line of sight checks
+	QUERY_ALL,		// every hit, nearest first
+};
+
+/*
+====================================================
+queryHit_t
+====================================================
+*/
+struct queryHit_t {
+	int body;			// index into Scene::m_bodies
+	float fraction;		// how far from the start to the end the hit is
+	Vec3 point;			// on the body, in world space
+	Vec3 normal;		// the body's surface normal at the point, zero when the cast starts inside it
+};
+
+/*
+====================================================
+rayCast_t
+====================================================
+*/
+struct rayCast_t {
+	Vec3 start;
+	Vec3 end;
+};
+
+/*
+====================================================
+shapeCast_t
+The shape is swept without turning, from start to end
+====================================================
+*/
+struct shapeCast_t {
+	const Shape * shape;
+	Quat orientation;
+	Vec3 start;
+	Vec3 end;
+};
+
+// Whether the body overlaps the shape placed at pos and orient
+bool Overlap( const Body * body, const Shape * shape, const Vec3 & pos, const Quat & orient );
+
+// Casts against a single body.  They only report hits at fractions up to maxFraction.
+bool RayCast( const Body * body, const Vec3 & start, const Vec3 & end, const float maxFraction, queryHit_t & hit );
+bool ShapeCast( const Body * body, const shapeCast_t & cast, const float maxFraction, queryHit_t & hit );
@@ -5,6 +5,10 @@
 #include "Shapes/ShapeSphere.h"
 #include "Shapes/ShapeBox.h"
 #include "Shapes/ShapeConvex.h"
+#include "Shapes/ShapeCapsule.h"
+#include "Shapes/ShapeCylinder.h"
+#include "Shapes/ShapeCompound.h"
+#include "Shapes/ShapeTriangleMesh.h"
 
 extern Vec3 g_boxGround[ 8 ];
 extern Vec3 g_boxWall0[ 8 ];
@@ -15,6 +15,8 @@ Shape
 */
 class Shape {
 public:
+	virtual ~Shape() {}
+
 	virtual Mat3 InertiaTensor() const = 0;
 
 	virtual Bounds GetBounds( const Vec3 & pos, const Quat & orient ) const = 0;
@@ -26,6 +28,12 @@ public:
 		SHAPE_SPHERE,
 		SHAPE_BOX,
 		SHAPE_CONVEX,
+		SHAPE_CAPSULE,
+		SHAPE_CYLINDER,
+		SHAPE_COMPOUND,
+		SHAPE_TRIANGLE_MESH,
+		SHAPE_HEIGHTFIELD,
+		SHAPE_TRIANGLE,
 	};
 	virtual shapeType_t GetType() const = 0;
 
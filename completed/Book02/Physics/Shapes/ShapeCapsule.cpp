@@ -0,0 +1,105 @@
+//
+//  ShapeCapsule.cpp
+//
+#include "ShapeCapsule.h"
+
+/*
+========================================================================================================
+
+ShapeCapsule
+
+========================================================================================================
+*/
+
+/*
+====================================================
+ShapeCapsule::GetSegment
+====================================================
+*/
+void ShapeCapsule::GetSegment( const Vec3 & pos, const Quat & orient, Vec3 & a, Vec3 & b ) const {
+	const Vec3 axis = orient.RotatePoint( Vec3( 0, 0, m_halfHeight ) );
+	a = pos - axis;
+	b = pos + axis;
+}
+
+/*
+====================================================
+ShapeCapsule::Support
+====================================================
+*/
+Vec3 ShapeCapsule::Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const {
+	Vec3 norm = dir;
+	norm.Normalize();
+
+	// The end of the segment furthest in the direction, pushed out by the radius
+	const Vec3 axis = orient.RotatePoint( Vec3( 0, 0, m_halfHeight ) );
+	const Vec3 end = ( axis.Dot( dir ) >= 0.0f ) ? ( pos + axis ) : ( pos - axis );
+	return end + norm * ( m_radius + bias );
+}
+
+/*
+====================================================
+ShapeCapsule::InertiaTensor
+====================================================
+*/
+Mat3 ShapeCapsule::InertiaTensor() const {
+	// Split the mass between the cylinder and the two hemispheres by volume
+	const float r = m_radius;
+	const float h = m_halfHeight;
+	const float volumeCylinder = 2.0f * h;	// the pi r^2 is common to both and cancels
+	const float volumeSphere = 4.0f * r / 3.0f;
+	const float massCylinder = volumeCylinder / ( volumeCylinder + volumeSphere );
+	const float massSphere = volumeSphere / ( volumeCylinder + volumeSphere );
+
+	// The hemispheres are moved out to the ends of the cylinder by the parallel axis theorem
+	const float axial = massCylinder * r * r / 2.0f + massSphere * 2.0f * r * r / 5.0f;
+	const float lateral = massCylinder * ( r * r / 4.0f + h * h / 3.0f ) + massSphere * ( 2.0f * r * r / 5.0f + h * h + 3.0f * h * r / 4.0f );
+
+	Mat3 tensor;
+	tensor.Zero();
+	tensor.rows[ 0 ][ 0 ] = lateral;
+	tensor.rows[ 1 ][ 1 ] = lateral;
+	tensor.rows[ 2 ][ 2 ] = axial;
+	return tensor;
+}
+
+/*
+====================================================
+ShapeCapsule::GetBounds
+====================================================
+*/
+Bounds ShapeCapsule::GetBounds( const Vec3 & pos, const Quat & orient ) const {
+	Vec3 a;
+	Vec3 b;
+	GetSegment( pos, orient, a, b );
+
+	Bounds tmp;
+	tmp.Expand( a );
+	tmp.Expand( b );
+	tmp.mins -= Vec3( m_radius );
+	tmp.maxs += Vec3( m_radius );
+	return tmp;
+}
+
+/*
+====================================================
+ShapeCapsule::GetBounds
+====================================================
+*/
+Bounds ShapeCapsule::GetBounds() const {
+	Bounds tmp;
+	tmp.mins = Vec3( -m_radius, -m_radius, -m_radius - m_halfHeight );
+	tmp.maxs = Vec3( m_radius, m_radius, m_radius + m_halfHeight );
+	return tmp;
+}
+
+/*
+====================================================
+ShapeCapsule::FastestLinearSpeed
+The speed along dir of a point r from the center is dir.( w x r ) = r.( dir x w ), and no point
+is further than the half height plus the radius from the center, whichever way the capsule faces
+====================================================
+*/
+float ShapeCapsule::FastestLinearSpeed( const Vec3 & angularVelocity, const Vec3 & dir ) const {
+	return dir.Cross( angularVelocity ).GetMagnitude() * ( m_halfHeight + m_radius );
+}
@@ -0,0 +1,36 @@
+//
+//	ShapeCapsule.h
+//
+#pragma once
+#include "ShapeBase.h"
+
+/*
+====================================================
+ShapeCapsule
+A segment along the local z axis, from -halfHeight to +halfHeight, swept by a sphere of the radius
+====================================================
+*/
+class ShapeCapsule : public Shape {
+public:
+	explicit ShapeCapsule( const float radius, const float halfHeight ) : m_radius( radius ), m_halfHeight( halfHeight ) {
+		m_centerOfMass.Zero();
+	}
+
+	Vec3 Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const override;
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds( const Vec3 & pos, const Quat & orient ) const override;
+	Bounds GetBounds() const override;
+
+	float FastestLinearSpeed( const Vec3 & angularVelocity, const Vec3 & dir ) const override;
+
+	shapeType_t GetType() const override { return SHAPE_CAPSULE; }
+
+	// The ends of the segment in world space
+	void GetSegment( const Vec3 & pos, const Quat & orient, Vec3 & a, Vec3 & b ) const;
+
+public:
+	float m_radius;
+	float m_halfHeight;
+};
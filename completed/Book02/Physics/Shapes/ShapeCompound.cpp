@@ -0,0 +1,157 @@
+//
+//  ShapeCompound.cpp
+//
+#include "ShapeCompound.h"
+#include <algorithm>
+
+/*
+========================================================================================================
+
+ShapeCompound
+
+========================================================================================================
+*/
+
+/*
+====================================================
+ShapeCompound::~ShapeCompound
+====================================================
+*/
+ShapeCompound::~ShapeCompound() {
+	for ( int i = 0; i < (int)m_children.size(); i++ ) {
+		delete m_children[ i ].shape;
+	}
+	m_children.clear();
+}
+
+/*
+====================================================
+ShapeCompound::Build
+====================================================
+*/
+void ShapeCompound::Build( const compoundChild_t * children, const int num ) {
+	m_children.assign( children, children + num );
+
+	// The center of mass is the children's centers of mass weighted by their mass
+	float totalMass = 0.0f;
+	m_centerOfMass.Zero();
+	for ( int i = 0; i < num; i++ ) {
+		const compoundChild_t & child = m_children[ i ];
+		m_centerOfMass += ( child.position + child.orientation.RotatePoint( child.shape->GetCenterOfMass() ) ) * child.mass;
+		totalMass += child.mass;
+	}
+	const float invTotalMass = ( totalMass > 0.0f ) ? ( 1.0f / totalMass ) : 0.0f;
+	m_centerOfMass *= invTotalMass;
+
+	// Each child's tensor is rotated into the compound's space, and moved to the compound's center of
+	// mass by the parallel axis theorem
+	m_inertiaTensor.Zero();
+	for ( int i = 0; i < num; i++ ) {
+		const compoundChild_t & child = m_children[ i ];
+		const Mat3 orient = child.orientation.ToMat3();
+		const Mat3 tensor = orient * child.shape->InertiaTensor() * orient.Transpose();
+
+		const Vec3 R = child.position + child.orientation.RotatePoint( child.shape->GetCenterOfMass() ) - m_centerOfMass;
+		const float R2 = R.GetLengthSqr();
+		Mat3 patTensor;
+		patTensor.rows[ 0 ] = Vec3(	R2 - R.x * R.x,		-R.x * R.y,		-R.x * R.z );
+		patTensor.rows[ 1 ] = Vec3(		-R.y * R.x,	R2 - R.y * R.y,		-R.y * R.z );
+		patTensor.rows[ 2 ] = Vec3(		-R.z * R.x,		-R.z * R.y,	R2 - R.z * R.z );
+
+		m_inertiaTensor += ( tensor + patTensor ) * ( child.mass * invTotalMass );
+	}
+
+	// The tree over the children
+	std::vector< Bounds > bounds( num );
+	m_bounds.Clear();
+	m_radius = 0.0f;
+	for ( int i = 0; i < num; i++ ) {
+		const compoundChild_t & child = m_children[ i ];
+		bounds[ i ] = child.shape->GetBounds( child.position, child.orientation );
+		m_bounds.Expand( bounds[ i ] );
+
+		const Vec3 corners[ 2 ] = { bounds[ i ].mins - m_centerOfMass, bounds[ i ].maxs - m_centerOfMass };
+		for ( int j = 0; j < 8; j++ ) {
+			const Vec3 corner( corners[ j & 1 ].x, corners[ ( j >> 1 ) & 1 ].y, corners[ j >> 2 ].z );
+			m_radius = std::max( m_radius, corner.GetMagnitude() );
+		}
+	}
+	m_tree.Build( bounds.data(), num );
+}
+
+/*
+====================================================
+ShapeCompound::GetChildTransform
+====================================================
+*/
+void ShapeCompound::GetChildTransform( const int idx, const Vec3 & pos, const Quat & orient, Vec3 & childPos, Quat & childOrient ) const {
+	const compoundChild_t & child = m_children[ idx ];
+	childPos = pos + orient.RotatePoint( child.position );
+	childOrient = orient * child.orientation;
+}
+
+/*
+====================================================
+ShapeCompound::ToLocalBounds
+====================================================
+*/
+Bounds ShapeCompound::ToLocalBounds( const Bounds & bounds, const Vec3 & pos, const Quat & orient ) {
+	const Quat invOrient = orient.Inverse();
+	const Vec3 corners[ 2 ] = { bounds.mins, bounds.maxs };
+
+	Bounds local;
+	for ( int i = 0; i < 8; i++ ) {
+		const Vec3 corner( corners[ i & 1 ].x, corners[ ( i >> 1 ) & 1 ].y, corners[ i >> 2 ].z );
+		local.Expand( invOrient.RotatePoint( corner - pos ) );
+	}
+	return local;
+}
+
+/*
+====================================================
+ShapeCompound::Support
+The support of the hull around all the children, only for callers that want a convex shape
+====================================================
+*/
+Vec3 ShapeCompound::Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const {
+	Vec3 maxPt = pos;
+	float maxDist = -1e30f;
+	for ( int i = 0; i < (int)m_children.size(); i++ ) {
+		Vec3 childPos;
+		Quat childOrient;
+		GetChildTransform( i, pos, orient, childPos, childOrient );
+
+		const Vec3 pt = m_children[ i ].shape->Support( dir, childPos, childOrient, bias );
+		const float dist = dir.Dot( pt );
+		if ( dist > maxDist ) {
+			maxDist = dist;
+			maxPt = pt;
+		}
+	}
+	return maxPt;
+}
+
+/*
+====================================================
+ShapeCompound::GetBounds
+====================================================
+*/
+Bounds ShapeCompound::GetBounds( const Vec3 & pos, const Quat & orient ) const {
+	Bounds bounds;
+	for ( int i = 0; i < (int)m_children.size(); i++ ) {
+		Vec3 childPos;
+		Quat childOrient;
+		GetChildTransform( i, pos, orient, childPos, childOrient );
+		bounds.Expand( m_children[ i ].shape->GetBounds( childPos, childOrient ) );
+	}
+	return bounds;
+}
+
+/*
+====================================================
+ShapeCompound::FastestLinearSpeed
+====================================================
+*/
+float ShapeCompound::FastestLinearSpeed( const Vec3 & angularVelocity, const Vec3 & dir ) const {
+	return dir.Cross( angularVelocity ).GetMagnitude() * m_radius;
+}
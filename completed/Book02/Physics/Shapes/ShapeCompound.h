@@ -0,0 +1,66 @@
+//
+//	ShapeCompound.h
+//
+#pragma once
+#include "ShapeBase.h"
+#include "../BoundsTree.h"
+
+/*
+====================================================
+compoundChild_t
+====================================================
+*/
+struct compoundChild_t {
+	Shape * shape;
+	Vec3 position;		// of the child's origin, in the compound's space
+	Quat orientation;
+	float mass;			// relative to the other children, only the ratios matter
+};
+
+/*
+====================================================
+ShapeCompound
+Several shapes held rigidly together, so an assembly is one body rather than bodies joined by
+constraints.  The compound owns the children's shapes.
+
+A tree over the children's bounds, in the compound's space, lets the narrowphase and the queries
+visit only the children near whatever they're testing.
+====================================================
+*/
+class ShapeCompound : public Shape {
+public:
+	explicit ShapeCompound( const compoundChild_t * children, const int num ) {
+		Build( children, num );
+	}
+	~ShapeCompound() override;
+	void Build( const compoundChild_t * children, const int num );
+
+	Vec3 Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const override;
+
+	Mat3 InertiaTensor() const override { return m_inertiaTensor; }
+
+	Bounds GetBounds( const Vec3 & pos, const Quat & orient ) const override;
+	Bounds GetBounds() const override { return m_bounds; }
+
+	float FastestLinearSpeed( const Vec3 & angularVelocity, const Vec3 & dir ) const override;
+
+	shapeType_t GetType() const override { return SHAPE_COMPOUND; }
+
+	// Where the child is in world space, when the compound is at pos and orient
+	void GetChildTransform( const int idx, const Vec3 & pos, const Quat & orient, Vec3 & childPos, Quat & childOrient ) const;
+
+	// Bounds in world space, as bounds in the compound's space, loosely
+	static Bounds ToLocalBounds( const Bounds & bounds, const Vec3 & pos, const Quat & orient );
+
+public:
+	std::vector< compoundChild_t > m_children;
+	BoundsTree m_tree;		// over the children's bounds, ids are indices into m_children
+	Bounds m_bounds;
+	Mat3 m_inertiaTensor;
+	float m_radius;			// furthest any child reaches from the center of mass
+
+private:
+	// The children would be deleted twice
+	ShapeCompound( const ShapeCompound & rhs );
+	ShapeCompound & operator = ( const ShapeCompound & rhs );
+};
@@ -0,0 +1,98 @@
+//
+//  ShapeCylinder.cpp
+//
+#include "ShapeCylinder.h"
+#include <algorithm>
+
+/*
+========================================================================================================
+
+ShapeCylinder
+
+========================================================================================================
+*/
+
+/*
+====================================================
+ShapeCylinder::Support
+====================================================
+*/
+Vec3 ShapeCylinder::Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const {
+	Vec3 norm = dir;
+	norm.Normalize();
+
+	// The cap furthest in the direction, then the point on its rim furthest in the direction
+	const Vec3 axis = orient.RotatePoint( Vec3( 0, 0, 1 ) );
+	const float alongAxis = axis.Dot( dir );
+	Vec3 pt = pos + axis * ( ( alongAxis >= 0.0f ) ? m_halfHeight : -m_halfHeight );
+
+	Vec3 radial = dir - axis * alongAxis;
+	const float radialLengthSqr = radial.GetLengthSqr();
+	if ( radialLengthSqr > 1e-12f ) {
+		pt += radial * ( m_radius / sqrtf( radialLengthSqr ) );
+	}
+
+	return pt + norm * bias;
+}
+
+/*
+====================================================
+ShapeCylinder::InertiaTensor
+====================================================
+*/
+Mat3 ShapeCylinder::InertiaTensor() const {
+	const float r = m_radius;
+	const float h = m_halfHeight;
+
+	Mat3 tensor;
+	tensor.Zero();
+	tensor.rows[ 0 ][ 0 ] = r * r / 4.0f + h * h / 3.0f;
+	tensor.rows[ 1 ][ 1 ] = r * r / 4.0f + h * h / 3.0f;
+	tensor.rows[ 2 ][ 2 ] = r * r / 2.0f;
+	return tensor;
+}
+
+/*
+====================================================
+ShapeCylinder::GetBounds
+Each cap is a disc, a disc of radius r facing along the unit axis u reaches r * sqrt( 1 - u_i^2 )
+from its center along world axis i
+====================================================
+*/
+Bounds ShapeCylinder::GetBounds( const Vec3 & pos, const Quat & orient ) const {
+	const Vec3 axis = orient.RotatePoint( Vec3( 0, 0, 1 ) );
+
+	Vec3 extents;
+	for ( int i = 0; i < 3; i++ ) {
+		const float discExtent = m_radius * sqrtf( std::max( 0.0f, 1.0f - axis[ i ] * axis[ i ] ) );
+		extents[ i ] = fabsf( axis[ i ] ) * m_halfHeight + discExtent;
+	}
+
+	Bounds tmp;
+	tmp.mins = pos - extents;
+	tmp.maxs = pos + extents;
+	return tmp;
+}
+
+/*
+====================================================
+ShapeCylinder::GetBounds
+====================================================
+*/
+Bounds ShapeCylinder::GetBounds() const {
+	Bounds tmp;
+	tmp.mins = Vec3( -m_radius, -m_radius, -m_halfHeight );
+	tmp.maxs = Vec3( m_radius, m_radius, m_halfHeight );
+	return tmp;
+}
+
+/*
+====================================================
+ShapeCylinder::FastestLinearSpeed
+The speed along dir of a point r from the center is r.( dir x w ), the rim of the caps is the
+furthest any point gets from the center
+====================================================
+*/
+float ShapeCylinder::FastestLinearSpeed( const Vec3 & angularVelocity, const Vec3 & dir ) const {
+	return dir.Cross( angularVelocity ).GetMagnitude() * sqrtf( m_halfHeight * m_halfHeight + m_radius * m_radius );
+}
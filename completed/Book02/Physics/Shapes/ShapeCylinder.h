@@ -0,0 +1,33 @@
+//
+//	ShapeCylinder.h
+//
+#pragma once
+#include "ShapeBase.h"
+
+/*
+====================================================
+ShapeCylinder
+A cylinder along the local z axis, from -halfHeight to +halfHeight
+====================================================
+*/
+class ShapeCylinder : public Shape {
+public:
+	explicit ShapeCylinder( const float radius, const float halfHeight ) : m_radius( radius ), m_halfHeight( halfHeight ) {
+		m_centerOfMass.Zero();
+	}
+
+	Vec3 Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const override;
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds( const Vec3 & pos, const Quat & orient ) const override;
+	Bounds GetBounds() const override;
+
+	float FastestLinearSpeed( const Vec3 & angularVelocity, const Vec3 & dir ) const override;
+
+	shapeType_t GetType() const override { return SHAPE_CYLINDER; }
+
+public:
+	float m_radius;
+	float m_halfHeight;
+};
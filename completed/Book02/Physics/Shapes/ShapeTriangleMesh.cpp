@@ -0,0 +1,458 @@
+//
+//  ShapeTriangleMesh.cpp
+//
+#include "ShapeTriangleMesh.h"
+
+/*
+====================================================
+TransformBounds
+Bounds around the bounds' corners once moved to pos and orient
+====================================================
+*/
+static Bounds TransformBounds( const Bounds & bounds, const Vec3 & pos, const Quat & orient ) {
+	const Vec3 corners[ 2 ] = { bounds.mins, bounds.maxs };
+
+	Bounds tmp;
+	for ( int i = 0; i < 8; i++ ) {
+		const Vec3 corner( corners[ i & 1 ].x, corners[ ( i >> 1 ) & 1 ].y, corners[ i >> 2 ].z );
+		tmp.Expand( orient.RotatePoint( corner ) + pos );
+	}
+	return tmp;
+}
+
+/*
+====================================================
+SupportBounds
+The corner of the bounds furthest in the direction
+====================================================
+*/
+static Vec3 SupportBounds( const Bounds & bounds, const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) {
+	const Vec3 localDir = orient.Inverse().RotatePoint( dir );
+	Vec3 corner;
+	for ( int i = 0; i < 3; i++ ) {
+		corner[ i ] = ( localDir[ i ] >= 0.0f ) ? bounds.maxs[ i ] : bounds.mins[ i ];
+	}
+
+	Vec3 norm = dir;
+	norm.Normalize();
+	return orient.RotatePoint( corner ) + pos + norm * bias;
+}
+
+/*
+====================================================
+BoundsInertiaTensor
+Static geometry has no inside to integrate over, a box the size of its bounds stands in
+====================================================
+*/
+static Mat3 BoundsInertiaTensor( const Bounds & bounds ) {
+	const float dx = bounds.maxs.x - bounds.mins.x;
+	const float dy = bounds.maxs.y - bounds.mins.y;
+	const float dz = bounds.maxs.z - bounds.mins.z;
+
+	Mat3 tensor;
+	tensor.Zero();
+	tensor.rows[ 0 ][ 0 ] = ( dy * dy + dz * dz ) / 12.0f;
+	tensor.rows[ 1 ][ 1 ] = ( dx * dx + dz * dz ) / 12.0f;
+	tensor.rows[ 2 ][ 2 ] = ( dx * dx + dy * dy ) / 12.0f;
+	return tensor;
+}
+
+/*
+========================================================================================================
+
+ShapeTriangle
+
+========================================================================================================
+*/
+
+/*
+====================================================
+ShapeTriangle::ShapeTriangle
+====================================================
+*/
+ShapeTriangle::ShapeTriangle( const Vec3 & a, const Vec3 & b, const Vec3 & c ) {
+	m_points[ 0 ] = a;
+	m_points[ 1 ] = b;
+	m_points[ 2 ] = c;
+	m_centerOfMass = ( a + b + c ) * ( 1.0f / 3.0f );
+
+	m_radius = 0.0f;
+	for ( int i = 0; i < 3; i++ ) {
+		m_radius = std::max( m_radius, ( m_points[ i ] - m_centerOfMass ).GetMagnitude() );
+	}
+}
+
+/*
+====================================================
+ShapeTriangle::Support
+====================================================
+*/
+Vec3 ShapeTriangle::Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const {
+	const Vec3 localDir = orient.Inverse().RotatePoint( dir );
+	int best = 0;
+	float bestDist = localDir.Dot( m_points[ 0 ] );
+	for ( int i = 1; i < 3; i++ ) {
+		const float dist = localDir.Dot( m_points[ i ] );
+		if ( dist > bestDist ) {
+			bestDist = dist;
+			best = i;
+		}
+	}
+
+	Vec3 norm = dir;
+	norm.Normalize();
+	return orient.RotatePoint( m_points[ best ] ) + pos + norm * bias;
+}
+
+/*
+====================================================
+ShapeTriangle::InertiaTensor
+Only so a stand in body can be moved, a sphere through the corners is close enough
+====================================================
+*/
+Mat3 ShapeTriangle::InertiaTensor() const {
+	const float r = std::max( m_radius, 1e-3f );
+
+	Mat3 tensor;
+	tensor.Zero();
+	tensor.rows[ 0 ][ 0 ] = 2.0f * r * r / 5.0f;
+	tensor.rows[ 1 ][ 1 ] = 2.0f * r * r / 5.0f;
+	tensor.rows[ 2 ][ 2 ] = 2.0f * r * r / 5.0f;
+	return tensor;
+}
+
+/*
+====================================================
+ShapeTriangle::GetBounds
+====================================================
+*/
+Bounds ShapeTriangle::GetBounds( const Vec3 & pos, const Quat & orient ) const {
+	Bounds tmp;
+	for ( int i = 0; i < 3; i++ ) {
+		tmp.Expand( orient.RotatePoint( m_points[ i ] ) + pos );
+	}
+	return tmp;
+}
+
+/*
+====================================================
+ShapeTriangle::GetBounds
+====================================================
+*/
+Bounds ShapeTriangle::GetBounds() const {
+	Bounds tmp;
+	tmp.Expand( m_points, 3 );
+	return tmp;
+}
+
+/*
+====================================================
+ShapeTriangle::FastestLinearSpeed
+====================================================
+*/
+float ShapeTriangle::FastestLinearSpeed( const Vec3 & angularVelocity, const Vec3 & dir ) const {
+	return dir.Cross( angularVelocity ).GetMagnitude() * m_radius;
+}
+
+/*
+========================================================================================================
+
+ShapeTriangleMesh
+
+========================================================================================================
+*/
+
+/*
+====================================================
+ShapeTriangleMesh::Build
+====================================================
+*/
+void ShapeTriangleMesh::Build( const Vec3 * verts, const int numVerts, const int * indices, const int numTriangles ) {
+	m_verts.assign( verts, verts + numVerts );
+
+	m_bounds.Clear();
+	m_bounds.Expand( verts, numVerts );
+	m_centerOfMass = ( m_bounds.mins + m_bounds.maxs ) * 0.5f;
+
+	// Scale the bounds to the 16 bit range.  Flat meshes get a little thickness so the scale is finite.
+	for ( int i = 0; i < 3; i++ ) {
+		const float width = std::max( m_bounds.maxs[ i ] - m_bounds.mins[ i ], 1e-4f );
+		m_quantizeScale[ i ] = 65535.0f / width;
+	}
+
+	std::vector< buildTriangle_t > tris( numTriangles );
+	for ( int i = 0; i < numTriangles; i++ ) {
+		buildTriangle_t & tri = tris[ i ];
+		tri.bounds.Clear();
+		tri.bounds.Expand( verts[ indices[ i * 3 + 0 ] ] );
+		tri.bounds.Expand( verts[ indices[ i * 3 + 1 ] ] );
+		tri.bounds.Expand( verts[ indices[ i * 3 + 2 ] ] );
+		tri.center = ( tri.bounds.mins + tri.bounds.maxs ) * 0.5f;
+		tri.idx = i;
+	}
+
+	m_nodes.clear();
+	m_nodes.reserve( numTriangles / 2 + 1 );
+	if ( numTriangles > 0 ) {
+		BuildNode( tris, 0, numTriangles );
+	}
+	m_nodes.shrink_to_fit();
+
+	// Store the triangles in leaf order
+	m_indices.resize( numTriangles * 3 );
+	for ( int i = 0; i < numTriangles; i++ ) {
+		for ( int j = 0; j < 3; j++ ) {
+			m_indices[ i * 3 + j ] = (unsigned int)indices[ tris[ i ].idx * 3 + j ];
+		}
+	}
+}
+
+/*
+====================================================
+ShapeTriangleMesh::BuildNode
+Splits at the median of the longest axis of the triangles' centers, returns the node's index
+====================================================
+*/
+int ShapeTriangleMesh::BuildNode( std::vector< buildTriangle_t > & tris, const int first, const int num ) {
+	const int nodeIdx = (int)m_nodes.size();
+	m_nodes.push_back( node_t() );
+
+	Bounds bounds;
+	Bounds centers;
+	for ( int i = first; i < first + num; i++ ) {
+		bounds.Expand( tris[ i ].bounds );
+		centers.Expand( tris[ i ].center );
+	}
+
+	if ( num <= MAX_LEAF_TRIANGLES ) {
+		node_t & node = m_nodes[ nodeIdx ];
+		Quantize( bounds, node.mins, node.maxs );
+		node.data = ( first << 3 ) | num;
+		return nodeIdx;
+	}
+
+	int axis = 0;
+	if ( centers.WidthY() > centers.WidthX() ) {
+		axis = 1;
+	}
+	if ( centers.WidthZ() > ( ( 0 == axis ) ? centers.WidthX() : centers.WidthY() ) ) {
+		axis = 2;
+	}
+
+	const int half = num / 2;
+	std::nth_element( tris.begin() + first, tris.begin() + first + half, tris.begin() + first + num,
+		[ axis ]( const buildTriangle_t & a, const buildTriangle_t & b ) {
+			if ( a.center[ axis ] != b.center[ axis ] ) {
+				return a.center[ axis ] < b.center[ axis ];
+			}
+			return a.idx < b.idx;	// so the tree doesn't depend on the sort implementation
+		} );
+
+	BuildNode( tris, first, half );
+	BuildNode( tris, first + half, num - half );
+
+	node_t & node = m_nodes[ nodeIdx ];
+	Quantize( bounds, node.mins, node.maxs );
+	node.data = -( (int)m_nodes.size() - nodeIdx );
+	return nodeIdx;
+}
+
+/*
+====================================================
+ShapeTriangleMesh::Quantize
+Rounds outwards, so the quantized bounds always hold the real ones
+====================================================
+*/
+void ShapeTriangleMesh::Quantize( const Bounds & bounds, unsigned short * mins, unsigned short * maxs ) const {
+	for ( int i = 0; i < 3; i++ ) {
+		const float lo = floorf( ( bounds.mins[ i ] - m_bounds.mins[ i ] ) * m_quantizeScale[ i ] );
+		const float hi = ceilf( ( bounds.maxs[ i ] - m_bounds.mins[ i ] ) * m_quantizeScale[ i ] );
+		mins[ i ] = (unsigned short)std::max( 0.0f, std::min( 65535.0f, lo ) );
+		maxs[ i ] = (unsigned short)std::max( 0.0f, std::min( 65535.0f, hi ) );
+	}
+}
+
+/*
+====================================================
+ShapeTriangleMesh::Dequantize
+====================================================
+*/
+Bounds ShapeTriangleMesh::Dequantize( const node_t & node ) const {
+	Bounds bounds;
+	for ( int i = 0; i < 3; i++ ) {
+		bounds.mins[ i ] = m_bounds.mins[ i ] + (float)node.mins[ i ] / m_quantizeScale[ i ];
+		bounds.maxs[ i ] = m_bounds.mins[ i ] + (float)node.maxs[ i ] / m_quantizeScale[ i ];
+	}
+	return bounds;
+}
+
+/*
+====================================================
+ShapeTriangleMesh::RayBounds
+====================================================
+*/
+bool ShapeTriangleMesh::RayBounds( const Vec3 & start, const Vec3 & invDir, const Bounds & bounds, const float maxFraction ) {
+	float tMin = 0.0f;
+	float tMax = maxFraction;
+	for ( int i = 0; i < 3; i++ ) {
+		float t0 = ( bounds.mins[ i ] - start[ i ] ) * invDir[ i ];
+		float t1 = ( bounds.maxs[ i ] - start[ i ] ) * invDir[ i ];
+		if ( t0 > t1 ) {
+			std::swap( t0, t1 );
+		}
+		tMin = std::max( tMin, t0 );
+		tMax = std::min( tMax, t1 );
+		if ( tMin > tMax ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+====================================================
+ShapeTriangleMesh::Support
+The mesh isn't convex, this is the support of its bounds
+====================================================
+*/
+Vec3 ShapeTriangleMesh::Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const {
+	return SupportBounds( m_bounds, dir, pos, orient, bias );
+}
+
+/*
+====================================================
+ShapeTriangleMesh::InertiaTensor
+====================================================
+*/
+Mat3 ShapeTriangleMesh::InertiaTensor() const {
+	return BoundsInertiaTensor( m_bounds );
+}
+
+/*
+====================================================
+ShapeTriangleMesh::GetBounds
+====================================================
+*/
+Bounds ShapeTriangleMesh::GetBounds( const Vec3 & pos, const Quat & orient ) const {
+	return TransformBounds( m_bounds, pos, orient );
+}
+
+/*
+====================================================
+ShapeTriangleMesh::GetMemoryUsage
+====================================================
+*/
+size_t ShapeTriangleMesh::GetMemoryUsage() const {
+	return m_verts.capacity() * sizeof( Vec3 ) + m_indices.capacity() * sizeof( unsigned int ) + m_nodes.capacity() * sizeof( node_t );
+}
+
+/*
+========================================================================================================
+
+ShapeHeightfield
+
+========================================================================================================
+*/
+
+/*
+====================================================
+ShapeHeightfield::Build
+====================================================
+*/
+void ShapeHeightfield::Build( const float * heights, const int numX, const int numY, const float spacing ) {
+	m_numX = numX;
+	m_numY = numY;
+	m_spacing = spacing;
+
+	float lowest = heights[ 0 ];
+	float highest = heights[ 0 ];
+	for ( int i = 1; i < numX * numY; i++ ) {
+		lowest = std::min( lowest, heights[ i ] );
+		highest = std::max( highest, heights[ i ] );
+	}
+	m_heightOffset = lowest;
+	m_heightScale = std::max( highest - lowest, 1e-4f ) / 65535.0f;
+
+	m_heights.resize( numX * numY );
+	for ( int i = 0; i < numX * numY; i++ ) {
+		const float fraction = ( heights[ i ] - m_heightOffset ) / m_heightScale;
+		m_heights[ i ] = (unsigned short)std::max( 0.0f, std::min( 65535.0f, floorf( fraction + 0.5f ) ) );
+	}
+
+	// The range of each block covers the samples on its far edges too, they're corners of its cells
+	const int numCellsX = numX - 1;
+	const int numCellsY = numY - 1;
+	m_numBlocksX = ( numCellsX + BLOCK_SIZE - 1 ) / BLOCK_SIZE;
+	const int numBlocksY = ( numCellsY + BLOCK_SIZE - 1 ) / BLOCK_SIZE;
+	m_blockRanges.resize( m_numBlocksX * numBlocksY * 2 );
+	for ( int by = 0; by < numBlocksY; by++ ) {
+		for ( int bx = 0; bx < m_numBlocksX; bx++ ) {
+			unsigned short blockLowest = 65535;
+			unsigned short blockHighest = 0;
+			const int x1 = std::min( numX - 1, ( bx + 1 ) * BLOCK_SIZE );
+			const int y1 = std::min( numY - 1, ( by + 1 ) * BLOCK_SIZE );
+			for ( int y = by * BLOCK_SIZE; y <= y1; y++ ) {
+				for ( int x = bx * BLOCK_SIZE; x <= x1; x++ ) {
+					blockLowest = std::min( blockLowest, m_heights[ y * numX + x ] );
+					blockHighest = std::max( blockHighest, m_heights[ y * numX + x ] );
+				}
+			}
+			const int block = by * m_numBlocksX + bx;
+			m_blockRanges[ block * 2 + 0 ] = blockLowest;
+			m_blockRanges[ block * 2 + 1 ] = blockHighest;
+		}
+	}
+
+	m_bounds.mins = Vec3( 0.0f, 0.0f, m_heightOffset );
+	m_bounds.maxs = Vec3( (float)( numX - 1 ) * spacing, (float)( numY - 1 ) * spacing, m_heightOffset + 65535.0f * m_heightScale );
+	m_centerOfMass = ( m_bounds.mins + m_bounds.maxs ) * 0.5f;
+}
+
+/*
+====================================================
+ShapeHeightfield::GetTriangle
+Each cell is split along the diagonal from ( x, y ) to ( x + 1, y + 1 ), both halves face up
+====================================================
+*/
+void ShapeHeightfield::GetTriangle( const int idx, Vec3 & a, Vec3 & b, Vec3 & c ) const {
+	const int cell = idx >> 1;
+	const int x = cell % ( m_numX - 1 );
+	const int y = cell / ( m_numX - 1 );
+
+	a = GetSample( x, y );
+	if ( 0 == ( idx & 1 ) ) {
+		b = GetSample( x + 1, y );
+		c = GetSample( x + 1, y + 1 );
+	} else {
+		b = GetSample( x + 1, y + 1 );
+		c = GetSample( x, y + 1 );
+	}
+}
+
+/*
+====================================================
+ShapeHeightfield::Support
+The heightfield isn't convex, this is the support of its bounds
+====================================================
+*/
+Vec3 ShapeHeightfield::Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const {
+	return SupportBounds( m_bounds, dir, pos, orient, bias );
+}
+
+/*
+====================================================
+ShapeHeightfield::InertiaTensor
+====================================================
+*/
+Mat3 ShapeHeightfield::InertiaTensor() const {
+	return BoundsInertiaTensor( m_bounds );
+}
+
+/*
+====================================================
+ShapeHeightfield::GetBounds
+====================================================
+*/
+Bounds ShapeHeightfield::GetBounds( const Vec3 & pos, const Quat & orient ) const {
+	return TransformBounds( m_bounds, pos, orient );
+}
@@ -0,0 +1,382 @@
+//
+//	ShapeTriangleMesh.h
+//
+#pragma once
+#include "ShapeBase.h"
+#include <algorithm>
+
+/*
+====================================================
+ShapeTriangle
+A single triangle of a triangle mesh or heightfield, so the convex routines (GJK, EPA, conservative
+advancement) can test one at a time.  It's a stand in that lives for one test, not a body's shape.
+====================================================
+*/
+class ShapeTriangle : public Shape {
+public:
+	explicit ShapeTriangle( const Vec3 & a, const Vec3 & b, const Vec3 & c );
+
+	Vec3 Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const override;
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds( const Vec3 & pos, const Quat & orient ) const override;
+	Bounds GetBounds() const override;
+
+	float FastestLinearSpeed( const Vec3 & angularVelocity, const Vec3 & dir ) const override;
+
+	shapeType_t GetType() const override { return SHAPE_TRIANGLE; }
+
+public:
+	Vec3 m_points[ 3 ];
+	float m_radius;		// furthest corner from the center
+};
+
+/*
+====================================================
+ShapeTriangleMesh
+Static world geometry.  Only bodies with no mass should use it, a mesh has no inside so the mass
+properties are those of its bounds.
+
+The triangles are kept in a tree of quantized bounds: each node stores its bounds as 16 bit
+fractions of the mesh's bounds, so a node is 16 bytes and four share a cache line.  Nodes are
+stored depth first, an internal node's subtree directly follows it and the node records how many
+nodes to skip to get past it, so a traversal walks forward through memory without a stack.  The
+triangles are reordered so each leaf's are consecutive.
+
+That's 16 bytes a node and roughly one node for every two triangles, plus 12 bytes of indices a
+triangle and 12 bytes a vertex.
+====================================================
+*/
+class ShapeTriangleMesh : public Shape {
+public:
+	// Three indices into the verts for each triangle.  The triangles are stored in a different order.
+	explicit ShapeTriangleMesh( const Vec3 * verts, const int numVerts, const int * indices, const int numTriangles ) {
+		Build( verts, numVerts, indices, numTriangles );
+	}
+	void Build( const Vec3 * verts, const int numVerts, const int * indices, const int numTriangles );
+
+	Vec3 Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const override;
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds( const Vec3 & pos, const Quat & orient ) const override;
+	Bounds GetBounds() const override { return m_bounds; }
+
+	shapeType_t GetType() const override { return SHAPE_TRIANGLE_MESH; }
+
+	int GetNumTriangles() const { return (int)m_indices.size() / 3; }
+	void GetTriangle( const int idx, Vec3 & a, Vec3 & b, Vec3 & c ) const {
+		a = m_verts[ m_indices[ idx * 3 + 0 ] ];
+		b = m_verts[ m_indices[ idx * 3 + 1 ] ];
+		c = m_verts[ m_indices[ idx * 3 + 2 ] ];
+	}
+
+	// Calls callback( triangle ) for every triangle whose bounds overlap these, in the mesh's space.
+	// The callback returns false to stop.
+	template< typename callback_t >
+	void QueryTriangles( const Bounds & bounds, callback_t & callback ) const;
+
+	// Calls callback( triangle, maxFraction ) for the triangles near the ray start + t * dir, with t up
+	// to maxFraction, in the mesh's space.  The callback can lower maxFraction, and returns false to stop.
+	template< typename callback_t >
+	void CastTriangles( const Vec3 & start, const Vec3 & dir, float maxFraction, callback_t & callback ) const;
+
+	size_t GetMemoryUsage() const;
+
+	static const int MAX_LEAF_TRIANGLES = 4;
+
+	struct node_t {
+		unsigned short mins[ 3 ];	// fractions of the mesh's bounds, rounded outwards
+		unsigned short maxs[ 3 ];
+		int data;					// leaves: first triangle << 3 | number of triangles.  others: -( nodes in the subtree )
+	};
+
+public:
+	std::vector< Vec3 > m_verts;
+	std::vector< unsigned int > m_indices;	// three per triangle, in leaf order
+	std::vector< node_t > m_nodes;
+	Bounds m_bounds;
+	Vec3 m_quantizeScale;	// from the mesh's space, relative to its mins, to the 16 bit range
+
+private:
+	struct buildTriangle_t {
+		Bounds bounds;
+		Vec3 center;
+		int idx;
+	};
+
+	int BuildNode( std::vector< buildTriangle_t > & tris, const int first, const int num );
+	void Quantize( const Bounds & bounds, unsigned short * mins, unsigned short * maxs ) const;
+	Bounds Dequantize( const node_t & node ) const;
+	static bool RayBounds( const Vec3 & start, const Vec3 & invDir, const Bounds & bounds, const float maxFraction );
+};
+
+/*
+====================================================
+ShapeTriangleMesh::QueryTriangles
+====================================================
+*/
+template< typename callback_t >
+inline void ShapeTriangleMesh::QueryTriangles( const Bounds & bounds, callback_t & callback ) const {
+	if ( m_nodes.empty() || !m_bounds.DoesIntersect( bounds ) ) {
+		return;
+	}
+
+	unsigned short mins[ 3 ];
+	unsigned short maxs[ 3 ];
+	Quantize( bounds, mins, maxs );
+
+	const int numNodes = (int)m_nodes.size();
+	int nodeIdx = 0;
+	while ( nodeIdx < numNodes ) {
+		const node_t & node = m_nodes[ nodeIdx ];
+		const bool overlaps =
+			node.mins[ 0 ] <= maxs[ 0 ] && node.maxs[ 0 ] >= mins[ 0 ] &&
+			node.mins[ 1 ] <= maxs[ 1 ] && node.maxs[ 1 ] >= mins[ 1 ] &&
+			node.mins[ 2 ] <= maxs[ 2 ] && node.maxs[ 2 ] >= mins[ 2 ];
+
+		if ( node.data < 0 ) {
+			nodeIdx += overlaps ? 1 : -node.data;
+			continue;
+		}
+
+		if ( overlaps ) {
+			const int first = node.data >> 3;
+			const int num = node.data & 7;
+			for ( int i = first; i < first + num; i++ ) {
+				Vec3 a;
+				Vec3 b;
+				Vec3 c;
+				GetTriangle( i, a, b, c );
+				Bounds triBounds;
+				triBounds.Expand( a );
+				triBounds.Expand( b );
+				triBounds.Expand( c );
+				if ( triBounds.DoesIntersect( bounds ) && !callback( i ) ) {
+					return;
+				}
+			}
+		}
+		nodeIdx++;
+	}
+}
+
+/*
+====================================================
+ShapeTriangleMesh::CastTriangles
+====================================================
+*/
+template< typename callback_t >
+inline void ShapeTriangleMesh::CastTriangles( const Vec3 & start, const Vec3 & dir, float maxFraction, callback_t & callback ) const {
+	Vec3 invDir;
+	for ( int i = 0; i < 3; i++ ) {
+		invDir[ i ] = ( fabsf( dir[ i ] ) > 1e-20f ) ? 1.0f / dir[ i ] : 1e20f;
+	}
+
+	const int numNodes = (int)m_nodes.size();
+	int nodeIdx = 0;
+	while ( nodeIdx < numNodes ) {
+		const node_t & node = m_nodes[ nodeIdx ];
+		const bool overlaps = RayBounds( start, invDir, Dequantize( node ), maxFraction );
+
+		if ( node.data < 0 ) {
+			nodeIdx += overlaps ? 1 : -node.data;
+			continue;
+		}
+
+		if ( overlaps ) {
+			const int first = node.data >> 3;
+			const int num = node.data & 7;
+			for ( int i = first; i < first + num; i++ ) {
+				if ( !callback( i, maxFraction ) ) {
+					return;
+				}
+			}
+		}
+		nodeIdx++;
+	}
+}
+
+/*
+====================================================
+ShapeHeightfield
+Static terrain, a grid of heights.  Sample ( x, y ) is at ( x * spacing, y * spacing ) in the
+shape's space, and each cell between four samples is two triangles.
+
+Heights are stored as 16 bit fractions of the range between the lowest and highest, and each
+block of cells keeps the range of its heights, so a query skips whole blocks above or below it.
+====================================================
+*/
+class ShapeHeightfield : public Shape {
+public:
+	// numX * numY heights, row by row
+	explicit ShapeHeightfield( const float * heights, const int numX, const int numY, const float spacing ) {
+		Build( heights, numX, numY, spacing );
+	}
+	void Build( const float * heights, const int numX, const int numY, const float spacing );
+
+	Vec3 Support( const Vec3 & dir, const Vec3 & pos, const Quat & orient, const float bias ) const override;
+
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds( const Vec3 & pos, const Quat & orient ) const override;
+	Bounds GetBounds() const override { return m_bounds; }
+
+	shapeType_t GetType() const override { return SHAPE_HEIGHTFIELD; }
+
+	float GetHeight( const int x, const int y ) const { return m_heightOffset + m_heightScale * (float)m_heights[ y * m_numX + x ]; }
+	Vec3 GetSample( const int x, const int y ) const { return Vec3( (float)x * m_spacing, (float)y * m_spacing, GetHeight( x, y ) ); }
+
+	int GetNumTriangles() const { return ( m_numX - 1 ) * ( m_numY - 1 ) * 2; }
+	void GetTriangle( const int idx, Vec3 & a, Vec3 & b, Vec3 & c ) const;
+
+	// The same as the triangle mesh's
+	template< typename callback_t >
+	void QueryTriangles( const Bounds & bounds, callback_t & callback ) const;
+	template< typename callback_t >
+	void CastTriangles( const Vec3 & start, const Vec3 & dir, float maxFraction, callback_t & callback ) const;
+
+	size_t GetMemoryUsage() const { return m_heights.size() * sizeof( unsigned short ) + m_blockRanges.size() * sizeof( unsigned short ); }
+
+	static const int BLOCK_SIZE = 16;	// cells along each side of a block
+
+public:
+	int m_numX;
+	int m_numY;
+	float m_spacing;
+	float m_heightOffset;
+	float m_heightScale;
+	std::vector< unsigned short > m_heights;
+	std::vector< unsigned short > m_blockRanges;	// lowest and highest height of each block
+	int m_numBlocksX;
+	Bounds m_bounds;
+
+private:
+	template< typename callback_t >
+	bool QueryCell( const int x, const int y, const Bounds & bounds, callback_t & callback ) const;
+};
+
+/*
+====================================================
+ShapeHeightfield::QueryCell
+====================================================
+*/
+template< typename callback_t >
+inline bool ShapeHeightfield::QueryCell( const int x, const int y, const Bounds & bounds, callback_t & callback ) const {
+	const float h00 = GetHeight( x, y );
+	const float h10 = GetHeight( x + 1, y );
+	const float h01 = GetHeight( x, y + 1 );
+	const float h11 = GetHeight( x + 1, y + 1 );
+	const float lowest = std::min( std::min( h00, h10 ), std::min( h01, h11 ) );
+	const float highest = std::max( std::max( h00, h10 ), std::max( h01, h11 ) );
+	if ( lowest > bounds.maxs.z || highest < bounds.mins.z ) {
+		return true;
+	}
+
+	const int triangle = ( y * ( m_numX - 1 ) + x ) * 2;
+	return callback( triangle ) && callback( triangle + 1 );
+}
+
+/*
+====================================================
+ShapeHeightfield::QueryTriangles
+====================================================
+*/
+template< typename callback_t >
+inline void ShapeHeightfield::QueryTriangles( const Bounds & bounds, callback_t & callback ) const {
+	if ( !m_bounds.DoesIntersect( bounds ) ) {
+		return;
+	}
+
+	const int maxCell = std::max( m_numX, m_numY );
+	const int x0 = std::max( 0, (int)floorf( bounds.mins.x / m_spacing ) );
+	const int y0 = std::max( 0, (int)floorf( bounds.mins.y / m_spacing ) );
+	const int x1 = std::min( m_numX - 2, (int)std::min( floorf( bounds.maxs.x / m_spacing ), (float)maxCell ) );
+	const int y1 = std::min( m_numY - 2, (int)std::min( floorf( bounds.maxs.y / m_spacing ), (float)maxCell ) );
+
+	for ( int by = y0 / BLOCK_SIZE; by <= y1 / BLOCK_SIZE; by++ ) {
+		for ( int bx = x0 / BLOCK_SIZE; bx <= x1 / BLOCK_SIZE; bx++ ) {
+			const int block = by * m_numBlocksX + bx;
+			const float lowest = m_heightOffset + m_heightScale * (float)m_blockRanges[ block * 2 + 0 ];
+			const float highest = m_heightOffset + m_heightScale * (float)m_blockRanges[ block * 2 + 1 ];
+			if ( lowest > bounds.maxs.z || highest < bounds.mins.z ) {
+				continue;
+			}
+
+			const int cx1 = std::min( x1, bx * BLOCK_SIZE + BLOCK_SIZE - 1 );
+			const int cy1 = std::min( y1, by * BLOCK_SIZE + BLOCK_SIZE - 1 );
+			for ( int y = std::max( y0, by * BLOCK_SIZE ); y <= cy1; y++ ) {
+				for ( int x = std::max( x0, bx * BLOCK_SIZE ); x <= cx1; x++ ) {
+					if ( !QueryCell( x, y, bounds, callback ) ) {
+						return;
+					}
+				}
+			}
+		}
+	}
+}
+
+/*
+====================================================
+ShapeHeightfield::CastTriangles
+Walks the cells under the ray in the order it crosses them
+====================================================
+*/
+template< typename callback_t >
+inline void ShapeHeightfield::CastTriangles( const Vec3 & start, const Vec3 & dir, float maxFraction, callback_t & callback ) const {
+	// Clip the ray to the bounds
+	float tMin = 0.0f;
+	float tMax = maxFraction;
+	for ( int i = 0; i < 3; i++ ) {
+		if ( fabsf( dir[ i ] ) < 1e-20f ) {
+			if ( start[ i ] < m_bounds.mins[ i ] || start[ i ] > m_bounds.maxs[ i ] ) {
+				return;
+			}
+			continue;
+		}
+		float t0 = ( m_bounds.mins[ i ] - start[ i ] ) / dir[ i ];
+		float t1 = ( m_bounds.maxs[ i ] - start[ i ] ) / dir[ i ];
+		if ( t0 > t1 ) {
+			std::swap( t0, t1 );
+		}
+		tMin = std::max( tMin, t0 );
+		tMax = std::min( tMax, t1 );
+		if ( tMin > tMax ) {
+			return;
+		}
+	}
+
+	const Vec3 entry = start + dir * tMin;
+	int x = std::max( 0, std::min( m_numX - 2, (int)floorf( entry.x / m_spacing ) ) );
+	int y = std::max( 0, std::min( m_numY - 2, (int)floorf( entry.y / m_spacing ) ) );
+
+	// The ray parameter of the next cell boundary along x and y, and how far apart they are
+	const int stepX = ( dir.x > 0.0f ) ? 1 : -1;
+	const int stepY = ( dir.y > 0.0f ) ? 1 : -1;
+	const float deltaX = ( fabsf( dir.x ) > 1e-20f ) ? m_spacing / fabsf( dir.x ) : 1e30f;
+	const float deltaY = ( fabsf( dir.y ) > 1e-20f ) ? m_spacing / fabsf( dir.y ) : 1e30f;
+	float nextX = ( fabsf( dir.x ) > 1e-20f ) ? ( (float)( x + ( stepX > 0 ? 1 : 0 ) ) * m_spacing - start.x ) / dir.x : 1e30f;
+	float nextY = ( fabsf( dir.y ) > 1e-20f ) ? ( (float)( y + ( stepY > 0 ? 1 : 0 ) ) * m_spacing - start.y ) / dir.y : 1e30f;
+
+	float tEnter = tMin;
+	while ( tEnter <= std::min( tMax, maxFraction ) ) {
+		const int triangle = ( y * ( m_numX - 1 ) + x ) * 2;
+		if ( !callback( triangle, maxFraction ) || !callback( triangle + 1, maxFraction ) ) {
+			return;
+		}
+
+		if ( nextX < nextY ) {
+			x += stepX;
+			tEnter = nextX;
+			nextX += deltaX;
+		} else {
+			y += stepY;
+			tEnter = nextY;
+			nextY += deltaY;
+		}
+		if ( x < 0 || y < 0 || x > m_numX - 2 || y > m_numY - 2 ) {
+			return;
+		}
+	}
+}
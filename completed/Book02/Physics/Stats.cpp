@@ -0,0 +1,7 @@
+//
+//	Stats.cpp
+//
+#include "Stats.h"
+#include <stddef.h>
+
+thread_local physicsStats_t * g_collisionStats = NULL;
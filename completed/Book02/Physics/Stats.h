@@ -0,0 +1,61 @@
+//
+//	Stats.h
+//
+#pragma once
+
+/*
+====================================================
+physicsStats_t
+Counters for a single Scene::Update, for finding out why a step was slow
+====================================================
+*/
+struct physicsStats_t {
+	// Iteration histograms use power of two buckets: 0-1, 2-3, 4-7, 8-15 ... and the last bucket holds the rest
+	static const int NUM_HISTOGRAM_BUCKETS = 8;
+	static const int MAX_SOLVER_ITERATIONS = 32;
+
+	int step;					// index of the update since the scene was built
+
+	int numBodies;
+	int numConstraints;
+	int numBrokenConstraints;	// joints that broke and were removed
+
+	int numPairs;				// potential collision pairs from the broadphase, after filtering
+	int numPairsRejected;		// pairs the midphase showed can't touch this step
+	int numPairsTested;			// pairs that reached the narrowphase
+	int numPairsHit;			// pairs that produced a contact
+	int numStaticContacts;		// contacts added to manifolds (time of impact zero)
+	int numBallisticContacts;	// contacts resolved by time of impact
+	int numManifolds;
+	int numManifoldContacts;
+	int numBlockFallbacks;		// manifolds the block solver found no consistent set of contacts for
+
+	int numGJK;
+	int numEPA;
+	int numConservativeAdvance;
+	int gjkIterations[ NUM_HISTOGRAM_BUCKETS ];
+	int epaIterations[ NUM_HISTOGRAM_BUCKETS ];
+	int conservativeAdvanceIterations[ NUM_HISTOGRAM_BUCKETS ];
+
+	// Length of the change in body velocities made by each solver iteration,
+	// if the solver is converging then this falls with each iteration
+	int numSolverIterations;
+	float solverResidual[ MAX_SOLVER_ITERATIONS ];
+
+	int numIslands;				// groups of bodies connected by constraints or contacts
+	int numIslandIterations;	// solver iterations summed over the islands (and substeps)
+	int maxIslandIterations;	// most iterations any one island took
+	int numPositionIterations;	// split impulse position sweeps summed over the islands (and substeps)
+
+	static int HistogramBucket( const int iterations ) {
+		int bucket = 0;
+		while ( ( iterations >> ( bucket + 1 ) ) > 0 && bucket < NUM_HISTOGRAM_BUCKETS - 1 ) {
+			bucket++;
+		}
+		return bucket;
+	}
+};
+
+// The collision routines running on this thread add their counts here.  Scene::Update points it
+// at its own stats during the narrowphase, and NULL counts nothing.
+extern thread_local physicsStats_t * g_collisionStats;
@@ -6,6 +6,14 @@
 #include "Physics/Contact.h"
 #include "Physics/Broadphase.h"
 #include "Physics/Intersections.h"
+#include "Profiler.h"
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+
+// How far a body may still be moving when the split impulse position pass stops on an island
+static const float POSITION_TOLERANCE = 1e-4f;
 
 /*
 ========================================================================================================
@@ -33,17 +41,31 @@ Scene::Reset
 ====================================================
 */
 void Scene::Reset() {
+	Clear();
+	Initialize();
+}
+
+/*
+====================================================
+Scene::Clear
+====================================================
+*/
+void Scene::Clear() {
 	for ( int i = 0; i < m_bodies.size(); i++ ) {
 		delete m_bodies[ i ].m_shape;
 	}
 	m_bodies.clear();
 
-	for ( int i = 0; i < m_constraints.size(); i++ ) {
-		delete m_constraints[ i ];
-	}
-	m_constraints.clear();
+	m_constraints.Clear();
+	m_brokenConstraints.clear();
 
-	Initialize();
+	m_manifolds.Clear();
+
+	m_broadphase.Clear();
+	m_midphase.Clear();
+
+	m_numSteps = 0;
+	m_queryTreeStep = -1;
 }
 
 /*
@@ -107,170 +129,179 @@ void AddStandardSandBox( std::vector< Body > & bodies ) {
 
 /*
 ====================================================
-Scene::Initialize
+AddRagdoll
+The bodies vector must have enough capacity for the six new bodies, since the joints point into it
 ====================================================
 */
-void Scene::Initialize() {
-	const float pi = acosf( -1.0f );
+void AddRagdoll( std::vector< Body > & bodies, ConstraintPool & constraints, const Vec3 & offset ) {
+	const int first = (int)bodies.size();
+	const int firstConstraint = constraints.size();
 	Body body;
 
-	//
-	//	Build a ragdoll
-	//
-	{
-		Vec3 offset = Vec3( -5, 0, 0 );
-		
-		// head
-		body.m_position = Vec3( 0, 0, 5.5f ) + offset;
-		body.m_orientation = Quat( 0, 0, 0, 1 );
-		body.m_shape = new ShapeBox( g_boxSmall, sizeof( g_boxSmall ) / sizeof( Vec3 ) );
-		body.m_invMass = 2.0f;
-		body.m_elasticity = 1.0f;
-		body.m_friction = 1.0f;
-		m_bodies.push_back( body );
-
-		// torso
-		body.m_position = Vec3( 0, 0, 4 ) + offset;
-		body.m_orientation = Quat( 0, 0, 0, 1 );
-		body.m_shape = new ShapeBox( g_boxBody, sizeof( g_boxBody ) / sizeof( Vec3 ) );
-		body.m_invMass = 0.5f;
-		body.m_elasticity = 1.0f;
-		body.m_friction = 1.0f;
-		m_bodies.push_back( body );
+	// The limbs are capsules the size of g_boxLimb, two long and half a unit thick
+	const float limbRadius = 0.25f;
+	const float limbHalfHeight = 0.75f;
 
-		// left arm
-		body.m_position = Vec3( 0.0f, 2.0f, 4.75f ) + offset;
-		body.m_orientation = Quat( Vec3( 0, 0, 1 ), -3.1415f / 2.0f );
-		body.m_shape = new ShapeBox( g_boxLimb, sizeof( g_boxLimb ) / sizeof( Vec3 ) );
-		body.m_invMass = 1.0f;
-		body.m_elasticity = 1.0f;
-		body.m_friction = 1.0f;
-		m_bodies.push_back( body );
+	// head
+	body.m_position = Vec3( 0, 0, 5.5f ) + offset;
+	body.m_orientation = Quat( 0, 0, 0, 1 );
+	body.m_shape = new ShapeBox( g_boxSmall, sizeof( g_boxSmall ) / sizeof( Vec3 ) );
+	body.m_invMass = 2.0f;
+	body.m_elasticity = 1.0f;
+	body.m_friction = 1.0f;
+	bodies.push_back( body );
 
-		// right arm
-		body.m_position = Vec3( 0.0f, -2.0f, 4.75f ) + offset;
-		body.m_orientation = Quat( Vec3( 0, 0, 1 ), 3.1415f / 2.0f );
-		body.m_shape = new ShapeBox( g_boxLimb, sizeof( g_boxLimb ) / sizeof( Vec3 ) );
-		body.m_invMass = 1.0f;
-		body.m_elasticity = 1.0f;
-		body.m_friction = 1.0f;
-		m_bodies.push_back( body );
+	// torso
+	body.m_position = Vec3( 0, 0, 4 ) + offset;
+	body.m_orientation = Quat( 0, 0, 0, 1 );
+	body.m_shape = new ShapeBox( g_boxBody, sizeof( g_boxBody ) / sizeof( Vec3 ) );
+	body.m_invMass = 0.5f;
+	body.m_elasticity = 1.0f;
+	body.m_friction = 1.0f;
+	bodies.push_back( body );
 
-		// left leg
-		body.m_position = Vec3( 0.0f, 1.0f, 2.5f ) + offset;
-		body.m_orientation = Quat( Vec3( 0, 1, 0 ), 3.1415f / 2.0f );
-		body.m_shape = new ShapeBox( g_boxLimb, sizeof( g_boxLimb ) / sizeof( Vec3 ) );
-		body.m_invMass = 1.0f;
-		body.m_elasticity = 1.0f;
-		body.m_friction = 1.0f;
-		m_bodies.push_back( body );
+	// left arm
+	body.m_position = Vec3( 0.0f, 2.0f, 4.75f ) + offset;
+	body.m_orientation = Quat( Vec3( 1, 0, 0 ), -3.1415f / 2.0f );
+	body.m_shape = new ShapeCapsule( limbRadius, limbHalfHeight );
+	body.m_invMass = 1.0f;
+	body.m_elasticity = 1.0f;
+	body.m_friction = 1.0f;
+	bodies.push_back( body );
 
-		// right leg
-		body.m_position = Vec3( 0.0f, -1.0f, 2.5f ) + offset;
-		body.m_orientation = Quat( Vec3( 0, 1, 0 ), 3.1415f / 2.0f );
-		body.m_shape = new ShapeBox( g_boxLimb, sizeof( g_boxLimb ) / sizeof( Vec3 ) );
-		body.m_invMass = 1.0f;
-		body.m_elasticity = 1.0f;
-		body.m_friction = 1.0f;
-		m_bodies.push_back( body );
+	// right arm
+	body.m_position = Vec3( 0.0f, -2.0f, 4.75f ) + offset;
+	body.m_orientation = Quat( Vec3( 1, 0, 0 ), 3.1415f / 2.0f );
+	body.m_shape = new ShapeCapsule( limbRadius, limbHalfHeight );
+	body.m_invMass = 1.0f;
+	body.m_elasticity = 1.0f;
+	body.m_friction = 1.0f;
+	bodies.push_back( body );
 
-		const int idxHead = 0;
-		const int idxTorso = 1;
-		const int idxArmLeft = 2;
-		const int idxArmRight = 3;
-		const int idxLegLeft = 4;
-		const int idxLegRight = 5;
+	// left leg
+	body.m_position = Vec3( 0.0f, 1.0f, 2.5f ) + offset;
+	body.m_orientation = Quat( 0, 0, 0, 1 );
+	body.m_shape = new ShapeCapsule( limbRadius, limbHalfHeight );
+	body.m_invMass = 1.0f;
+	body.m_elasticity = 1.0f;
+	body.m_friction = 1.0f;
+	bodies.push_back( body );
 
-		// Neck
-		{
-			ConstraintHingeQuatLimited * joint = new ConstraintHingeQuatLimited();
-			joint->m_bodyA = &m_bodies[ idxHead ];
-			joint->m_bodyB = &m_bodies[ idxTorso ];
+	// right leg
+	body.m_position = Vec3( 0.0f, -1.0f, 2.5f ) + offset;
+	body.m_orientation = Quat( 0, 0, 0, 1 );
+	body.m_shape = new ShapeCapsule( limbRadius, limbHalfHeight );
+	body.m_invMass = 1.0f;
+	body.m_elasticity = 1.0f;
+	body.m_friction = 1.0f;
+	bodies.push_back( body );
 
-			const Vec3 jointWorldSpaceAnchor	= joint->m_bodyA->m_position + Vec3( 0, 0, -0.5f );
-			joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
-			joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+	const int idxHead = first + 0;
+	const int idxTorso = first + 1;
+	const int idxArmLeft = first + 2;
+	const int idxArmRight = first + 3;
+	const int idxLegLeft = first + 4;
+	const int idxLegRight = first + 5;
 
-			joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, 1, 0 ) );
+	// Neck
+	{
+		ConstraintHingeQuatLimited * joint = constraints.Create< ConstraintHingeQuatLimited >();
+		joint->m_bodyA = &bodies[ idxHead ];
+		joint->m_bodyB = &bodies[ idxTorso ];
 
-			// Set the initial relative orientation
-			joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+		const Vec3 jointWorldSpaceAnchor	= joint->m_bodyA->m_position + Vec3( 0, 0, -0.5f );
+		joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+		joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
 
-			m_constraints.push_back( joint );
-		}
+		joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, 1, 0 ) );
 
-		// Shoulder Left
-		{
-			ConstraintConstantVelocityLimited * joint = new ConstraintConstantVelocityLimited();
-			joint->m_bodyB = &m_bodies[ idxArmLeft ];
-			joint->m_bodyA = &m_bodies[ idxTorso ];
+		// Set the initial relative orientation
+		joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+	}
 
-			const Vec3 jointWorldSpaceAnchor	= joint->m_bodyB->m_position + Vec3( 0, -1.0f, 0.0f );
-			joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
-			joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+	// Shoulder Left
+	{
+		ConstraintConstantVelocityLimited * joint = constraints.Create< ConstraintConstantVelocityLimited >();
+		joint->m_bodyB = &bodies[ idxArmLeft ];
+		joint->m_bodyA = &bodies[ idxTorso ];
 
-			joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, 1, 0 ) );
+		const Vec3 jointWorldSpaceAnchor	= joint->m_bodyB->m_position + Vec3( 0, -1.0f, 0.0f );
+		joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+		joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
 
-			// Set the initial relative orientation
-			joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+		joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, 1, 0 ) );
 
-			m_constraints.push_back( joint );
-		}
+		// Set the initial relative orientation
+		joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+	}
 
-		// Shoulder Right
-		{
-			ConstraintConstantVelocityLimited * joint = new ConstraintConstantVelocityLimited();
-			joint->m_bodyB = &m_bodies[ idxArmRight ];
-			joint->m_bodyA = &m_bodies[ idxTorso ];
+	// Shoulder Right
+	{
+		ConstraintConstantVelocityLimited * joint = constraints.Create< ConstraintConstantVelocityLimited >();
+		joint->m_bodyB = &bodies[ idxArmRight ];
+		joint->m_bodyA = &bodies[ idxTorso ];
 
-			const Vec3 jointWorldSpaceAnchor	= joint->m_bodyB->m_position + Vec3( 0, 1.0f, 0.0f );
-			joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
-			joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+		const Vec3 jointWorldSpaceAnchor	= joint->m_bodyB->m_position + Vec3( 0, 1.0f, 0.0f );
+		joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+		joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
 
-			joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, -1, 0 ) );
+		joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, -1, 0 ) );
 
-			// Set the initial relative orientation
-			joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+		// Set the initial relative orientation
+		joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+	}
 
-			m_constraints.push_back( joint );
-		}
+	// Hip Left
+	{
+		ConstraintHingeQuatLimited * joint = constraints.Create< ConstraintHingeQuatLimited >();
+		joint->m_bodyB = &bodies[ idxLegLeft ];
+		joint->m_bodyA = &bodies[ idxTorso ];
 
-		// Hip Left
-		{
-			ConstraintHingeQuatLimited * joint = new ConstraintHingeQuatLimited();
-			joint->m_bodyB = &m_bodies[ idxLegLeft ];
-			joint->m_bodyA = &m_bodies[ idxTorso ];
+		const Vec3 jointWorldSpaceAnchor	= joint->m_bodyB->m_position + Vec3( 0, 0, 0.5f );
+		joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+		joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
 
-			const Vec3 jointWorldSpaceAnchor	= joint->m_bodyB->m_position + Vec3( 0, 0, 0.5f );
-			joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
-			joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+		joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, 1, 0 ) );
 
-			joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, 1, 0 ) );
+		// Set the initial relative orientation
+		joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+	}
 
-			// Set the initial relative orientation
-			joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+	// Hip Right
+	{
+		ConstraintHingeQuatLimited * joint = constraints.Create< ConstraintHingeQuatLimited >();
+		joint->m_bodyB = &bodies[ idxLegRight ];
+		joint->m_bodyA = &bodies[ idxTorso ];
 
-			m_constraints.push_back( joint );
-		}
+		const Vec3 jointWorldSpaceAnchor	= joint->m_bodyB->m_position + Vec3( 0, 0, 0.5f );
+		joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+		joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
 
-		// Hip Right
-		{
-			ConstraintHingeQuatLimited * joint = new ConstraintHingeQuatLimited();
-			joint->m_bodyB = &m_bodies[ idxLegRight ];
-			joint->m_bodyA = &m_bodies[ idxTorso ];
+		joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, 1, 0 ) );
 
-			const Vec3 jointWorldSpaceAnchor	= joint->m_bodyB->m_position + Vec3( 0, 0, 0.5f );
-			joint->m_anchorA	= joint->m_bodyA->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
-			joint->m_anchorB	= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
+		// Set the initial relative orientation
+		joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+	}
 
-			joint->m_axisA = joint->m_bodyA->m_orientation.Inverse().RotatePoint( Vec3( 0, 1, 0 ) );
+	// The limbs overlap the torso around the joints, contacts there would only fight the joints
+	for ( int i = firstConstraint; i < constraints.size(); i++ ) {
+		constraints[ i ]->m_disableCollision = true;
+	}
+}
 
-			// Set the initial relative orientation
-			joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
+/*
+====================================================
+Scene::Initialize
+====================================================
+*/
+void Scene::Initialize() {
+	const float pi = acosf( -1.0f );
+	Body body;
 
-			m_constraints.push_back( joint );
-		}
-	}
+	//
+	//	Build a ragdoll
+	//
+	AddRagdoll( m_bodies, m_constraints, Vec3( -5, 0, 0 ) );
 
 	//
 	// Build a chain for funsies
@@ -283,6 +314,7 @@ void Scene::Initialize() {
 			body.m_shape = new ShapeBox( g_boxSmall, sizeof( g_boxSmall ) / sizeof( Vec3 ) );
 			body.m_invMass = 0.0f;
 			body.m_elasticity = 1.0f;
+			body.m_friction = 1.0f;
 			m_bodies.push_back( body );
 		} else {
 			body.m_invMass = 1.0f;
@@ -302,7 +334,7 @@ void Scene::Initialize() {
 		Vec3 jointWorldSpaceAxisLimited = Vec3( 0, 1, -1 );
 		jointWorldSpaceAxisLimited.Normalize();
 
-		ConstraintDistance * joint = new ConstraintDistance();
+		ConstraintDistance * joint = m_constraints.Create< ConstraintDistance >();
 
 		const float pi = acosf( -1.0f );
 
@@ -321,8 +353,6 @@ void Scene::Initialize() {
 		joint->m_bodyB			= &m_bodies[ m_bodies.size() - 1 ];
 		joint->m_anchorB		= joint->m_bodyB->WorldSpaceToBodySpace( jointWorldSpaceAnchor );
 		joint->m_axisB			= joint->m_bodyB->m_orientation.Inverse().RotatePoint( jointWorldSpaceAxis );
-
-		m_constraints.push_back( joint );
 	}
 
 	//
@@ -395,7 +425,7 @@ void Scene::Initialize() {
 	body.m_friction = 0.5f;
 	m_bodies.push_back( body );
 	{
-		ConstraintMotor * joint = new ConstraintMotor();
+		ConstraintMotor * joint = m_constraints.Create< ConstraintMotor >();
 		joint->m_bodyA = &m_bodies[ m_bodies.size() - 2 ];
 		joint->m_bodyB = &m_bodies[ m_bodies.size() - 1 ];
 
@@ -408,8 +438,6 @@ void Scene::Initialize() {
 	
 		// Set the initial relative orientation (in bodyA's space)
 		joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
-		
-		m_constraints.push_back( joint );
 	}
 
 	//
@@ -424,10 +452,8 @@ void Scene::Initialize() {
 	body.m_friction = 0.9f;
 	m_bodies.push_back( body );
 	{
-		ConstraintMoverSimple * mover = new ConstraintMoverSimple();
+		ConstraintMoverSimple * mover = m_constraints.Create< ConstraintMoverSimple >();
 		mover->m_bodyA = &m_bodies[ m_bodies.size() - 1 ];
-
-		m_constraints.push_back( mover );
 	}
 
 	body.m_position = Vec3( 10, 0, 6.3f );
@@ -461,7 +487,7 @@ void Scene::Initialize() {
 	body.m_friction = 0.5f;
 	m_bodies.push_back( body );
 	{
-		ConstraintHingeQuatLimited * joint = new ConstraintHingeQuatLimited();
+		ConstraintHingeQuatLimited * joint = m_constraints.Create< ConstraintHingeQuatLimited >();
 		joint->m_bodyA = &m_bodies[ m_bodies.size() - 2 ];
 		joint->m_bodyB = &m_bodies[ m_bodies.size() - 1 ];
 
@@ -473,8 +499,6 @@ void Scene::Initialize() {
 
 		// Set the initial relative orientation
 		joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
-
-		m_constraints.push_back( joint );
 	}
 
 	//
@@ -499,7 +523,7 @@ void Scene::Initialize() {
 	body.m_friction = 0.5f;
 	m_bodies.push_back( body );
 	{
-		ConstraintConstantVelocityLimited * joint = new ConstraintConstantVelocityLimited();
+		ConstraintConstantVelocityLimited * joint = m_constraints.Create< ConstraintConstantVelocityLimited >();
 		joint->m_bodyA = &m_bodies[ m_bodies.size() - 2 ];
 		joint->m_bodyB = &m_bodies[ m_bodies.size() - 1 ];
 
@@ -511,8 +535,6 @@ void Scene::Initialize() {
 
 		// Set the initial relative orientation
 		joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
-
-		m_constraints.push_back( joint );
 	}
 
 	//
@@ -561,7 +583,7 @@ void Scene::Initialize() {
 	body.m_friction = 0.5f;
 	m_bodies.push_back( body );
 	{
-		ConstraintOrientation * joint = new ConstraintOrientation();
+		ConstraintOrientation * joint = m_constraints.Create< ConstraintOrientation >();
 		joint->m_bodyA = &m_bodies[ m_bodies.size() - 2 ];
 		joint->m_bodyB = &m_bodies[ m_bodies.size() - 1 ];
 
@@ -571,8 +593,6 @@ void Scene::Initialize() {
 
 		// Set the initial relative orientation
 		joint->m_q0 = joint->m_bodyA->m_orientation.Inverse() * joint->m_bodyB->m_orientation;
-
-		m_constraints.push_back( joint );
 	}
 
 	//
@@ -594,113 +614,527 @@ int CompareContacts( const void * p1, const void * p2 ) {
 		return -1;
 	}
 
-	if ( a.timeOfImpact == b.timeOfImpact ) {
-		return 0;
+	if ( a.timeOfImpact > b.timeOfImpact ) {
+		return 1;
 	}
 
-	return 1;
+	// Equal times of impact are ordered by the bodies involved, so that
+	// the result doesn't depend on the qsort implementation
+	if ( a.bodyA != b.bodyA ) {
+		return ( a.bodyA < b.bodyA ) ? -1 : 1;
+	}
+	if ( a.bodyB != b.bodyB ) {
+		return ( a.bodyB < b.bodyB ) ? -1 : 1;
+	}
+	return 0;
 }
 
 /*
 ====================================================
-Scene::Update
+GetTimeMicroseconds
 ====================================================
 */
-void Scene::Update( const float dt_sec ) {
-	m_manifolds.RemoveExpired();
+static double GetTimeMicroseconds() {
+	using namespace std::chrono;
+	return (double)duration_cast< nanoseconds >( steady_clock::now().time_since_epoch() ).count() * 0.001;
+}
 
-	// Gravity impulse
+/*
+====================================================
+Scene::ApplyGravity
+====================================================
+*/
+void Scene::ApplyGravity( const float dt_sec ) {
+	PROFILE_SCOPE( "Gravity" );
 	for ( int i = 0; i < m_bodies.size(); i++ ) {
 		Body * body = &m_bodies[ i ];
 		float mass = 1.0f / body->m_invMass;
 		Vec3 impulseGravity = Vec3( 0, 0, -10 ) * mass * dt_sec;
 		body->ApplyImpulseLinear( impulseGravity );
 	}
+}
 
-	//
-	// Broadphase (build potential collision pairs)
-	//
-	std::vector< collisionPair_t > collisionPairs;
-	BroadPhase( m_bodies.data(), (int)m_bodies.size(), collisionPairs, dt_sec );
+/*
+====================================================
+Scene::SolveConstraints
+====================================================
+*/
+void Scene::SolveConstraints( const float dt_sec, const int numIterations, const bool isLastSubstep ) {
+	{
+		PROFILE_SCOPE( "PreSolve" );
+		m_constraints.PreSolve( dt_sec, m_solverContext );
+		m_manifolds.PreSolve( dt_sec, m_solverContext );
+	}
 
-	//
-	//	NarrowPhase (perform actual collision detection)
-	//
-	int numContacts = 0;
-	contact_t * contacts = (contact_t *)alloca( sizeof( contact_t ) * collisionPairs.size() );
-	for ( int i = 0; i < collisionPairs.size(); i++ ) {
-		const collisionPair_t & pair = collisionPairs[ i ];
-		Body * bodyA = &m_bodies[ pair.a ];
-		Body * bodyB = &m_bodies[ pair.b ];
-
-		// Skip body pairs with infinite mass
-		if ( 0.0f == bodyA->m_invMass && 0.0f == bodyB->m_invMass ) {
-			continue;
+	// Velocities before the first iteration, for measuring how much each iteration changes them
+	m_solverVelocities.resize( m_bodies.size() * 2 );
+	for ( int i = 0; i < m_bodies.size(); i++ ) {
+		m_solverVelocities[ i * 2 + 0 ] = m_bodies[ i ].m_linearVelocity;
+		m_solverVelocities[ i * 2 + 1 ] = m_bodies[ i ].m_angularVelocity;
+	}
+
+	// Islands don't share any dynamic bodies, so each can be iterated on its own until it converges
+	const bool isAdaptive = ( m_solverTolerance > 0.0f );
+	const float toleranceSqr = m_solverTolerance * m_solverTolerance;
+	const int maxIterations = isAdaptive ? m_maxIterations : numIterations;
+
+	// With substeps the residuals of every substep follow on from each other
+	const int firstResidual = m_stepStats.numSolverIterations;
+	float residualSqr[ physicsStats_t::MAX_SOLVER_ITERATIONS ] = { 0.0f };
+	int numResiduals = 0;
+
+	if ( m_useDirectJointSolver ) {
+		PROFILE_SCOPE( "FactorJoints" );
+		m_jointTrees.resize( m_islands.size() );
+		for ( int islandIdx = 0; islandIdx < m_islands.size(); islandIdx++ ) {
+			const island_t & island = m_islands[ islandIdx ];
+			m_jointTrees[ islandIdx ].Build( m_constraints.data(), m_islandConstraints.data() + island.firstConstraint, island.numConstraints, dt_sec, m_solverContext );
 		}
+	}
 
-		// Check for intersection
-		contact_t contact;
-		if ( Intersect( bodyA, bodyB, dt_sec, contact ) ) {
-			if ( 0.0f == contact.timeOfImpact ) {
-				// Static contact
-				m_manifolds.AddContact( contact );
+	for ( int islandIdx = 0; islandIdx < m_islands.size(); islandIdx++ ) {
+		PROFILE_SCOPE( "SolveIsland" );
+		const island_t & island = m_islands[ islandIdx ];
+
+		int iters = 0;
+		while ( iters < maxIterations ) {
+			m_solverContext.maxImpulseSqr = 0.0f;
+			if ( m_useDirectJointSolver ) {
+				JointTree & tree = m_jointTrees[ islandIdx ];
+				tree.Solve( m_solverContext );
+				for ( int i = 0; i < tree.GetNumRemaining(); i++ ) {
+					tree.GetRemaining( i )->Solve( m_solverContext );
+				}
 			} else {
-				// Ballistic contact
-				contacts[ numContacts ] = contact;
-				numContacts++;
+				m_constraints.Solve( m_islandConstraints.data() + island.firstConstraint, island.numConstraints, m_solverContext );
 			}
+			for ( int i = 0; i < island.numManifolds; i++ ) {
+				m_manifolds.m_manifolds[ m_islandManifolds[ island.firstManifold + i ] ].Solve( m_solverContext );
+			}
+
+			const int residualIdx = firstResidual + iters;
+			iters++;
+			if ( residualIdx < physicsStats_t::MAX_SOLVER_ITERATIONS ) {
+				for ( int i = 0; i < island.numBodies; i++ ) {
+					const int bodyIdx = m_islandBodies[ island.firstBody + i ];
+					const Body & body = m_bodies[ bodyIdx ];
+					residualSqr[ residualIdx ] += ( body.m_linearVelocity - m_solverVelocities[ bodyIdx * 2 + 0 ] ).GetLengthSqr();
+					residualSqr[ residualIdx ] += ( body.m_angularVelocity - m_solverVelocities[ bodyIdx * 2 + 1 ] ).GetLengthSqr();
+					m_solverVelocities[ bodyIdx * 2 + 0 ] = body.m_linearVelocity;
+					m_solverVelocities[ bodyIdx * 2 + 1 ] = body.m_angularVelocity;
+				}
+			}
+
+			if ( isAdaptive && m_solverContext.maxImpulseSqr < toleranceSqr ) {
+				break;
+			}
+		}
+
+		numResiduals = ( iters > numResiduals ) ? iters : numResiduals;
+		m_stepStats.numIslandIterations += iters;
+		if ( iters > m_stepStats.maxIslandIterations ) {
+			m_stepStats.maxIslandIterations = iters;
+		}
+	}
+
+	for ( int i = firstResidual; i < firstResidual + numResiduals && i < physicsStats_t::MAX_SOLVER_ITERATIONS; i++ ) {
+		m_stepStats.solverResidual[ i ] = sqrtf( residualSqr[ i ] );
+		m_stepStats.numSolverIterations = i + 1;
+	}
+
+	if ( m_useSplitImpulse ) {
+		SolvePositions( dt_sec );
+	}
+
+	// Add up the joints' impulses while their accumulators still hold the whole substep's, and
+	// test them against their break impulses once the last substep has been solved.  Broken
+	// joints are only removed once they've finished the step like every other constraint.
+	const int firstBroken = (int)m_brokenConstraints.size();
+	{
+		PROFILE_SCOPE( "BreakConstraints" );
+		AccumulateJointImpulses();
+		if ( isLastSubstep ) {
+			BreakConstraints();
+		}
+	}
+
+	{
+		PROFILE_SCOPE( "PostSolve" );
+		m_constraints.PostSolve();
+		m_manifolds.PostSolve();
+	}
+
+	if ( firstBroken < (int)m_brokenConstraints.size() ) {
+		PROFILE_SCOPE( "RemoveBroken" );
+		for ( int i = firstBroken; i < m_brokenConstraints.size(); i++ ) {
+			m_constraints.Remove( m_brokenConstraints[ i ].handle );
+		}
+		m_stepStats.numBrokenConstraints += (int)m_brokenConstraints.size() - firstBroken;
+
+		// Removing constraints renumbers them, so the islands no longer match
+		BuildIslands();
+	}
+}
+
+/*
+====================================================
+Scene::SolvePositions
+The split impulse position pass.  Like the velocities, each island is iterated on its own, until a
+sweep changes its pseudo velocities by less than would move a body POSITION_TOLERANCE over the
+step, or for m_numPositionIterations sweeps.
+====================================================
+*/
+void Scene::SolvePositions( const float dt_sec ) {
+	PROFILE_SCOPE( "SolvePositions" );
+
+	const float maxChange = POSITION_TOLERANCE / dt_sec;
+	const float maxChangeSqr = maxChange * maxChange;
+
+	// The pseudo velocities start each pass at zero
+	m_solverVelocities.assign( m_bodies.size() * 2, Vec3( 0.0f ) );
+
+	for ( int islandIdx = 0; islandIdx < m_islands.size(); islandIdx++ ) {
+		const island_t & island = m_islands[ islandIdx ];
+
+		int iters = 0;
+		while ( iters < m_numPositionIterations ) {
+			for ( int i = 0; i < island.numManifolds; i++ ) {
+				m_manifolds.m_manifolds[ m_islandManifolds[ island.firstManifold + i ] ].SolvePositions();
+			}
+			iters++;
+
+			float changeSqr = 0.0f;
+			for ( int i = 0; i < island.numBodies; i++ ) {
+				const int bodyIdx = m_islandBodies[ island.firstBody + i ];
+				const Body & body = m_bodies[ bodyIdx ];
+				changeSqr = std::max( changeSqr, ( body.m_pseudoLinearVelocity - m_solverVelocities[ bodyIdx * 2 + 0 ] ).GetLengthSqr() );
+				changeSqr = std::max( changeSqr, ( body.m_pseudoAngularVelocity - m_solverVelocities[ bodyIdx * 2 + 1 ] ).GetLengthSqr() );
+				m_solverVelocities[ bodyIdx * 2 + 0 ] = body.m_pseudoLinearVelocity;
+				m_solverVelocities[ bodyIdx * 2 + 1 ] = body.m_pseudoAngularVelocity;
+			}
+			if ( changeSqr < maxChangeSqr ) {
+				break;
+			}
+		}
+		m_stepStats.numPositionIterations += iters;
+	}
+}
+
+/*
+====================================================
+Scene::AccumulateJointImpulses
+Adds the impulse each breakable joint applied this substep to m_jointImpulses, since a joint's
+accumulator only holds the impulse of the substep it was last solved in
+====================================================
+*/
+void Scene::AccumulateJointImpulses() {
+	const int numConstraints = m_constraints.size();
+	bool isAnyBreakable = false;
+	for ( int i = 0; i < numConstraints; i++ ) {
+		if ( m_constraints[ i ]->m_breakImpulse > 0.0f ) {
+			m_jointImpulses[ i ] += m_constraints[ i ]->GetAccumulatedImpulse();
+			isAnyBreakable = true;
+		}
+	}
+
+	// The direct solver's impulses don't go through the joints' own accumulators
+	if ( isAnyBreakable && m_useDirectJointSolver ) {
+		for ( int islandIdx = 0; islandIdx < m_islands.size(); islandIdx++ ) {
+			const JointTree & tree = m_jointTrees[ islandIdx ];
+			for ( int j = 0; j < tree.GetNumJoints(); j++ ) {
+				m_jointImpulses[ tree.GetJointIndex( j ) ] += tree.GetJointImpulse( j );
+			}
+		}
+	}
+}
+
+/*
+====================================================
+Scene::BreakConstraints
+Adds the joints whose impulse over the whole step is larger than their break impulse to
+m_brokenConstraints
+====================================================
+*/
+void Scene::BreakConstraints() {
+	const int numConstraints = m_constraints.size();
+	for ( int i = 0; i < numConstraints; i++ ) {
+		const Constraint * constraint = m_constraints[ i ];
+		if ( constraint->m_breakImpulse <= 0.0f ) {
+			continue;
+		}
+
+		const Vec3 impulse = m_jointImpulses[ i ];
+		if ( impulse.GetLengthSqr() <= constraint->m_breakImpulse * constraint->m_breakImpulse ) {
+			continue;
+		}
+
+		constraintBreak_t broken;
+		broken.handle = m_constraints.GetHandle( i );
+		broken.type = m_constraints.GetType( i );
+		broken.bodyA = constraint->m_bodyA;
+		broken.bodyB = constraint->m_bodyB;
+		broken.impulse = impulse.GetMagnitude();
+		m_brokenConstraints.push_back( broken );
+	}
+}
+
+/*
+====================================================
+Scene::Integrate
+Moves the bodies forward to endTime (measured from the start of the step), stopping at each
+ballistic contact's time of impact along the way to resolve it.  On the last substep every
+remaining contact is resolved, wherever its time of impact is.
+====================================================
+*/
+void Scene::Integrate( contact_t * contacts, const int numContacts, int & nextContact, float & accumulatedTime, const float endTime, const bool isLast ) {
+	{
+		PROFILE_SCOPE( "BallisticContacts" );
+		for ( ; nextContact < numContacts; nextContact++ ) {
+			contact_t & contact = contacts[ nextContact ];
+			if ( !isLast && contact.timeOfImpact > endTime ) {
+				break;
+			}
+			const float dt = contact.timeOfImpact - accumulatedTime;
+
+			// Position update
+			for ( int j = 0; j < m_bodies.size(); j++ ) {
+				m_bodies[ j ].Update( dt );
+			}
+
+			ResolveContact( contact );
+			accumulatedTime += dt;
+		}
+	}
+
+	// Update the positions for the rest of this substep's time
+	{
+		PROFILE_SCOPE( "Integrate" );
+		const float timeRemaining = endTime - accumulatedTime;
+		if ( timeRemaining > 0.0f ) {
+			for ( int i = 0; i < m_bodies.size(); i++ ) {
+				m_bodies[ i ].Update( timeRemaining );
+			}
+			accumulatedTime = endTime;
 		}
 	}
+}
 
-	// Sort the times of impact from first to last
-	if ( numContacts > 1 ) {
-		qsort( contacts, numContacts, sizeof( contact_t ), CompareContacts );
+/*
+====================================================
+Scene::ApplyPseudoVelocities
+Moves the bodies by the split impulse position correction from the last solve
+====================================================
+*/
+void Scene::ApplyPseudoVelocities( const float dt_sec ) {
+	PROFILE_SCOPE( "ApplyPseudoVelocities" );
+	for ( int i = 0; i < m_bodies.size(); i++ ) {
+		m_bodies[ i ].ApplyPseudoVelocity( dt_sec );
+	}
+}
+
+/*
+====================================================
+Scene::BuildExcludedPairs
+Gathers the bodies that constraints keep from colliding, for the broadphase
+====================================================
+*/
+void Scene::BuildExcludedPairs() {
+	m_excludedPairs.clear();
+	for ( int i = 0; i < m_constraints.size(); i++ ) {
+		const Constraint * constraint = m_constraints[ i ];
+		if ( !constraint->m_disableCollision || NULL == constraint->m_bodyA || NULL == constraint->m_bodyB ) {
+			continue;
+		}
+
+		const int a = (int)( constraint->m_bodyA - m_bodies.data() );
+		const int b = (int)( constraint->m_bodyB - m_bodies.data() );
+		collisionPair_t pair;
+		pair.a = std::min( a, b );
+		pair.b = std::max( a, b );
+		m_excludedPairs.push_back( pair );
+	}
+
+	std::sort( m_excludedPairs.begin(), m_excludedPairs.end(), []( const collisionPair_t & lhs, const collisionPair_t & rhs ) {
+		return ( lhs.a != rhs.a ) ? ( lhs.a < rhs.a ) : ( lhs.b < rhs.b );
+	} );
+}
+
+/*
+====================================================
+Scene::Update
+====================================================
+*/
+void Scene::Update( const float dt_sec ) {
+	PROFILE_SCOPE( "Scene::Update" );
+	const double timeStart = GetTimeMicroseconds();
+
+	memset( &m_stepStats, 0, sizeof( m_stepStats ) );
+	m_brokenConstraints.clear();
+
+	{
+		PROFILE_SCOPE( "RemoveExpired" );
+		m_manifolds.RemoveExpired();
+	}
+
+	// Substeps apply their own gravity
+	const bool isSubstepping = ( m_numSubsteps > 1 );
+	if ( !isSubstepping ) {
+		ApplyGravity( dt_sec );
 	}
 
 	//
-	//	Solve Constraints
+	// Broadphase (build potential collision pairs)
 	//
-	for ( int i = 0; i < m_constraints.size(); i++ ) {
-		m_constraints[ i ]->PreSolve( dt_sec );
+	{
+		PROFILE_SCOPE( "BroadPhase" );
+		BuildExcludedPairs();
+		m_broadphase.Update( m_bodies.data(), (int)m_bodies.size(), m_collisionPairs, dt_sec, m_excludedPairs.data(), (int)m_excludedPairs.size() );
 	}
-	m_manifolds.PreSolve( dt_sec );
+	m_stepStats.numPairs = (int)m_collisionPairs.size();
+	const double timeBroadphase = GetTimeMicroseconds();
 
-	const int maxIters = 5;
-	for ( int iters = 0; iters < maxIters; iters++ ) {
-		for ( int i = 0; i < m_constraints.size(); i++ ) {
-			m_constraints[ i ]->Solve();
+	//
+	//	NarrowPhase (perform actual collision detection)
+	//
+	int numContacts = 0;
+	contact_t * contacts = (contact_t *)alloca( sizeof( contact_t ) * m_collisionPairs.size() );
+	{
+		PROFILE_SCOPE( "NarrowPhase" );
+		g_collisionStats = &m_stepStats;
+		for ( int i = 0; i < m_collisionPairs.size(); i++ ) {
+			const collisionPair_t & pair = m_collisionPairs[ i ];
+			Body * bodyA = &m_bodies[ pair.a ];
+			Body * bodyB = &m_bodies[ pair.b ];
+
+			if ( m_useMidphase && m_midphase.IsSeparated( pair, *bodyA, *bodyB, dt_sec ) ) {
+				m_stepStats.numPairsRejected++;
+				continue;
+			}
+
+			// Check for intersection
+			m_stepStats.numPairsTested++;
+			contact_t contact;
+			if ( Intersect( bodyA, bodyB, dt_sec, contact ) ) {
+				m_stepStats.numPairsHit++;
+				if ( 0.0f == contact.timeOfImpact ) {
+					// Static contact
+					m_manifolds.AddContact( contact );
+					m_stepStats.numStaticContacts++;
+				} else {
+					// Ballistic contact
+					contacts[ numContacts ] = contact;
+					numContacts++;
+				}
+			}
 		}
-		m_manifolds.Solve();
+		g_collisionStats = NULL;
+		m_midphase.EndUpdate();
 	}
 
-	for ( int i = 0; i < m_constraints.size(); i++ ) {
-		m_constraints[ i ]->PostSolve();
+	{
+		PROFILE_SCOPE( "SortContacts" );
+
+		// Sort the times of impact from first to last
+		if ( numContacts > 1 ) {
+			qsort( contacts, numContacts, sizeof( contact_t ), CompareContacts );
+		}
+
+		// Don't let the solve order depend on when each manifold was created
+		if ( m_isDeterministic ) {
+			m_manifolds.SortByBodies();
+		}
 	}
-	m_manifolds.PostSolve();
 
+	{
+		PROFILE_SCOPE( "BuildIslands" );
+		BuildIslands();
+	}
+	const double timeNarrowphase = GetTimeMicroseconds();
 
 	//
-	// Apply ballistic impulses
+	//	Solve constraints and integrate, either once for the whole step or in substeps.  Substeps
+	//	reuse the contacts from above, the manifolds recalculate their penetration from the anchors.
 	//
+	const int numSubsteps = isSubstepping ? m_numSubsteps : 1;
+	const float substep_sec = dt_sec / (float)numSubsteps;
+	m_solverContext.baumgarteScale = 1.0f / (float)numSubsteps;
+	m_solverContext.useSplitImpulse = m_useSplitImpulse;
+	m_solverContext.useBlockSolver = m_useBlockSolver;
+	m_solverContext.useManifoldFriction = m_useManifoldFriction;
+	m_solverContext.maxImpulseSqr = 0.0f;
+	m_solverContext.stats = &m_stepStats;
+	m_jointImpulses.assign( m_constraints.size(), Vec3( 0.0f ) );
+
+	double timeSolve = 0.0;
+	double timeIntegrate = 0.0;
+	int nextContact = 0;
 	float accumulatedTime = 0.0f;
-	for ( int i = 0; i < numContacts; i++ ) {
-		contact_t & contact = contacts[ i ];
-		const float dt = contact.timeOfImpact - accumulatedTime;
+	for ( int substep = 0; substep < numSubsteps; substep++ ) {
+		const double time0 = GetTimeMicroseconds();
 
-		// Position update
-		for ( int j = 0; j < m_bodies.size(); j++ ) {
-			m_bodies[ j ].Update( dt );
+		if ( isSubstepping ) {
+			ApplyGravity( substep_sec );
+		}
+		const bool isLastSubstep = ( substep == numSubsteps - 1 );
+		SolveConstraints( substep_sec, m_numIterations, isLastSubstep );
+		const double time1 = GetTimeMicroseconds();
+
+		const float endTime = isLastSubstep ? dt_sec : substep_sec * (float)( substep + 1 );
+		Integrate( contacts, numContacts, nextContact, accumulatedTime, endTime, isLastSubstep );
+		if ( m_useSplitImpulse ) {
+			ApplyPseudoVelocities( substep_sec );
 		}
+		const double time2 = GetTimeMicroseconds();
 
-		ResolveContact( contact );
-		accumulatedTime += dt;
+		timeSolve += time1 - time0;
+		timeIntegrate += time2 - time1;
 	}
 
-	// Update the positions for the rest of this frame's time
-	const float timeRemaining = dt_sec - accumulatedTime;
-	if ( timeRemaining > 0.0f ) {
-		for ( int i = 0; i < m_bodies.size(); i++ ) {
-			m_bodies[ i ].Update( timeRemaining );
-		}
+	if ( m_isDeterministic ) {
+		m_stateHash = GetStateHash();
+	}
+
+	m_stepStats.numBallisticContacts = numContacts;
+	RecordStats();
+
+	m_timings.broadphase = (float)( timeBroadphase - timeStart );
+	m_timings.narrowphase = (float)( timeNarrowphase - timeBroadphase );
+	m_timings.solve = (float)timeSolve;
+	m_timings.integrate = (float)timeIntegrate;
+	m_timings.total = (float)( GetTimeMicroseconds() - timeStart );
+}
+
+/*
+====================================================
+HashFloats
+FNV-1a over the bit patterns, so that -0 and +0 or different NaNs hash differently
+====================================================
+*/
+static unsigned long long HashFloats( unsigned long long hash, const float * values, const int num ) {
+	const unsigned char * bytes = (const unsigned char *)values;
+	for ( int i = 0; i < num * (int)sizeof( float ); i++ ) {
+		hash ^= bytes[ i ];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/*
+====================================================
+Scene::GetStateHash
+====================================================
+*/
+unsigned long long Scene::GetStateHash() const {
+	unsigned long long hash = 14695981039346656037ULL;
+	for ( int i = 0; i < m_bodies.size(); i++ ) {
+		const Body & body = m_bodies[ i ];
+		const float state[ 13 ] = {
+			body.m_position.x, body.m_position.y, body.m_position.z,
+			body.m_orientation.w, body.m_orientation.x, body.m_orientation.y, body.m_orientation.z,
+			body.m_linearVelocity.x, body.m_linearVelocity.y, body.m_linearVelocity.z,
+			body.m_angularVelocity.x, body.m_angularVelocity.y, body.m_angularVelocity.z,
+		};
+		hash = HashFloats( hash, state, 13 );
 	}
+	return hash;
 }
\ No newline at end of file
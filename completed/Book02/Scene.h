@@ -2,12 +2,65 @@
 //  Scene.h
 //
 #pragma once
+#include <stdio.h>
 #include <vector>
 
 #include "Physics/Shapes.h"
 #include "Physics/Body.h"
 #include "Physics/Constraints.h"
+#include "Physics/ConstraintPool.h"
 #include "Physics/Manifold.h"
+#include "Physics/JointTree.h"
+#include "Physics/Stats.h"
+#include "Physics/Broadphase.h"
+#include "Physics/Midphase.h"
+#include "Physics/BoundsTree.h"
+#include "Physics/Queries.h"
+
+/*
+====================================================
+sceneTimings_t
+Time spent in each phase of the last Scene::Update, in microseconds
+====================================================
+*/
+struct sceneTimings_t {
+	float broadphase;	// expiring old contacts, gravity and the broadphase
+	float narrowphase;	// collision detection, sorting the contacts and building islands
+	float solve;		// constraints and manifolds
+	float integrate;	// ballistic contacts and position updates
+	float total;
+};
+
+/*
+====================================================
+island_t
+Bodies connected through constraints and contacts, solved independently of every other island.
+The ranges index Scene's island body, constraint and manifold lists.
+====================================================
+*/
+struct island_t {
+	int firstBody;
+	int numBodies;
+	int firstConstraint;
+	int numConstraints;
+	int firstManifold;
+	int numManifolds;
+};
+
+/*
+====================================================
+constraintBreak_t
+A joint that broke during an update.  It has already been removed by the time the update
+returns, the handle is for matching it against the handles kept when joints were created.
+====================================================
+*/
+struct constraintBreak_t {
+	constraintHandle_t handle;
+	Constraint::constraintType_t type;
+	Body * bodyA;
+	Body * bodyB;
+	float impulse;		// length of the accumulated impulse that broke it
+};
 
 /*
 ====================================================
@@ -16,15 +69,164 @@ Scene
 */
 class Scene {
 public:
-	Scene() { m_bodies.reserve( 128 ); }
+	Scene() : m_numIterations( 5 ), m_numSubsteps( 1 ), m_useSplitImpulse( false ), m_numPositionIterations( 20 ), m_useBlockSolver( false ), m_useManifoldFriction( false ), m_useDirectJointSolver( false ), m_useMidphase( true ), m_solverTolerance( 0.0f ), m_maxIterations( 20 ), m_isDeterministic( false ), m_stateHash( 0 ), m_timings(), m_stats(), m_numQueryThreads( 0 ), m_numSteps( 0 ), m_queryTreeStep( -1 ), m_queryTreeNumBodies( 0 ), m_isQueryingStaticTree( false ) {
+		m_bodies.reserve( 128 );
+		m_statsHistory.resize( STATS_HISTORY_SIZE );
+	}
 	~Scene();
 
 	void Reset();
+	void Clear();
 	void Initialize();
 	void Update( const float dt_sec );	
 
+	bool Save( const char * fileName ) const;
+	bool Load( const char * fileName );
+
+	// Snapshot of the dynamic state (bodies, manifolds and constraint accumulators) into a flat buffer
+	int GetSnapshotSize( const int maxManifolds ) const;
+	int SaveSnapshot( void * buffer, const int size ) const;
+	bool RestoreSnapshot( const void * buffer, const int size );
+
+	// Hash of the position, orientation and velocity of every body
+	unsigned long long GetStateHash() const;
+
+	// Copies the stats of the most recent updates, oldest first, and returns how many were copied
+	int GetStatsHistory( physicsStats_t * stats, const int maxSteps ) const;
+
+	// Writes the stats of the most recent updates as one line per step
+	void DumpStats( FILE * file, const int maxSteps ) const;
+
+	// Ray and shape casts against the bodies where the last update left them (see SceneQueries.cpp).
+	// Each returns the number of hits written to hits, at most maxHits.  Only bodies in one of the
+	// layers in layerMask are hit.
+	int CastRay( const rayCast_t & ray, const queryMode_t mode, queryHit_t * hits, const int maxHits, const unsigned int layerMask = ~0u ) const;
+	int CastShape( const shapeCast_t & cast, const queryMode_t mode, queryHit_t * hits, const int maxHits, const unsigned int layerMask = ~0u ) const;
+
+	// Batches of casts, split over m_numQueryThreads threads.  Query i writes its hits from
+	// hits + i * maxHits and how many it found to numHits[ i ].
+	void CastRays( const rayCast_t * rays, const int num, const queryMode_t mode, queryHit_t * hits, const int maxHits, int * numHits, const unsigned int layerMask = ~0u ) const;
+	void CastShapes( const shapeCast_t * casts, const int num, const queryMode_t mode, queryHit_t * hits, const int maxHits, int * numHits, const unsigned int layerMask = ~0u ) const;
+
+	// Overlap queries, for trigger volumes and blast radii.  Each writes the indices of the bodies
+	// in one of the layerMask layers that overlap the volume, and returns how many, at most maxBodies.
+	int OverlapBounds( const Bounds & bounds, int * bodies, const int maxBodies, const unsigned int layerMask = ~0u ) const;
+	int OverlapSphere( const Vec3 & center, const float radius, int * bodies, const int maxBodies, const unsigned int layerMask = ~0u ) const;
+	int OverlapShape( const Shape * shape, const Vec3 & pos, const Quat & orient, int * bodies, const int maxBodies, const unsigned int layerMask = ~0u ) const;
+
+	// Rebuilds the tree of moving bodies the queries search, along with the broadphase's tree of
+	// static ones.  The queries rebuild it themselves after an update, call this after moving bodies
+	// by hand.  Not safe to call while another thread is querying.
+	void UpdateQueryTree() const;
+
 	std::vector< Body > m_bodies;
-	std::vector< Constraint * >	m_constraints;
+	ConstraintPool m_constraints;
 	ManifoldCollector m_manifolds;
+
+	// Joints with a break impulse that broke during the last update, in the order they broke.
+	// Constraints can be created and removed through m_constraints between updates.
+	std::vector< constraintBreak_t > m_brokenConstraints;
+
+	// Solver iterations per step, or per substep when substepping
+	int m_numIterations;
+
+	// More than one substep splits each update into smaller steps that each apply gravity,
+	// solve and integrate.  Broadphase and narrowphase still run once per update.  Many
+	// substeps of one iteration converge stacks and chains better than the same number of
+	// iterations in a single step.
+	int m_numSubsteps;
+
+	// Split impulse corrects penetration with pseudo velocities that move the bodies but are
+	// thrown away afterwards, instead of biasing the real velocities.  Resolving overlap this way
+	// doesn't add energy, so stacks settle without jitter.  Joints keep their Baumgarte bias,
+	// their velocity rows lose their grip on the anchors without it and chains drift apart.
+	// The position pass runs on each island until it settles, or m_numPositionIterations sweeps.
+	bool m_useSplitImpulse;
+	int m_numPositionIterations;
+
+	// Solves the normal impulses of each manifold's contacts together, so a box resting on its
+	// face gets consistent impulses at its corners instead of rocking between them
+	bool m_useBlockSolver;
+
+	// One friction constraint per manifold, at the centroid of its contacts with a twist row
+	// about the normal, instead of two friction rows on every contact.  Four contacts need
+	// seven rows instead of twelve.
+	bool m_useManifoldFriction;
+
+	// Solves the joints of chains and ragdolls exactly, with a sparse factorization over each
+	// island's joint tree (see JointTree), instead of one joint at a time.  Long chains hold
+	// together without extra iterations.  Joints that close a loop are still iterated.  Each
+	// iteration solves the trees and then the contacts, so contacts between linked bodies pull
+	// against the joints, joints that don't want them should set m_disableCollision.
+	bool m_useDirectJointSolver;
+
+	// Rejects pairs whose swept oriented boxes are apart before they reach GJK (see Midphase).
+	// It only skips pairs that can't touch, so turning it off changes the cost and nothing else.
+	bool m_useMidphase;
+
+	// Adaptive iterations.  Each island stops iterating as soon as an iteration applies no
+	// impulse larger than the tolerance, so resting islands cost little, and islands that are
+	// still converging keep going up to m_maxIterations.  A tolerance of zero turns this off
+	// and every island runs m_numIterations.
+	float m_solverTolerance;
+	int m_maxIterations;
+
+	// Deterministic mode solves manifolds in a canonical order and records the state hash
+	// after every update, so runs can be compared step by step to find where they diverge
+	bool m_isDeterministic;
+	unsigned long long m_stateHash;
+
+	sceneTimings_t m_timings;
+	physicsStats_t m_stats;	// counters from the last update
+
+	// Threads for the batched queries, zero uses every hardware thread
+	int m_numQueryThreads;
+
+	static const int STATS_HISTORY_SIZE = 256;
+
+private:
+	void ApplyGravity( const float dt_sec );
+	void BuildIslands();
+	void SolveConstraints( const float dt_sec, const int numIterations, const bool isLastSubstep );
+	void AccumulateJointImpulses();
+	void BreakConstraints();
+	void BuildExcludedPairs();
+	void Integrate( contact_t * contacts, const int numContacts, int & nextContact, float & accumulatedTime, const float endTime, const bool isLast );
+	void SolvePositions( const float dt_sec );
+	void ApplyPseudoVelocities( const float dt_sec );
+	void RecordStats();
+	void PrepareQueries() const;
+	int GetQueryTrees( const BoundsTree ** trees ) const;
+
+	std::vector< physicsStats_t > m_statsHistory;	// ring buffer indexed by step
+	physicsStats_t m_stepStats;			// counters of the update in progress, copied to m_stats by RecordStats
+	solverContext_t m_solverContext;	// the settings the constraints solve with during an update
+	int m_numSteps;
+
+	std::vector< Vec3 > m_solverVelocities;	// scratch for measuring the solver residual, and the position pass's
+
+	std::vector< island_t > m_islands;
+	std::vector< int > m_islandBodies;
+	std::vector< int > m_islandConstraints;
+	std::vector< int > m_islandManifolds;
+	std::vector< int > m_islandParent;	// union find scratch for BuildIslands
+
+	std::vector< JointTree > m_jointTrees;	// one per island with m_useDirectJointSolver
+	std::vector< Vec3 > m_jointImpulses;	// each joint's impulse summed over the substeps of an update
+	Broadphase m_broadphase;
+	Midphase m_midphase;
+	std::vector< collisionPair_t > m_collisionPairs;	// scratch for the broadphase
+	std::vector< collisionPair_t > m_excludedPairs;	// bodies joined by constraints with m_disableCollision
+
+	// Bounds of the moving bodies for the queries, rebuilt the first time they run after each update
+	mutable BoundsTree m_queryTree;
+	mutable std::vector< Bounds > m_queryBounds;
+	mutable std::vector< int > m_queryIds;
+	mutable int m_queryTreeStep;	// m_numSteps when the tree was built, -1 when it needs building
+	mutable int m_queryTreeNumBodies;
+	mutable bool m_isQueryingStaticTree;	// false when the static bodies changed since the broadphase built its tree, so m_queryTree holds them too
 };
 
+void AddStandardSandBox( std::vector< Body > & bodies );
+void AddRagdoll( std::vector< Body > & bodies, ConstraintPool & constraints, const Vec3 & offset );
+
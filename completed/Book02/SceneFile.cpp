@@ -0,0 +1,768 @@
+//
+//  SceneFile.cpp
+//
+#include "Scene.h"
+#include "Fileio.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+/*
+========================================================================================================
+
+Binary scene format
+
+	sceneFileHeader_t
+	chunk SHPS : numShapes x shape
+	shape      : sceneShapeRecord_t + numPoints x float[ 3 ] + numChildren x ( sceneChildRecord_t + shape )
+	             + numTriangles x int[ 3 ] + heightfields: sceneHeightfieldRecord_t + numX * numY x float
+	chunk BODY : numBodies x sceneBodyRecord_t
+	chunk CNST : numConstraints x sceneConstraintRecord_t
+
+A compound's children follow it, each shape nested in the compound that owns it.  A triangle mesh's
+points are its vertices, and its tree is rebuilt when it's loaded.  Bodies reference
+shapes by index into the shape table and constraints reference bodies by index
+into the body array.  Bodies and constraints are streamed through a small fixed size buffer, so
+saving/loading doesn't need a second copy of the whole scene in memory.
+
+========================================================================================================
+*/
+
+#define SCENE_FOURCC( a, b, c, d ) ( (unsigned int)(a) | ( (unsigned int)(b) << 8 ) | ( (unsigned int)(c) << 16 ) | ( (unsigned int)(d) << 24 ) )
+
+static const unsigned int SCENE_FILE_MAGIC		= SCENE_FOURCC( 'S', 'C', 'N', 'E' );
+static const unsigned int SCENE_FILE_VERSION	= 6;	// 2 added the constraints' break impulse, 3 collision filtering, 4 capsules and cylinders, 5 compounds, 6 triangle meshes and heightfields
+static const unsigned int SCENE_CHUNK_SHAPES	= SCENE_FOURCC( 'S', 'H', 'P', 'S' );
+static const unsigned int SCENE_CHUNK_BODIES	= SCENE_FOURCC( 'B', 'O', 'D', 'Y' );
+static const unsigned int SCENE_CHUNK_CONSTRAINTS	= SCENE_FOURCC( 'C', 'N', 'S', 'T' );
+
+static const int SCENE_STREAM_BATCH = 64;	// number of records read/written per file chunk
+
+struct sceneFileHeader_t {
+	unsigned int magic;
+	unsigned int version;
+};
+
+struct sceneChunk_t {
+	unsigned int id;
+	unsigned int count;
+};
+
+struct sceneShapeRecord_t {
+	int type;		// Shape::shapeType_t
+	int numPoints;	// number of float[ 3 ] points following this record
+	float radius;
+	float halfHeight;	// capsules and cylinders
+	int numChildren;	// compounds
+	int numTriangles;	// triangle meshes
+};
+
+struct sceneHeightfieldRecord_t {
+	int numX;
+	int numY;
+	float spacing;
+};
+
+struct sceneChildRecord_t {
+	float position[ 3 ];
+	float orientation[ 4 ];	// w, x, y, z
+	float mass;
+};
+
+struct sceneBodyRecord_t {
+	float position[ 3 ];
+	float orientation[ 4 ];	// w, x, y, z
+	float linearVelocity[ 3 ];
+	float angularVelocity[ 3 ];
+	float invMass;
+	float elasticity;
+	float friction;
+	int shape;				// index into the shape table
+	unsigned int collisionLayer;
+	unsigned int collisionMask;
+};
+
+struct sceneConstraintRecord_t {
+	int type;				// Constraint::constraintType_t
+	int bodyA;				// index into the body array
+	int bodyB;				// -1 for none, when the type doesn't need one (see NeedsBodyB)
+	float anchorA[ 3 ];
+	float axisA[ 3 ];
+	float anchorB[ 3 ];
+	float axisB[ 3 ];
+	float q0[ 4 ];			// w, x, y, z
+	float motorAxis[ 3 ];
+	float motorSpeed;
+	float time;
+	float breakImpulse;
+	int disableCollision;
+};
+
+/*
+====================================================
+Helpers for packing math types into records
+====================================================
+*/
+static void StoreVec3( float * dst, const Vec3 & v ) {
+	dst[ 0 ] = v.x;
+	dst[ 1 ] = v.y;
+	dst[ 2 ] = v.z;
+}
+
+static Vec3 LoadVec3( const float * src ) {
+	return Vec3( src[ 0 ], src[ 1 ], src[ 2 ] );
+}
+
+static void StoreQuat( float * dst, const Quat & q ) {
+	dst[ 0 ] = q.w;
+	dst[ 1 ] = q.x;
+	dst[ 2 ] = q.y;
+	dst[ 3 ] = q.z;
+}
+
+static Quat LoadQuat( const float * src ) {
+	return Quat( src[ 1 ], src[ 2 ], src[ 3 ], src[ 0 ] );
+}
+
+/*
+====================================================
+CloneShape
+====================================================
+*/
+static Shape * CloneShape( const Shape * shape ) {
+	switch ( shape->GetType() ) {
+		case Shape::SHAPE_SPHERE: return new ShapeSphere( *(const ShapeSphere *)shape );
+		case Shape::SHAPE_BOX: return new ShapeBox( *(const ShapeBox *)shape );
+		case Shape::SHAPE_CONVEX: return new ShapeConvex( *(const ShapeConvex *)shape );
+		case Shape::SHAPE_CAPSULE: return new ShapeCapsule( *(const ShapeCapsule *)shape );
+		case Shape::SHAPE_CYLINDER: return new ShapeCylinder( *(const ShapeCylinder *)shape );
+		case Shape::SHAPE_COMPOUND: {
+			// The compound owns its children, so they're cloned too
+			std::vector< compoundChild_t > children = ( (const ShapeCompound *)shape )->m_children;
+			for ( int i = 0; i < children.size(); i++ ) {
+				children[ i ].shape = CloneShape( children[ i ].shape );
+			}
+			return new ShapeCompound( children.data(), (int)children.size() );
+		}
+		case Shape::SHAPE_TRIANGLE_MESH: return new ShapeTriangleMesh( *(const ShapeTriangleMesh *)shape );
+		case Shape::SHAPE_HEIGHTFIELD: return new ShapeHeightfield( *(const ShapeHeightfield *)shape );
+		case Shape::SHAPE_TRIANGLE: break;	// only made on the fly by the mesh queries, never a body's shape
+	}
+	return NULL;
+}
+
+/*
+====================================================
+WriteShape
+====================================================
+*/
+static bool WriteShape( fileStream_t & stream, const Shape * shape ) {
+	sceneShapeRecord_t record;
+	record.type = shape->GetType();
+	record.numPoints = 0;
+	record.radius = 0.0f;
+	record.halfHeight = 0.0f;
+	record.numChildren = 0;
+	record.numTriangles = 0;
+
+	const std::vector< Vec3 > * points = NULL;
+	switch ( shape->GetType() ) {
+		case Shape::SHAPE_SPHERE: {
+			record.radius = ( (const ShapeSphere *)shape )->m_radius;
+		} break;
+		case Shape::SHAPE_BOX: {
+			points = &( (const ShapeBox *)shape )->m_points;
+		} break;
+		case Shape::SHAPE_CONVEX: {
+			points = &( (const ShapeConvex *)shape )->m_points;
+		} break;
+		case Shape::SHAPE_CAPSULE: {
+			record.radius = ( (const ShapeCapsule *)shape )->m_radius;
+			record.halfHeight = ( (const ShapeCapsule *)shape )->m_halfHeight;
+		} break;
+		case Shape::SHAPE_CYLINDER: {
+			record.radius = ( (const ShapeCylinder *)shape )->m_radius;
+			record.halfHeight = ( (const ShapeCylinder *)shape )->m_halfHeight;
+		} break;
+		case Shape::SHAPE_COMPOUND: {
+			record.numChildren = (int)( (const ShapeCompound *)shape )->m_children.size();
+		} break;
+		case Shape::SHAPE_TRIANGLE_MESH: {
+			points = &( (const ShapeTriangleMesh *)shape )->m_verts;
+			record.numTriangles = ( (const ShapeTriangleMesh *)shape )->GetNumTriangles();
+		} break;
+		case Shape::SHAPE_HEIGHTFIELD: break;	// written after the record
+		case Shape::SHAPE_TRIANGLE: {
+			printf( "ERROR: scene shape type %i can't be saved\n", record.type );
+			return false;
+		}
+	}
+	if ( NULL != points ) {
+		record.numPoints = (int)points->size();
+	}
+
+	if ( !WriteFileChunk( stream, &record, sizeof( record ) ) ) {
+		return false;
+	}
+
+	for ( int i = 0; i < record.numPoints; i++ ) {
+		float pt[ 3 ];
+		StoreVec3( pt, ( *points )[ i ] );
+		if ( !WriteFileChunk( stream, pt, sizeof( pt ) ) ) {
+			return false;
+		}
+	}
+
+	for ( int i = 0; i < record.numChildren; i++ ) {
+		const compoundChild_t & child = ( (const ShapeCompound *)shape )->m_children[ i ];
+		sceneChildRecord_t childRecord;
+		StoreVec3( childRecord.position, child.position );
+		StoreQuat( childRecord.orientation, child.orientation );
+		childRecord.mass = child.mass;
+		if ( !WriteFileChunk( stream, &childRecord, sizeof( childRecord ) ) || !WriteShape( stream, child.shape ) ) {
+			return false;
+		}
+	}
+
+	if ( record.numTriangles > 0 ) {
+		const std::vector< unsigned int > & indices = ( (const ShapeTriangleMesh *)shape )->m_indices;
+		if ( !WriteFileChunk( stream, indices.data(), (unsigned int)( indices.size() * sizeof( unsigned int ) ) ) ) {
+			return false;
+		}
+	}
+
+	if ( Shape::SHAPE_HEIGHTFIELD == record.type ) {
+		const ShapeHeightfield * heightfield = (const ShapeHeightfield *)shape;
+		sceneHeightfieldRecord_t heightfieldRecord;
+		heightfieldRecord.numX = heightfield->m_numX;
+		heightfieldRecord.numY = heightfield->m_numY;
+		heightfieldRecord.spacing = heightfield->m_spacing;
+		std::vector< float > heights( heightfield->m_numX * heightfield->m_numY );
+		for ( int y = 0; y < heightfield->m_numY; y++ ) {
+			for ( int x = 0; x < heightfield->m_numX; x++ ) {
+				heights[ y * heightfield->m_numX + x ] = heightfield->GetHeight( x, y );
+			}
+		}
+		if ( !WriteFileChunk( stream, &heightfieldRecord, sizeof( heightfieldRecord ) ) ||
+			!WriteFileChunk( stream, heights.data(), (unsigned int)( heights.size() * sizeof( float ) ) ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+====================================================
+IsCountInFile
+Counts are checked against what's left of the file before anything is allocated for them, so a
+damaged file fails to load instead of asking for gigabytes
+====================================================
+*/
+static bool IsCountInFile( const fileStream_t & stream, const unsigned int count, const unsigned int recordSize, const char * what ) {
+	if ( count > GetFileStreamRemaining( stream ) / recordSize ) {
+		printf( "ERROR: scene file is too short for %u %s\n", count, what );
+		return false;
+	}
+	return true;
+}
+
+static Shape * ReadShape( fileStream_t & stream );
+
+/*
+====================================================
+ReadCompound
+====================================================
+*/
+static Shape * ReadCompound( fileStream_t & stream, const int numChildren ) {
+	if ( numChildren <= 0 ) {
+		printf( "ERROR: scene compound shape has no children\n" );
+		return NULL;
+	}
+	if ( !IsCountInFile( stream, numChildren, sizeof( sceneChildRecord_t ) + sizeof( sceneShapeRecord_t ), "compound children" ) ) {
+		return NULL;
+	}
+
+	std::vector< compoundChild_t > children;
+	for ( int i = 0; i < numChildren; i++ ) {
+		sceneChildRecord_t childRecord;
+		compoundChild_t child;
+		child.shape = NULL;
+		if ( ReadFileChunk( stream, &childRecord, sizeof( childRecord ) ) ) {
+			child.shape = ReadShape( stream );
+		}
+		if ( NULL == child.shape ) {
+			for ( int j = 0; j < children.size(); j++ ) {
+				delete children[ j ].shape;
+			}
+			return NULL;
+		}
+
+		child.position = LoadVec3( childRecord.position );
+		child.orientation = LoadQuat( childRecord.orientation );
+		child.mass = childRecord.mass;
+		children.push_back( child );
+	}
+	return new ShapeCompound( children.data(), numChildren );
+}
+
+/*
+====================================================
+ReadShape
+====================================================
+*/
+static Shape * ReadShape( fileStream_t & stream ) {
+	sceneShapeRecord_t record;
+	if ( !ReadFileChunk( stream, &record, sizeof( record ) ) ) {
+		return NULL;
+	}
+
+	if ( Shape::SHAPE_SPHERE == record.type ) {
+		return new ShapeSphere( record.radius );
+	}
+	if ( Shape::SHAPE_CAPSULE == record.type ) {
+		return new ShapeCapsule( record.radius, record.halfHeight );
+	}
+	if ( Shape::SHAPE_CYLINDER == record.type ) {
+		return new ShapeCylinder( record.radius, record.halfHeight );
+	}
+	if ( Shape::SHAPE_COMPOUND == record.type ) {
+		return ReadCompound( stream, record.numChildren );
+	}
+	if ( Shape::SHAPE_HEIGHTFIELD == record.type ) {
+		sceneHeightfieldRecord_t heightfieldRecord;
+		if ( !ReadFileChunk( stream, &heightfieldRecord, sizeof( heightfieldRecord ) ) ) {
+			return NULL;
+		}
+		if ( heightfieldRecord.numX < 2 || heightfieldRecord.numY < 2 ) {
+			printf( "ERROR: scene heightfield is smaller than a cell\n" );
+			return NULL;
+		}
+		if ( !IsCountInFile( stream, heightfieldRecord.numY, sizeof( float ), "heightfield rows" ) ||
+			!IsCountInFile( stream, heightfieldRecord.numX, sizeof( float ) * heightfieldRecord.numY, "heightfield columns" ) ) {
+			return NULL;
+		}
+		std::vector< float > heights( heightfieldRecord.numX * heightfieldRecord.numY );
+		if ( !ReadFileChunk( stream, heights.data(), (unsigned int)( heights.size() * sizeof( float ) ) ) ) {
+			return NULL;
+		}
+		return new ShapeHeightfield( heights.data(), heightfieldRecord.numX, heightfieldRecord.numY, heightfieldRecord.spacing );
+	}
+
+	if ( record.numPoints <= 0 ) {
+		printf( "ERROR: scene shape has no points\n" );
+		return NULL;
+	}
+	if ( !IsCountInFile( stream, record.numPoints, sizeof( float ) * 3, "points" ) ) {
+		return NULL;
+	}
+
+	std::vector< Vec3 > points( record.numPoints );
+	for ( int i = 0; i < record.numPoints; i++ ) {
+		float pt[ 3 ];
+		if ( !ReadFileChunk( stream, pt, sizeof( pt ) ) ) {
+			return NULL;
+		}
+		points[ i ] = LoadVec3( pt );
+	}
+
+	if ( Shape::SHAPE_TRIANGLE_MESH == record.type ) {
+		if ( record.numTriangles <= 0 ) {
+			printf( "ERROR: scene triangle mesh has no triangles\n" );
+			return NULL;
+		}
+		if ( !IsCountInFile( stream, record.numTriangles, sizeof( int ) * 3, "triangles" ) ) {
+			return NULL;
+		}
+		std::vector< int > indices( record.numTriangles * 3 );
+		if ( !ReadFileChunk( stream, indices.data(), (unsigned int)( indices.size() * sizeof( int ) ) ) ) {
+			return NULL;
+		}
+		for ( int i = 0; i < indices.size(); i++ ) {
+			if ( indices[ i ] < 0 || indices[ i ] >= record.numPoints ) {
+				printf( "ERROR: scene triangle mesh index %i is out of range\n", indices[ i ] );
+				return NULL;
+			}
+		}
+		return new ShapeTriangleMesh( points.data(), record.numPoints, indices.data(), record.numTriangles );
+	}
+
+	switch ( record.type ) {
+		case Shape::SHAPE_BOX: return new ShapeBox( points.data(), record.numPoints );
+		case Shape::SHAPE_CONVEX: return new ShapeConvex( points.data(), record.numPoints );
+	}
+
+	printf( "ERROR: unknown scene shape type %i\n", record.type );
+	return NULL;
+}
+
+/*
+====================================================
+NeedsBodyB
+Every constraint needs body A.  The simple mover drives its body along a path of its own and has no
+second body, all the others join two.
+====================================================
+*/
+static bool NeedsBodyB( const int type ) {
+	return ( Constraint::CONSTRAINT_MOVER_SIMPLE != type );
+}
+
+/*
+====================================================
+Scene::Save
+====================================================
+*/
+bool Scene::Save( const char * fileName ) const {
+	// Checked before the file is opened, so a scene that can't be saved doesn't replace the file
+	for ( int i = 0; i < m_constraints.size(); i++ ) {
+		const Constraint * constraint = m_constraints[ i ];
+		if ( NULL == constraint->m_bodyA || ( NULL == constraint->m_bodyB && NeedsBodyB( constraint->GetType() ) ) ) {
+			printf( "ERROR: scene constraint %i is missing a body\n", i );
+			return false;
+		}
+	}
+
+	fileStream_t stream;
+	if ( !OpenFileStream( fileName, stream, true ) ) {
+		return false;
+	}
+
+	bool result = true;
+
+	sceneFileHeader_t header;
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+	result = result && WriteFileChunk( stream, &header, sizeof( header ) );
+
+	//
+	//	Shape table
+	//
+	std::map< const Shape *, int > shapeIndices;
+	std::vector< const Shape * > shapes;
+	for ( int i = 0; i < m_bodies.size(); i++ ) {
+		const Shape * shape = m_bodies[ i ].m_shape;
+		if ( shapeIndices.find( shape ) == shapeIndices.end() ) {
+			shapeIndices[ shape ] = (int)shapes.size();
+			shapes.push_back( shape );
+		}
+	}
+
+	sceneChunk_t chunk;
+	chunk.id = SCENE_CHUNK_SHAPES;
+	chunk.count = (unsigned int)shapes.size();
+	result = result && WriteFileChunk( stream, &chunk, sizeof( chunk ) );
+	for ( int i = 0; i < shapes.size() && result; i++ ) {
+		result = WriteShape( stream, shapes[ i ] );
+	}
+
+	//
+	//	Bodies
+	//
+	sceneBodyRecord_t bodyRecords[ SCENE_STREAM_BATCH ];
+
+	chunk.id = SCENE_CHUNK_BODIES;
+	chunk.count = (unsigned int)m_bodies.size();
+	result = result && WriteFileChunk( stream, &chunk, sizeof( chunk ) );
+	for ( int i = 0; i < m_bodies.size() && result; i += SCENE_STREAM_BATCH ) {
+		const int num = std::min( SCENE_STREAM_BATCH, (int)m_bodies.size() - i );
+		for ( int j = 0; j < num; j++ ) {
+			const Body & body = m_bodies[ i + j ];
+			sceneBodyRecord_t & record = bodyRecords[ j ];
+
+			StoreVec3( record.position, body.m_position );
+			StoreQuat( record.orientation, body.m_orientation );
+			StoreVec3( record.linearVelocity, body.m_linearVelocity );
+			StoreVec3( record.angularVelocity, body.m_angularVelocity );
+			record.invMass = body.m_invMass;
+			record.elasticity = body.m_elasticity;
+			record.friction = body.m_friction;
+			record.shape = shapeIndices[ body.m_shape ];
+			record.collisionLayer = body.m_collisionLayer;
+			record.collisionMask = body.m_collisionMask;
+		}
+		result = WriteFileChunk( stream, bodyRecords, sizeof( sceneBodyRecord_t ) * num );
+	}
+
+	//
+	//	Constraints
+	//
+	sceneConstraintRecord_t constraintRecords[ SCENE_STREAM_BATCH ];
+	const Body * firstBody = m_bodies.data();
+
+	chunk.id = SCENE_CHUNK_CONSTRAINTS;
+	chunk.count = (unsigned int)m_constraints.size();
+	result = result && WriteFileChunk( stream, &chunk, sizeof( chunk ) );
+	for ( int i = 0; i < m_constraints.size() && result; i += SCENE_STREAM_BATCH ) {
+		const int num = std::min( SCENE_STREAM_BATCH, (int)m_constraints.size() - i );
+		for ( int j = 0; j < num; j++ ) {
+			const Constraint * constraint = m_constraints[ i + j ];
+			sceneConstraintRecord_t & record = constraintRecords[ j ];
+			memset( &record, 0, sizeof( record ) );
+
+			record.type = constraint->GetType();
+			record.bodyA = (int)( constraint->m_bodyA - firstBody );
+			record.bodyB = ( NULL != constraint->m_bodyB ) ? (int)( constraint->m_bodyB - firstBody ) : -1;
+			StoreVec3( record.anchorA, constraint->m_anchorA );
+			StoreVec3( record.axisA, constraint->m_axisA );
+			StoreVec3( record.anchorB, constraint->m_anchorB );
+			StoreVec3( record.axisB, constraint->m_axisB );
+			StoreQuat( record.q0, Quat( 0, 0, 0, 1 ) );
+			record.breakImpulse = constraint->m_breakImpulse;
+			record.disableCollision = constraint->m_disableCollision ? 1 : 0;
+
+			switch ( constraint->GetType() ) {
+				case Constraint::CONSTRAINT_HINGE_QUAT: {
+					StoreQuat( record.q0, ( (const ConstraintHingeQuat *)constraint )->q0 );
+				} break;
+				case Constraint::CONSTRAINT_HINGE_QUAT_LIMITED: {
+					StoreQuat( record.q0, ( (const ConstraintHingeQuatLimited *)constraint )->m_q0 );
+				} break;
+				case Constraint::CONSTRAINT_CONSTANT_VELOCITY: {
+					StoreQuat( record.q0, ( (const ConstraintConstantVelocity *)constraint )->m_q0 );
+				} break;
+				case Constraint::CONSTRAINT_CONSTANT_VELOCITY_LIMITED: {
+					StoreQuat( record.q0, ( (const ConstraintConstantVelocityLimited *)constraint )->m_q0 );
+				} break;
+				case Constraint::CONSTRAINT_MOTOR: {
+					const ConstraintMotor * motor = (const ConstraintMotor *)constraint;
+					StoreQuat( record.q0, motor->m_q0 );
+					StoreVec3( record.motorAxis, motor->m_motorAxis );
+					record.motorSpeed = motor->m_motorSpeed;
+				} break;
+				case Constraint::CONSTRAINT_MOVER_SIMPLE: {
+					record.time = ( (const ConstraintMoverSimple *)constraint )->m_time;
+				} break;
+				case Constraint::CONSTRAINT_ORIENTATION: {
+					StoreQuat( record.q0, ( (const ConstraintOrientation *)constraint )->m_q0 );
+				} break;
+				default: break;
+			}
+		}
+		result = result && WriteFileChunk( stream, constraintRecords, sizeof( sceneConstraintRecord_t ) * num );
+	}
+
+	CloseFileStream( stream );
+
+	if ( !result ) {
+		printf( "ERROR: failed to save scene %s\n", fileName );
+		RemoveFile( fileName );
+	}
+	return result;
+}
+
+/*
+====================================================
+CreateConstraint
+====================================================
+*/
+static Constraint * CreateConstraint( ConstraintPool & constraints, const sceneConstraintRecord_t & record ) {
+	const Quat q0 = LoadQuat( record.q0 );
+
+	switch ( record.type ) {
+		case Constraint::CONSTRAINT_DISTANCE: {
+			return constraints.Create< ConstraintDistance >();
+		}
+		case Constraint::CONSTRAINT_HINGE_QUAT: {
+			ConstraintHingeQuat * joint = constraints.Create< ConstraintHingeQuat >();
+			joint->q0 = q0;
+			return joint;
+		}
+		case Constraint::CONSTRAINT_HINGE_QUAT_LIMITED: {
+			ConstraintHingeQuatLimited * joint = constraints.Create< ConstraintHingeQuatLimited >();
+			joint->m_q0 = q0;
+			return joint;
+		}
+		case Constraint::CONSTRAINT_CONSTANT_VELOCITY: {
+			ConstraintConstantVelocity * joint = constraints.Create< ConstraintConstantVelocity >();
+			joint->m_q0 = q0;
+			return joint;
+		}
+		case Constraint::CONSTRAINT_CONSTANT_VELOCITY_LIMITED: {
+			ConstraintConstantVelocityLimited * joint = constraints.Create< ConstraintConstantVelocityLimited >();
+			joint->m_q0 = q0;
+			return joint;
+		}
+		case Constraint::CONSTRAINT_MOTOR: {
+			ConstraintMotor * joint = constraints.Create< ConstraintMotor >();
+			joint->m_q0 = q0;
+			joint->m_motorAxis = LoadVec3( record.motorAxis );
+			joint->m_motorSpeed = record.motorSpeed;
+			return joint;
+		}
+		case Constraint::CONSTRAINT_MOVER_SIMPLE: {
+			ConstraintMoverSimple * mover = constraints.Create< ConstraintMoverSimple >();
+			mover->m_time = record.time;
+			return mover;
+		}
+		case Constraint::CONSTRAINT_ORIENTATION: {
+			ConstraintOrientation * joint = constraints.Create< ConstraintOrientation >();
+			joint->m_q0 = q0;
+			return joint;
+		}
+	}
+
+	printf( "ERROR: unsupported scene constraint type %i\n", record.type );
+	return NULL;
+}
+
+/*
+====================================================
+ReadChunkHeader
+====================================================
+*/
+static bool ReadChunkHeader( fileStream_t & stream, const unsigned int id, unsigned int & count ) {
+	sceneChunk_t chunk;
+	if ( !ReadFileChunk( stream, &chunk, sizeof( chunk ) ) ) {
+		return false;
+	}
+	if ( chunk.id != id ) {
+		printf( "ERROR: unexpected scene chunk %08x (expected %08x)\n", chunk.id, id );
+		return false;
+	}
+	count = chunk.count;
+	return true;
+}
+
+/*
+====================================================
+Scene::Load
+Replaces the current scene with the one stored in the file
+====================================================
+*/
+bool Scene::Load( const char * fileName ) {
+	fileStream_t stream;
+	if ( !OpenFileStream( fileName, stream, false ) ) {
+		return false;
+	}
+
+	Clear();
+
+	bool result = true;
+
+	sceneFileHeader_t header;
+	result = ReadFileChunk( stream, &header, sizeof( header ) );
+	if ( result && ( header.magic != SCENE_FILE_MAGIC || header.version != SCENE_FILE_VERSION ) ) {
+		printf( "ERROR: not a scene file, or unsupported version %u\n", header.version );
+		result = false;
+	}
+
+	//
+	//	Shape table
+	//
+	unsigned int numShapes = 0;
+	result = result && ReadChunkHeader( stream, SCENE_CHUNK_SHAPES, numShapes );
+	result = result && IsCountInFile( stream, numShapes, sizeof( sceneShapeRecord_t ), "shapes" );
+
+	std::vector< Shape * > shapes;
+	std::vector< bool > isShapeOwned;
+	if ( result ) {
+		shapes.reserve( numShapes );
+	}
+	for ( unsigned int i = 0; i < numShapes && result; i++ ) {
+		Shape * shape = ReadShape( stream );
+		result = ( NULL != shape );
+		if ( result ) {
+			shapes.push_back( shape );
+			isShapeOwned.push_back( false );
+		}
+	}
+
+	//
+	//	Bodies
+	//	The body pool is sized up front so that constraint body pointers stay valid
+	//
+	unsigned int numBodies = 0;
+	result = result && ReadChunkHeader( stream, SCENE_CHUNK_BODIES, numBodies );
+	result = result && IsCountInFile( stream, numBodies, sizeof( sceneBodyRecord_t ), "bodies" );
+	if ( result ) {
+		m_bodies.reserve( numBodies );
+	}
+
+	sceneBodyRecord_t bodyRecords[ SCENE_STREAM_BATCH ];
+	for ( unsigned int i = 0; i < numBodies && result; i += SCENE_STREAM_BATCH ) {
+		const int num = std::min( SCENE_STREAM_BATCH, (int)( numBodies - i ) );
+		result = ReadFileChunk( stream, bodyRecords, sizeof( sceneBodyRecord_t ) * num );
+
+		for ( int j = 0; j < num && result; j++ ) {
+			const sceneBodyRecord_t & record = bodyRecords[ j ];
+			if ( record.shape < 0 || record.shape >= (int)shapes.size() ) {
+				printf( "ERROR: scene body %u references invalid shape %i\n", i + j, record.shape );
+				result = false;
+				break;
+			}
+
+			Body body;
+			body.m_position = LoadVec3( record.position );
+			body.m_orientation = LoadQuat( record.orientation );
+			body.m_linearVelocity = LoadVec3( record.linearVelocity );
+			body.m_angularVelocity = LoadVec3( record.angularVelocity );
+			body.m_invMass = record.invMass;
+			body.m_elasticity = record.elasticity;
+			body.m_friction = record.friction;
+			body.m_collisionLayer = record.collisionLayer;
+			body.m_collisionMask = record.collisionMask;
+
+			// Every body owns its shape, so any shared entries get duplicated
+			if ( !isShapeOwned[ record.shape ] ) {
+				body.m_shape = shapes[ record.shape ];
+				isShapeOwned[ record.shape ] = true;
+			} else {
+				body.m_shape = CloneShape( shapes[ record.shape ] );
+			}
+			m_bodies.push_back( body );
+		}
+	}
+
+	for ( int i = 0; i < shapes.size(); i++ ) {
+		if ( !isShapeOwned[ i ] ) {
+			delete shapes[ i ];
+		}
+	}
+
+	//
+	//	Constraints
+	//
+	unsigned int numConstraints = 0;
+	result = result && ReadChunkHeader( stream, SCENE_CHUNK_CONSTRAINTS, numConstraints );
+	result = result && IsCountInFile( stream, numConstraints, sizeof( sceneConstraintRecord_t ), "constraints" );
+
+	sceneConstraintRecord_t constraintRecords[ SCENE_STREAM_BATCH ];
+	for ( unsigned int i = 0; i < numConstraints && result; i += SCENE_STREAM_BATCH ) {
+		const int num = std::min( SCENE_STREAM_BATCH, (int)( numConstraints - i ) );
+		result = ReadFileChunk( stream, constraintRecords, sizeof( sceneConstraintRecord_t ) * num );
+
+		for ( int j = 0; j < num && result; j++ ) {
+			const sceneConstraintRecord_t & record = constraintRecords[ j ];
+			const bool isBodyAValid = ( record.bodyA >= 0 && record.bodyA < (int)m_bodies.size() );
+			const bool isBodyBValid = ( record.bodyB >= 0 && record.bodyB < (int)m_bodies.size() ) || ( -1 == record.bodyB && !NeedsBodyB( record.type ) );
+			if ( !isBodyAValid || !isBodyBValid ) {
+				printf( "ERROR: scene constraint %u references invalid bodies\n", i + j );
+				result = false;
+				break;
+			}
+
+			Constraint * constraint = CreateConstraint( m_constraints, record );
+			if ( NULL == constraint ) {
+				result = false;
+				break;
+			}
+
+			constraint->m_bodyA = &m_bodies[ record.bodyA ];
+			constraint->m_bodyB = ( record.bodyB >= 0 ) ? &m_bodies[ record.bodyB ] : NULL;
+			constraint->m_anchorA = LoadVec3( record.anchorA );
+			constraint->m_axisA = LoadVec3( record.axisA );
+			constraint->m_anchorB = LoadVec3( record.anchorB );
+			constraint->m_axisB = LoadVec3( record.axisB );
+			constraint->m_breakImpulse = record.breakImpulse;
+			constraint->m_disableCollision = ( 0 != record.disableCollision );
+		}
+	}
+
+	CloseFileStream( stream );
+
+	if ( !result ) {
+		printf( "ERROR: failed to load scene %s\n", fileName );
+		Clear();
+	}
+	return result;
+}
@@ -0,0 +1,203 @@
+//
+//  SceneIslands.cpp
+//
+#include "Scene.h"
+#include <string.h>
+#include <algorithm>
+
+/*
+========================================================================================================
+
+Scene islands
+
+Dynamic bodies that share a constraint or a contact manifold belong to the same island.  Static
+bodies don't join islands, nothing an island does can move them, so a stack on the ground and a
+ragdoll lying next to it are solved separately.  Bodies with nothing attached aren't in any island.
+
+========================================================================================================
+*/
+
+/*
+====================================================
+FindRoot
+====================================================
+*/
+static int FindRoot( std::vector< int > & parent, int idx ) {
+	while ( parent[ idx ] != idx ) {
+		parent[ idx ] = parent[ parent[ idx ] ];	// path halving
+		idx = parent[ idx ];
+	}
+	return idx;
+}
+
+/*
+====================================================
+DynamicBodyIndex
+====================================================
+*/
+static int DynamicBodyIndex( const Body * body, const Body * firstBody ) {
+	if ( NULL == body || 0.0f == body->m_invMass ) {
+		return -1;
+	}
+	return (int)( body - firstBody );
+}
+
+/*
+====================================================
+Scene::BuildIslands
+Manifolds keep their solve order within an island.  Constraints are grouped by type, keeping
+their order within a type, so the pool can solve each run of one type in a tight loop.
+====================================================
+*/
+void Scene::BuildIslands() {
+	const int numBodies = (int)m_bodies.size();
+	const int numManifolds = (int)m_manifolds.m_manifolds.size();
+	const Body * firstBody = m_bodies.data();
+
+	m_islands.clear();
+	m_islandBodies.clear();
+	m_islandConstraints.clear();
+	m_islandManifolds.clear();
+
+	m_islandParent.resize( numBodies );
+	for ( int i = 0; i < numBodies; i++ ) {
+		m_islandParent[ i ] = i;
+	}
+
+	//
+	//	Join the bodies of every constraint and manifold
+	//
+	for ( int i = 0; i < m_constraints.size(); i++ ) {
+		const int a = DynamicBodyIndex( m_constraints[ i ]->m_bodyA, firstBody );
+		const int b = DynamicBodyIndex( m_constraints[ i ]->m_bodyB, firstBody );
+		if ( a >= 0 && b >= 0 ) {
+			m_islandParent[ FindRoot( m_islandParent, a ) ] = FindRoot( m_islandParent, b );
+		}
+	}
+	for ( int i = 0; i < numManifolds; i++ ) {
+		const Manifold & manifold = m_manifolds.m_manifolds[ i ];
+		const int a = DynamicBodyIndex( manifold.GetBodyA(), firstBody );
+		const int b = DynamicBodyIndex( manifold.GetBodyB(), firstBody );
+		if ( a >= 0 && b >= 0 ) {
+			m_islandParent[ FindRoot( m_islandParent, a ) ] = FindRoot( m_islandParent, b );
+		}
+	}
+
+	//
+	//	Number the islands in the order they're first used.  Constraints and manifolds without
+	//	a dynamic body can't change anything, so they're left out.
+	//
+	std::vector< int > islandOfRoot( numBodies, -1 );
+	std::vector< int > constraintIsland( m_constraints.size(), -1 );
+	std::vector< int > manifoldIsland( numManifolds, -1 );
+	for ( int i = 0; i < m_constraints.size(); i++ ) {
+		int idx = DynamicBodyIndex( m_constraints[ i ]->m_bodyA, firstBody );
+		if ( idx < 0 ) {
+			idx = DynamicBodyIndex( m_constraints[ i ]->m_bodyB, firstBody );
+		}
+		if ( idx < 0 ) {
+			continue;
+		}
+		const int root = FindRoot( m_islandParent, idx );
+		if ( islandOfRoot[ root ] < 0 ) {
+			islandOfRoot[ root ] = (int)m_islands.size();
+			m_islands.push_back( island_t() );
+		}
+		constraintIsland[ i ] = islandOfRoot[ root ];
+	}
+	for ( int i = 0; i < numManifolds; i++ ) {
+		const int solveIdx = m_manifolds.GetSolveIndex( i );
+		const Manifold & manifold = m_manifolds.m_manifolds[ solveIdx ];
+		int idx = DynamicBodyIndex( manifold.GetBodyA(), firstBody );
+		if ( idx < 0 ) {
+			idx = DynamicBodyIndex( manifold.GetBodyB(), firstBody );
+		}
+		if ( idx < 0 ) {
+			continue;
+		}
+		const int root = FindRoot( m_islandParent, idx );
+		if ( islandOfRoot[ root ] < 0 ) {
+			islandOfRoot[ root ] = (int)m_islands.size();
+			m_islands.push_back( island_t() );
+		}
+		manifoldIsland[ i ] = islandOfRoot[ root ];
+	}
+
+	//
+	//	Count what's in each island, then lay the islands out one after the other
+	//
+	const int numIslands = (int)m_islands.size();
+	for ( int i = 0; i < numIslands; i++ ) {
+		memset( &m_islands[ i ], 0, sizeof( island_t ) );
+	}
+	std::vector< int > bodyIsland( numBodies, -1 );
+	for ( int i = 0; i < numBodies; i++ ) {
+		if ( DynamicBodyIndex( &m_bodies[ i ], firstBody ) < 0 ) {
+			continue;
+		}
+		bodyIsland[ i ] = islandOfRoot[ FindRoot( m_islandParent, i ) ];
+		if ( bodyIsland[ i ] >= 0 ) {
+			m_islands[ bodyIsland[ i ] ].numBodies++;
+		}
+	}
+	for ( int i = 0; i < constraintIsland.size(); i++ ) {
+		if ( constraintIsland[ i ] >= 0 ) {
+			m_islands[ constraintIsland[ i ] ].numConstraints++;
+		}
+	}
+	for ( int i = 0; i < numManifolds; i++ ) {
+		if ( manifoldIsland[ i ] >= 0 ) {
+			m_islands[ manifoldIsland[ i ] ].numManifolds++;
+		}
+	}
+
+	int numIslandBodies = 0;
+	int numIslandConstraints = 0;
+	int numIslandManifolds = 0;
+	for ( int i = 0; i < numIslands; i++ ) {
+		island_t & island = m_islands[ i ];
+		island.firstBody = numIslandBodies;
+		island.firstConstraint = numIslandConstraints;
+		island.firstManifold = numIslandManifolds;
+		numIslandBodies += island.numBodies;
+		numIslandConstraints += island.numConstraints;
+		numIslandManifolds += island.numManifolds;
+
+		// Reused as fill counters below
+		island.numBodies = 0;
+		island.numConstraints = 0;
+		island.numManifolds = 0;
+	}
+
+	m_islandBodies.resize( numIslandBodies );
+	m_islandConstraints.resize( numIslandConstraints );
+	m_islandManifolds.resize( numIslandManifolds );
+	for ( int i = 0; i < numBodies; i++ ) {
+		if ( bodyIsland[ i ] >= 0 ) {
+			island_t & island = m_islands[ bodyIsland[ i ] ];
+			m_islandBodies[ island.firstBody + island.numBodies++ ] = i;
+		}
+	}
+	for ( int i = 0; i < constraintIsland.size(); i++ ) {
+		if ( constraintIsland[ i ] >= 0 ) {
+			island_t & island = m_islands[ constraintIsland[ i ] ];
+			m_islandConstraints[ island.firstConstraint + island.numConstraints++ ] = i;
+		}
+	}
+	for ( int i = 0; i < numManifolds; i++ ) {
+		if ( manifoldIsland[ i ] >= 0 ) {
+			island_t & island = m_islands[ manifoldIsland[ i ] ];
+			m_islandManifolds[ island.firstManifold + island.numManifolds++ ] = m_manifolds.GetSolveIndex( i );
+		}
+	}
+
+	const ConstraintPool & constraints = m_constraints;
+	for ( int i = 0; i < numIslands; i++ ) {
+		int * first = m_islandConstraints.data() + m_islands[ i ].firstConstraint;
+		std::stable_sort( first, first + m_islands[ i ].numConstraints, [ &constraints ]( const int a, const int b ) {
+			return constraints.GetType( a ) < constraints.GetType( b );
+		} );
+	}
+
+	m_stepStats.numIslands = numIslands;
+}
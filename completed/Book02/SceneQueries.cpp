@@ -0,0 +1,344 @@
+//
+//  SceneQueries.cpp
+//
+#include "Scene.h"
+#include "Profiler.h"
+#include <thread>
+#include <algorithm>
+
+/*
+========================================================================================================
+
+Scene queries
+
+Ray and shape casts and overlap tests against the bodies.  The broadphase already keeps the static
+bodies in a BoundsTree that's only rebuilt when they change, so the queries search that one and
+keep a second, smaller tree over just the moving bodies' bounds.  It's rebuilt by the first query
+after an update, and every query until the next update shares it.  If static bodies were added,
+removed or moved since the broadphase last saw them, its tree is stale until the next update, and
+they go in the queries' tree with the rest.
+
+Casts narrow down the bodies with the tree, then test each one exactly (see Queries.cpp): spheres
+and boxes analytically, meshes and heightfields triangle by triangle, everything else with the GJK
+ray cast.  A closest hit query shortens the
+cast to each hit it finds, so the rest of the trees are searched only up to the nearest hit so far.
+
+Overlap tests do the same with a bounds query, then test spheres against spheres and boxes
+directly, and the rest with GJK.
+
+Every query takes a mask of the collision layers it's interested in, bodies in none of them are
+skipped before the exact test.
+
+The queries only read the scene, so a batch is split into ranges that run on their own threads.
+
+========================================================================================================
+*/
+
+static const int MAX_QUERY_THREADS = 64;
+static const int MIN_QUERIES_PER_THREAD = 32;	// fewer than this isn't worth starting a thread for
+
+/*
+====================================================
+hitCollector_t
+Keeps the hits a cast reports, according to the query mode
+====================================================
+*/
+struct hitCollector_t {
+	queryMode_t mode;
+	queryHit_t * hits;
+	int maxHits;
+	int numHits;
+
+	// Returns false once the cast can stop, and lowers maxFraction when hits further away aren't wanted
+	bool Add( const queryHit_t & hit, float & maxFraction ) {
+		if ( maxHits <= 0 ) {
+			return false;
+		}
+
+		if ( QUERY_CLOSEST == mode ) {
+			hits[ 0 ] = hit;
+			numHits = 1;
+			maxFraction = hit.fraction;
+			return true;
+		}
+
+		if ( QUERY_ANY == mode ) {
+			hits[ 0 ] = hit;
+			numHits = 1;
+			return false;
+		}
+
+		// Insertion sort, nearest first.  When full the furthest hit drops off the end.
+		int idx;
+		if ( numHits < maxHits ) {
+			idx = numHits++;
+		} else if ( hit.fraction < hits[ maxHits - 1 ].fraction ) {
+			idx = maxHits - 1;
+		} else {
+			return true;
+		}
+		while ( idx > 0 && hits[ idx - 1 ].fraction > hit.fraction ) {
+			hits[ idx ] = hits[ idx - 1 ];
+			idx--;
+		}
+		hits[ idx ] = hit;
+		if ( numHits == maxHits ) {
+			maxFraction = hits[ maxHits - 1 ].fraction;
+		}
+		return true;
+	}
+};
+
+/*
+====================================================
+ParallelFor
+Calls func( first, end ) over ranges that cover [ 0, num ), on up to numThreads threads.
+The calling thread takes the first range.
+====================================================
+*/
+template< typename func_t >
+static void ParallelFor( const int num, int numThreads, const func_t & func ) {
+	if ( numThreads <= 0 ) {
+		numThreads = (int)std::thread::hardware_concurrency();
+	}
+	numThreads = std::min( numThreads, ( num + MIN_QUERIES_PER_THREAD - 1 ) / MIN_QUERIES_PER_THREAD );
+	numThreads = std::min( numThreads, MAX_QUERY_THREADS );
+	if ( numThreads <= 1 ) {
+		func( 0, num );
+		return;
+	}
+
+	std::thread threads[ MAX_QUERY_THREADS ];
+	for ( int i = 1; i < numThreads; i++ ) {
+		const int first = (int)( (long long)num * i / numThreads );
+		const int end = (int)( (long long)num * ( i + 1 ) / numThreads );
+		threads[ i ] = std::thread( [ &func, first, end ]() {
+			func( first, end );
+		} );
+	}
+
+	func( 0, (int)( (long long)num / numThreads ) );
+
+	for ( int i = 1; i < numThreads; i++ ) {
+		threads[ i ].join();
+	}
+}
+
+/*
+====================================================
+CastTrees
+Casts through each tree in turn, carrying the cast's length from one to the next so a hit in the
+first cuts the search of the rest short
+====================================================
+*/
+template< typename callback_t >
+static void CastTrees( const BoundsTree * const * trees, const int numTrees, const Bounds & bounds, const Vec3 & translation, callback_t & callback ) {
+	float maxFraction = 1.0f;
+	bool isStopped = false;
+	auto treeCallback = [ & ]( const int bodyIdx, float & fraction ) {
+		isStopped = !callback( bodyIdx, fraction );
+		maxFraction = fraction;
+		return !isStopped;
+	};
+
+	for ( int i = 0; i < numTrees && !isStopped; i++ ) {
+		trees[ i ]->CastBounds( bounds, translation, maxFraction, treeCallback );
+	}
+}
+
+/*
+====================================================
+Scene::UpdateQueryTree
+====================================================
+*/
+void Scene::UpdateQueryTree() const {
+	PROFILE_SCOPE( "UpdateQueryTree" );
+
+	const int num = (int)m_bodies.size();
+	m_isQueryingStaticTree = !m_broadphase.HasStaticChanged( m_bodies.data(), num );
+
+	m_queryBounds.clear();
+	m_queryIds.clear();
+	for ( int i = 0; i < num; i++ ) {
+		const Body & body = m_bodies[ i ];
+		if ( m_isQueryingStaticTree && Broadphase::IsStatic( body ) ) {
+			continue;
+		}
+		m_queryBounds.push_back( body.m_shape->GetBounds( body.m_position, body.m_orientation ) );
+		m_queryIds.push_back( i );
+	}
+	m_queryTree.Build( m_queryBounds.data(), (int)m_queryBounds.size(), m_queryIds.data() );
+	m_queryTreeStep = m_numSteps;
+	m_queryTreeNumBodies = num;
+}
+
+/*
+====================================================
+Scene::PrepareQueries
+====================================================
+*/
+void Scene::PrepareQueries() const {
+	if ( m_queryTreeStep != m_numSteps || m_queryTreeNumBodies != (int)m_bodies.size() ) {
+		UpdateQueryTree();
+	}
+}
+
+/*
+====================================================
+Scene::GetQueryTrees
+The trees the queries search, the static one first since the world is usually what casts hit
+====================================================
+*/
+int Scene::GetQueryTrees( const BoundsTree ** trees ) const {
+	int numTrees = 0;
+	if ( m_isQueryingStaticTree ) {
+		trees[ numTrees++ ] = &m_broadphase.GetStaticTree();
+	}
+	trees[ numTrees++ ] = &m_queryTree;
+	return numTrees;
+}
+
+/*
+====================================================
+Scene::CastRay
+====================================================
+*/
+int Scene::CastRay( const rayCast_t & ray, const queryMode_t mode, queryHit_t * hits, const int maxHits, const unsigned int layerMask ) const {
+	PrepareQueries();
+
+	hitCollector_t collector = { mode, hits, maxHits, 0 };
+	auto callback = [ & ]( const int bodyIdx, float & maxFraction ) {
+		if ( 0 == ( m_bodies[ bodyIdx ].m_collisionLayer & layerMask ) ) {
+			return true;
+		}
+		queryHit_t hit;
+		if ( !RayCast( &m_bodies[ bodyIdx ], ray.start, ray.end, maxFraction, hit ) ) {
+			return true;
+		}
+		hit.body = bodyIdx;
+		return collector.Add( hit, maxFraction );
+	};
+
+	const BoundsTree * trees[ 2 ];
+	const int numTrees = GetQueryTrees( trees );
+
+	Bounds bounds;
+	bounds.Expand( ray.start );
+	CastTrees( trees, numTrees, bounds, ray.end - ray.start, callback );
+	return collector.numHits;
+}
+
+/*
+====================================================
+Scene::CastShape
+====================================================
+*/
+int Scene::CastShape( const shapeCast_t & cast, const queryMode_t mode, queryHit_t * hits, const int maxHits, const unsigned int layerMask ) const {
+	PrepareQueries();
+
+	hitCollector_t collector = { mode, hits, maxHits, 0 };
+	auto callback = [ & ]( const int bodyIdx, float & maxFraction ) {
+		if ( 0 == ( m_bodies[ bodyIdx ].m_collisionLayer & layerMask ) ) {
+			return true;
+		}
+		queryHit_t hit;
+		if ( !ShapeCast( &m_bodies[ bodyIdx ], cast, maxFraction, hit ) ) {
+			return true;
+		}
+		hit.body = bodyIdx;
+		return collector.Add( hit, maxFraction );
+	};
+
+	const BoundsTree * trees[ 2 ];
+	const int numTrees = GetQueryTrees( trees );
+
+	const Bounds bounds = cast.shape->GetBounds( cast.start, cast.orientation );
+	CastTrees( trees, numTrees, bounds, cast.end - cast.start, callback );
+	return collector.numHits;
+}
+
+/*
+====================================================
+Scene::CastRays
+====================================================
+*/
+void Scene::CastRays( const rayCast_t * rays, const int num, const queryMode_t mode, queryHit_t * hits, const int maxHits, int * numHits, const unsigned int layerMask ) const {
+	PROFILE_SCOPE( "CastRays" );
+
+	// Build the tree before the threads share it
+	PrepareQueries();
+
+	ParallelFor( num, m_numQueryThreads, [ & ]( const int first, const int end ) {
+		for ( int i = first; i < end; i++ ) {
+			numHits[ i ] = CastRay( rays[ i ], mode, hits + i * maxHits, maxHits, layerMask );
+		}
+	} );
+}
+
+/*
+====================================================
+Scene::CastShapes
+====================================================
+*/
+void Scene::CastShapes( const shapeCast_t * casts, const int num, const queryMode_t mode, queryHit_t * hits, const int maxHits, int * numHits, const unsigned int layerMask ) const {
+	PROFILE_SCOPE( "CastShapes" );
+
+	PrepareQueries();
+
+	ParallelFor( num, m_numQueryThreads, [ & ]( const int first, const int end ) {
+		for ( int i = first; i < end; i++ ) {
+			numHits[ i ] = CastShape( casts[ i ], mode, hits + i * maxHits, maxHits, layerMask );
+		}
+	} );
+}
+
+/*
+====================================================
+Scene::OverlapShape
+====================================================
+*/
+int Scene::OverlapShape( const Shape * shape, const Vec3 & pos, const Quat & orient, int * bodies, const int maxBodies, const unsigned int layerMask ) const {
+	PrepareQueries();
+
+	int numBodies = 0;
+	auto callback = [ & ]( const int bodyIdx ) {
+		if ( 0 == ( m_bodies[ bodyIdx ].m_collisionLayer & layerMask ) ) {
+			return true;
+		}
+		if ( !Overlap( &m_bodies[ bodyIdx ], shape, pos, orient ) ) {
+			return true;
+		}
+		bodies[ numBodies++ ] = bodyIdx;
+		return numBodies < maxBodies;
+	};
+
+	const BoundsTree * trees[ 2 ];
+	const int numTrees = GetQueryTrees( trees );
+
+	const Bounds bounds = shape->GetBounds( pos, orient );
+	for ( int i = 0; i < numTrees && numBodies < maxBodies; i++ ) {
+		trees[ i ]->QueryBounds( bounds, callback );
+	}
+	return numBodies;
+}
+
+/*
+====================================================
+Scene::OverlapSphere
+====================================================
+*/
+int Scene::OverlapSphere( const Vec3 & center, const float radius, int * bodies, const int maxBodies, const unsigned int layerMask ) const {
+	const ShapeSphere sphere( radius );
+	return OverlapShape( &sphere, center, Quat( 0, 0, 0, 1 ), bodies, maxBodies, layerMask );
+}
+
+/*
+====================================================
+Scene::OverlapBounds
+====================================================
+*/
+int Scene::OverlapBounds( const Bounds & bounds, int * bodies, const int maxBodies, const unsigned int layerMask ) const {
+	const Vec3 corners[ 2 ] = { bounds.mins, bounds.maxs };
+	const ShapeBox box( corners, 2 );
+	return OverlapShape( &box, Vec3( 0.0f ), Quat( 0, 0, 0, 1 ), bodies, maxBodies, layerMask );
+}
@@ -0,0 +1,154 @@
+//
+//  SceneSnapshot.cpp
+//
+#include "Scene.h"
+#include <stdio.h>
+
+/*
+========================================================================================================
+
+Scene snapshots
+
+The snapshot is a flat buffer laid out as
+
+	snapshotHeader_t
+	numBodies x bodyState_t
+	numConstraintFloats x float		( Constraint::SaveState for every constraint, in order )
+	numManifolds x manifoldState_t
+
+Only the dynamic state is stored.  Shapes, masses and constraint set up are expected to be the
+same when the snapshot is restored, so that it is cheap enough to take every frame.
+
+========================================================================================================
+*/
+
+struct snapshotHeader_t {
+	int numBodies;
+	int numConstraintFloats;
+	int numManifolds;
+};
+
+struct bodyState_t {
+	Vec3 position;
+	Quat orientation;
+	Vec3 linearVelocity;
+	Vec3 angularVelocity;
+};
+
+/*
+====================================================
+GetNumConstraintFloats
+====================================================
+*/
+static int GetNumConstraintFloats( const ConstraintPool & constraints ) {
+	int num = 0;
+	for ( int i = 0; i < constraints.size(); i++ ) {
+		num += constraints[ i ]->GetStateSize();
+	}
+	return num;
+}
+
+/*
+====================================================
+Scene::GetSnapshotSize
+Size in bytes of a buffer that can hold a snapshot with up to maxManifolds manifolds
+====================================================
+*/
+int Scene::GetSnapshotSize( const int maxManifolds ) const {
+	int size = sizeof( snapshotHeader_t );
+	size += sizeof( bodyState_t ) * (int)m_bodies.size();
+	size += sizeof( float ) * GetNumConstraintFloats( m_constraints );
+	size += sizeof( manifoldState_t ) * maxManifolds;
+	return size;
+}
+
+/*
+====================================================
+Scene::SaveSnapshot
+Returns the number of bytes written, or zero if the buffer is too small
+====================================================
+*/
+int Scene::SaveSnapshot( void * buffer, const int size ) const {
+	const int numManifolds = (int)m_manifolds.m_manifolds.size();
+	const int requiredSize = GetSnapshotSize( numManifolds );
+	if ( requiredSize > size ) {
+		printf( "ERROR: snapshot buffer too small (%i bytes, %i needed)\n", size, requiredSize );
+		return 0;
+	}
+
+	unsigned char * ptr = (unsigned char *)buffer;
+
+	snapshotHeader_t * header = (snapshotHeader_t *)ptr;
+	header->numBodies = (int)m_bodies.size();
+	header->numConstraintFloats = GetNumConstraintFloats( m_constraints );
+	header->numManifolds = numManifolds;
+	ptr += sizeof( snapshotHeader_t );
+
+	bodyState_t * bodyStates = (bodyState_t *)ptr;
+	for ( int i = 0; i < m_bodies.size(); i++ ) {
+		const Body & body = m_bodies[ i ];
+		bodyStates[ i ].position = body.m_position;
+		bodyStates[ i ].orientation = body.m_orientation;
+		bodyStates[ i ].linearVelocity = body.m_linearVelocity;
+		bodyStates[ i ].angularVelocity = body.m_angularVelocity;
+	}
+	ptr += sizeof( bodyState_t ) * m_bodies.size();
+
+	float * constraintState = (float *)ptr;
+	for ( int i = 0; i < m_constraints.size(); i++ ) {
+		m_constraints[ i ]->SaveState( constraintState );
+		constraintState += m_constraints[ i ]->GetStateSize();
+	}
+	ptr += sizeof( float ) * header->numConstraintFloats;
+
+	m_manifolds.SaveState( (manifoldState_t *)ptr, m_bodies.data() );
+	ptr += sizeof( manifoldState_t ) * numManifolds;
+
+	return (int)( ptr - (unsigned char *)buffer );
+}
+
+/*
+====================================================
+Scene::RestoreSnapshot
+The scene must have the same bodies and constraints as when the snapshot was taken
+====================================================
+*/
+bool Scene::RestoreSnapshot( const void * buffer, const int size ) {
+	const unsigned char * ptr = (const unsigned char *)buffer;
+	if ( size < sizeof( snapshotHeader_t ) ) {
+		printf( "ERROR: snapshot is too small\n" );
+		return false;
+	}
+
+	const snapshotHeader_t * header = (const snapshotHeader_t *)ptr;
+	if ( header->numBodies != (int)m_bodies.size() || header->numConstraintFloats != GetNumConstraintFloats( m_constraints ) ) {
+		printf( "ERROR: snapshot does not match the scene\n" );
+		return false;
+	}
+	if ( size < GetSnapshotSize( header->numManifolds ) ) {
+		printf( "ERROR: snapshot is truncated\n" );
+		return false;
+	}
+	ptr += sizeof( snapshotHeader_t );
+
+	const bodyState_t * bodyStates = (const bodyState_t *)ptr;
+	for ( int i = 0; i < m_bodies.size(); i++ ) {
+		Body & body = m_bodies[ i ];
+		body.m_position = bodyStates[ i ].position;
+		body.m_orientation = bodyStates[ i ].orientation;
+		body.m_linearVelocity = bodyStates[ i ].linearVelocity;
+		body.m_angularVelocity = bodyStates[ i ].angularVelocity;
+	}
+	ptr += sizeof( bodyState_t ) * m_bodies.size();
+
+	const float * constraintState = (const float *)ptr;
+	for ( int i = 0; i < m_constraints.size(); i++ ) {
+		m_constraints[ i ]->RestoreState( constraintState );
+		constraintState += m_constraints[ i ]->GetStateSize();
+	}
+	ptr += sizeof( float ) * header->numConstraintFloats;
+
+	m_manifolds.RestoreState( (const manifoldState_t *)ptr, header->numManifolds, m_bodies.data() );
+	m_queryTreeStep = -1;	// the bodies moved
+	return true;
+}
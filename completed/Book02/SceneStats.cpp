@@ -0,0 +1,97 @@
+//
+//  SceneStats.cpp
+//
+#include "Scene.h"
+#include <stdio.h>
+
+/*
+========================================================================================================
+
+Scene stats
+
+Scene::Update clears m_stepStats at the start of the step, the update, the solver (through the
+solver context) and the collision routines (through g_collisionStats) add to it as they go, and
+RecordStats copies the result into a ring buffer of the last STATS_HISTORY_SIZE steps.
+
+========================================================================================================
+*/
+
+/*
+====================================================
+Scene::RecordStats
+====================================================
+*/
+void Scene::RecordStats() {
+	m_stepStats.step = m_numSteps;
+	m_stepStats.numBodies = (int)m_bodies.size();
+	m_stepStats.numConstraints = (int)m_constraints.size();
+	m_stepStats.numManifolds = (int)m_manifolds.m_manifolds.size();
+	for ( int i = 0; i < m_manifolds.m_manifolds.size(); i++ ) {
+		m_stepStats.numManifoldContacts += m_manifolds.m_manifolds[ i ].GetNumContacts();
+	}
+
+	m_stats = m_stepStats;
+	m_statsHistory[ m_numSteps % STATS_HISTORY_SIZE ] = m_stats;
+	m_numSteps++;
+}
+
+/*
+====================================================
+Scene::GetStatsHistory
+====================================================
+*/
+int Scene::GetStatsHistory( physicsStats_t * stats, const int maxSteps ) const {
+	int num = ( m_numSteps < STATS_HISTORY_SIZE ) ? m_numSteps : STATS_HISTORY_SIZE;
+	if ( num > maxSteps ) {
+		num = maxSteps;
+	}
+
+	const int first = m_numSteps - num;
+	for ( int i = 0; i < num; i++ ) {
+		stats[ i ] = m_statsHistory[ ( first + i ) % STATS_HISTORY_SIZE ];
+	}
+	return num;
+}
+
+/*
+====================================================
+PrintHistogram
+====================================================
+*/
+static void PrintHistogram( FILE * file, const char * name, const int count, const int * histogram ) {
+	fprintf( file, " %s %i [", name, count );
+	for ( int i = 0; i < physicsStats_t::NUM_HISTOGRAM_BUCKETS; i++ ) {
+		fprintf( file, i > 0 ? " %i" : "%i", histogram[ i ] );
+	}
+	fprintf( file, "]" );
+}
+
+/*
+====================================================
+Scene::DumpStats
+====================================================
+*/
+void Scene::DumpStats( FILE * file, const int maxSteps ) const {
+	int num = ( m_numSteps < STATS_HISTORY_SIZE ) ? m_numSteps : STATS_HISTORY_SIZE;
+	if ( num > maxSteps ) {
+		num = maxSteps;
+	}
+
+	const int first = m_numSteps - num;
+	for ( int s = 0; s < num; s++ ) {
+		const physicsStats_t & stats = m_statsHistory[ ( first + s ) % STATS_HISTORY_SIZE ];
+		fprintf( file, "step %i: bodies %i constraints %i broken %i pairs %i rejected %i tested %i hit %i static %i ballistic %i manifolds %i contacts %i fallbacks %i",
+			stats.step, stats.numBodies, stats.numConstraints, stats.numBrokenConstraints,
+			stats.numPairs, stats.numPairsRejected, stats.numPairsTested, stats.numPairsHit, stats.numStaticContacts, stats.numBallisticContacts,
+			stats.numManifolds, stats.numManifoldContacts, stats.numBlockFallbacks );
+		PrintHistogram( file, "gjk", stats.numGJK, stats.gjkIterations );
+		PrintHistogram( file, "epa", stats.numEPA, stats.epaIterations );
+		PrintHistogram( file, "advance", stats.numConservativeAdvance, stats.conservativeAdvanceIterations );
+		fprintf( file, " islands %i iterations %i max %i position %i", stats.numIslands, stats.numIslandIterations, stats.maxIslandIterations, stats.numPositionIterations );
+		fprintf( file, " residual [" );
+		for ( int i = 0; i < stats.numSolverIterations; i++ ) {
+			fprintf( file, i > 0 ? " %g" : "%g", stats.solverResidual[ i ] );
+		}
+		fprintf( file, "]\n" );
+	}
+}